@@ -65,6 +65,7 @@ static const uint8_t sbox[256] =   {
 0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16 };
 
 static uint8_t round_keys[11][AES_128_KEY_LENGTH];
+static uint8_t round_keys_set;
 
 /*---------------------------------------------------------------------------*/
 /* multiplies by 2 in GF(2) */
@@ -82,6 +83,11 @@ set_key(const uint8_t *key)
   uint8_t j;
   uint8_t rcon;
   
+  /* frames are usually secured with the same key over and over again */
+  if(round_keys_set && !memcmp(round_keys[0], key, AES_128_KEY_LENGTH)) {
+    return;
+  }
+
   rcon = 0x01;
   memcpy(round_keys[0], key, AES_128_KEY_LENGTH);
   for(i = 1; i <= 10; i++) {
@@ -94,6 +100,7 @@ set_key(const uint8_t *key)
     }
     rcon = galois_mul2(rcon);
   }
+  round_keys_set = 1;
 }
 /*---------------------------------------------------------------------------*/
 static void
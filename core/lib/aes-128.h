@@ -73,5 +73,6 @@ struct aes_128_driver {
 void aes_128_set_padded_key(uint8_t *key, uint8_t key_len);
 
 extern const struct aes_128_driver AES_128;
+extern const struct aes_128_driver aes_128_ttable_driver;
 
 #endif /* AES_128_H_ */
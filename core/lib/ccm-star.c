@@ -59,33 +59,14 @@ set_iv(uint8_t *iv,
   iv[15] = counter;
 }
 /*---------------------------------------------------------------------------*/
-/* XORs the block m[pos] ... m[pos + 15] with K_{counter} */
+/* Computes X_1 ... X_n over B_0 and the additional authenticated data */
 static void
-ctr_step(const uint8_t *nonce,
-    uint8_t pos,
-    uint8_t *m_and_result,
+mic_init(const uint8_t *nonce,
     uint8_t m_len,
-    uint8_t counter)
-{
-  uint8_t a[AES_128_BLOCK_SIZE];
-  uint8_t i;
-  
-  set_iv(a, CCM_STAR_ENCRYPTION_FLAGS, nonce, counter);
-  AES_128.encrypt(a);
-  
-  for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
-    m_and_result[pos + i] ^= a[i];
-  }
-}
-/*---------------------------------------------------------------------------*/
-static void
-mic(const uint8_t *nonce,
-    const uint8_t *m, uint8_t m_len,
     const uint8_t *a, uint8_t a_len,
-    uint8_t *result,
+    uint8_t *x,
     uint8_t mic_len)
 {
-  uint8_t x[AES_128_BLOCK_SIZE];
   uint8_t pos;
   uint8_t i;
   
@@ -109,35 +90,6 @@ mic(const uint8_t *nonce,
       AES_128.encrypt(x);
     }
   }
-  
-  if(m_len) {
-    pos = 0;
-    while(pos < m_len) {
-      for(i = 0; (pos + i < m_len) && (i < AES_128_BLOCK_SIZE); i++) {
-        x[i] ^= m[pos + i];
-      }
-      pos += AES_128_BLOCK_SIZE;
-      AES_128.encrypt(x);
-    }
-  }
-  
-  ctr_step(nonce, 0, x, AES_128_BLOCK_SIZE, 0);
-  
-  memcpy(result, x, mic_len);
-}
-/*---------------------------------------------------------------------------*/
-static void
-ctr(const uint8_t *nonce, uint8_t *m, uint8_t m_len)
-{
-  uint8_t pos;
-  uint8_t counter;
-  
-  pos = 0;
-  counter = 1;
-  while(pos < m_len) {
-    ctr_step(nonce, pos, m, m_len, counter++);
-    pos += AES_128_BLOCK_SIZE;
-  }
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -146,6 +98,12 @@ set_key(const uint8_t *key)
   AES_128.set_key(key);
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * CBC-MAC and CTR mode are done in a single pass over m. The CBC-MAC
+ * state X_i is encrypted lazily, after the next counter block A_i, so
+ * that the last X_i and A_0 are encrypted in the same iteration, which
+ * yields S_0 for encrypting the MIC.
+ */
 static void
 aead(const uint8_t* nonce,
     uint8_t* m, uint8_t m_len,
@@ -153,20 +111,49 @@ aead(const uint8_t* nonce,
     uint8_t *result, uint8_t mic_len,
     int forward)
 {
-  if(!forward) {
-    /* decrypt */
-    ctr(nonce, m, m_len);
-  }
+  uint8_t x[AES_128_BLOCK_SIZE];
+  uint8_t s[AES_128_BLOCK_SIZE];
+  uint8_t pos;
+  uint8_t counter;
+  uint8_t pending;
+  uint8_t plaintext;
+  uint8_t i;
   
-  mic(nonce,
-    m, m_len,
-    a, a_len,
-    result,
-    mic_len);
+  mic_init(nonce, m_len, a, a_len, x, mic_len);
+  
+  pos = 0;
+  counter = 1;
+  pending = 0;
+  do {
+    if(pos < m_len) {
+      set_iv(s, CCM_STAR_ENCRYPTION_FLAGS, nonce, counter++);
+    } else {
+      set_iv(s, CCM_STAR_ENCRYPTION_FLAGS, nonce, 0);
+    }
+    AES_128.encrypt(s);
+    if(pending) {
+      AES_128.encrypt(x);
+    }
+    
+    if(pos >= m_len) {
+      break;
+    }
+    
+    for(i = 0; (pos < m_len) && (i < AES_128_BLOCK_SIZE); i++, pos++) {
+      if(forward) {
+        plaintext = m[pos];
+        m[pos] ^= s[i];
+      } else {
+        m[pos] ^= s[i];
+        plaintext = m[pos];
+      }
+      x[i] ^= plaintext;
+    }
+    pending = 1;
+  } while(1);
   
-  if(forward) {
-    /* encrypt */
-    ctr(nonce, m, m_len);
+  for(i = 0; i < mic_len; i++) {
+    result[i] = x[i] ^ s[i];
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -55,9 +55,25 @@
 #define MMEM_SIZE 4096
 #endif
 
+/* With MMEM_CONF_ALIGNMENT, a power of two, block sizes are rounded
+   up to a multiple of it. As the memory itself is aligned, every block
+   is then aligned as well, as needed by users that store structures
+   in managed memory. By default sizes are kept as requested. */
+#ifdef MMEM_CONF_ALIGNMENT
+#define MMEM_ALIGNMENT MMEM_CONF_ALIGNMENT
+#else
+#define MMEM_ALIGNMENT 1
+#endif
+#define MMEM_ALIGN(size) \
+  (((size) + MMEM_ALIGNMENT - 1) & ~(MMEM_ALIGNMENT - 1))
+
 LIST(mmemlist);
 unsigned int avail_memory;
-static char memory[MMEM_SIZE];
+static union {
+  long align;
+  char bytes[MMEM_SIZE];
+} aligned_memory;
+#define memory aligned_memory.bytes
 
 /*---------------------------------------------------------------------------*/
 /**
@@ -82,6 +98,8 @@ static char memory[MMEM_SIZE];
 int
 mmem_alloc(struct mmem *m, unsigned int size)
 {
+  size = MMEM_ALIGN(size);
+
   /* Check if we have enough memory left for this allocation. */
   if(avail_memory < size) {
     return 0;
@@ -139,6 +157,49 @@ mmem_free(struct mmem *m)
   list_remove(mmemlist, m);
 }
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief      Change the size of a managed memory block
+ * \param m    A pointer to the managed memory block
+ * \param size The new size of the memory block
+ * \return     Non-zero if the block could be resized, zero if memory
+ *             was not available.
+ *
+ *             This function grows or shrinks a memory block that
+ *             previously has been allocated with mmem_alloc(). The
+ *             contents of the block are kept up to the lesser of the
+ *             old and the new size. Like mmem_free(), this moves the
+ *             memory blocks that follow the resized block.
+ *
+ */
+int
+mmem_realloc(struct mmem *m, unsigned int size)
+{
+  struct mmem *n;
+  int diff;
+
+  size = MMEM_ALIGN(size);
+  diff = (int)size - (int)m->size;
+
+  if(diff > 0 && avail_memory < (unsigned int)diff) {
+    return 0;
+  }
+
+  if(m->next != NULL && diff != 0) {
+    /* Move the memory after the resized block up or down. */
+    memmove((char *)m->next->ptr + diff, m->next->ptr,
+            &memory[MMEM_SIZE - avail_memory] - (char *)m->next->ptr);
+
+    for(n = m->next; n != NULL; n = n->next) {
+      n->ptr = (void *)((char *)n->ptr + diff);
+    }
+  }
+
+  m->size = size;
+  avail_memory -= diff;
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 /**
  * \brief      Initialize the managed memory module
  * \author     Adam Dunkels
@@ -37,6 +37,7 @@
 #include "ip64-conf.h"
 
 #include "lib/random.h"
+#include "sys/ctimer.h"
 
 #include <string.h>
 
@@ -46,15 +47,49 @@
 #define NUM_ENTRIES 32
 #endif /* IP64_ADDRMAP_CONF_ENTRIES */
 
+/* Number of buckets in each of the two hash indexes. Must be a power of
+   two. */
+#ifdef IP64_ADDRMAP_CONF_HASH_SIZE
+#define HASH_SIZE IP64_ADDRMAP_CONF_HASH_SIZE
+#else /* IP64_ADDRMAP_CONF_HASH_SIZE */
+#define HASH_SIZE 16
+#endif /* IP64_ADDRMAP_CONF_HASH_SIZE */
+
+#if (HASH_SIZE & (HASH_SIZE - 1)) != 0
+#error IP64_ADDRMAP_CONF_HASH_SIZE must be a power of two
+#endif
+
+/* Mappings are aged by a timer wheel: every WHEEL_TICK, the entries in
+   one slot are checked. Entries that live longer than the wheel spans
+   are moved to a later slot when their slot comes up. */
+#define WHEEL_SLOTS 32
+#define WHEEL_TICK  CLOCK_SECOND
+
 MEMB(entrymemb, struct ip64_addrmap_entry, NUM_ENTRIES);
 LIST(entrylist);
 
+/* Lookup by (ip6addr, ip6port, ip4addr, ip4port, protocol) */
+static struct ip64_addrmap_entry *forward_hash[HASH_SIZE];
+/* Lookup by mapped port */
+static struct ip64_addrmap_entry *port_hash[HASH_SIZE];
+
+static struct ip64_addrmap_entry *wheel[WHEEL_SLOTS];
+static uint8_t wheel_pos;
+static struct ctimer wheel_timer;
+
 #define FIRST_MAPPED_PORT 10000
 #define LAST_MAPPED_PORT  20000
 static uint16_t mapped_port = FIRST_MAPPED_PORT;
 
-#define printf(...)
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
 
+static void wheel_tick(void *ptr);
 /*---------------------------------------------------------------------------*/
 struct ip64_addrmap_entry *
 ip64_addrmap_list(void)
@@ -67,25 +102,121 @@ ip64_addrmap_init(void)
 {
   memb_init(&entrymemb);
   list_init(entrylist);
+  memset(forward_hash, 0, sizeof(forward_hash));
+  memset(port_hash, 0, sizeof(port_hash));
+  memset(wheel, 0, sizeof(wheel));
+  wheel_pos = 0;
+  ctimer_stop(&wheel_timer);
   mapped_port = FIRST_MAPPED_PORT;
 }
 /*---------------------------------------------------------------------------*/
+static uint16_t
+forward_hash_index(const uip_ip6addr_t *ip6addr, uint16_t ip6port,
+                   const uip_ip4addr_t *ip4addr, uint16_t ip4port,
+                   uint8_t protocol)
+{
+  uint16_t h;
+
+  /* The interface identifier and the ports vary the most between
+     flows */
+  h = ip6addr->u16[6] ^ ip6addr->u16[7] ^
+    ip4addr->u16[0] ^ ip4addr->u16[1] ^
+    ip6port ^ (ip4port << 3) ^ protocol;
+  h ^= h >> 8;
+  h ^= h >> 4;
+  return h & (HASH_SIZE - 1);
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+port_hash_index(uint16_t port)
+{
+  return (port ^ (port >> 8)) & (HASH_SIZE - 1);
+}
+/*---------------------------------------------------------------------------*/
 static void
-check_age(void)
+wheel_insert(struct ip64_addrmap_entry *m)
 {
-  struct ip64_addrmap_entry *m;
+  clock_time_t ticks = 1;
+
+  if(!timer_expired(&m->timer)) {
+    ticks = (timer_remaining(&m->timer) + WHEEL_TICK - 1) / WHEEL_TICK;
+    if(ticks < 1) {
+      ticks = 1;
+    } else if(ticks > WHEEL_SLOTS - 1) {
+      ticks = WHEEL_SLOTS - 1;
+    }
+  }
+  m->wheel_slot = (wheel_pos + ticks) % WHEEL_SLOTS;
+  m->wheel_next = wheel[m->wheel_slot];
+  wheel[m->wheel_slot] = m;
+
+  if(ctimer_expired(&wheel_timer)) {
+    ctimer_set(&wheel_timer, WHEEL_TICK, wheel_tick, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_remove(struct ip64_addrmap_entry *m)
+{
+  struct ip64_addrmap_entry **p;
 
-  /* Walk through the list of address mappings, throw away the ones
-     that are too old. */
-  m = list_head(entrylist);
+  for(p = &wheel[m->wheel_slot]; *p != NULL; p = &(*p)->wheel_next) {
+    if(*p == m) {
+      *p = m->wheel_next;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_entry(struct ip64_addrmap_entry *m)
+{
+  struct ip64_addrmap_entry **p;
+
+  for(p = &forward_hash[forward_hash_index(&m->ip6addr, m->ip6port,
+                                           &m->ip4addr, m->ip4port,
+                                           m->protocol)];
+      *p != NULL; p = &(*p)->hash_next) {
+    if(*p == m) {
+      *p = m->hash_next;
+      break;
+    }
+  }
+  for(p = &port_hash[port_hash_index(m->mapped_port)];
+      *p != NULL; p = &(*p)->port_next) {
+    if(*p == m) {
+      *p = m->port_next;
+      break;
+    }
+  }
+  wheel_remove(m);
+  list_remove(entrylist, m);
+  memb_free(&entrymemb, m);
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_tick(void *ptr)
+{
+  struct ip64_addrmap_entry *m, *next;
+
+  wheel_pos = (wheel_pos + 1) % WHEEL_SLOTS;
+
+  /* Detach the slot, then either free or reschedule its entries */
+  m = wheel[wheel_pos];
+  wheel[wheel_pos] = NULL;
   while(m != NULL) {
+    next = m->wheel_next;
     if(timer_expired(&m->timer)) {
-      list_remove(entrylist, m);
-      memb_free(&entrymemb, m);
-      m = list_head(entrylist);
+      PRINTF("ip64-addrmap: mapping for port %u expired\n", m->mapped_port);
+      remove_entry(m);
     } else {
-      m = list_item_next(m);
+      wheel_insert(m);
     }
+    m = next;
+  }
+
+  if(list_head(entrylist) != NULL) {
+    ctimer_set(&wheel_timer, WHEEL_TICK, wheel_tick, NULL);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -95,21 +226,17 @@ recycle(void)
   /* Find the oldest recyclable mapping and remove it. */
   struct ip64_addrmap_entry *m, *oldest;
 
-  /* Walk through the list of address mappings, throw away the ones
-     that are too old. */
-
   oldest = NULL;
   for(m = list_head(entrylist);
       m != NULL;
       m = list_item_next(m)) {
     if(m->flags & FLAGS_RECYCLABLE) {
-      if(oldest == NULL) {
+      if(oldest == NULL || timer_expired(&m->timer)) {
+        oldest = m;
+      } else if(!timer_expired(&oldest->timer) &&
+                timer_remaining(&m->timer) <
+                timer_remaining(&oldest->timer)) {
         oldest = m;
-      } else {
-        if(timer_remaining(&m->timer) <
-           timer_remaining(&oldest->timer)) {
-          oldest = m;
-        }
       }
     }
   }
@@ -117,8 +244,7 @@ recycle(void)
   /* If we found an oldest recyclable entry, remove it and return
      non-zero. */
   if(oldest != NULL) {
-    list_remove(entrylist, oldest);
-    memb_free(&entrymemb, oldest);
+    remove_entry(oldest);
     return 1;
   }
 
@@ -134,21 +260,19 @@ ip64_addrmap_lookup(const uip_ip6addr_t *ip6addr,
 {
   struct ip64_addrmap_entry *m;
 
-  printf("lookup ip4port %d ip6port %d\n", uip_htons(ip4port),
-	 uip_htons(ip6port));
-  check_age();
-  for(m = list_head(entrylist); m != NULL; m = list_item_next(m)) {
-    printf("protocol %d %d, ip4port %d %d, ip6port %d %d, ip4 %d ip6 %d\n",
-	   m->protocol, protocol,
-	   m->ip4port, ip4port,
-	   m->ip6port, ip6port,
-	   uip_ip4addr_cmp(&m->ip4addr, ip4addr),
-	   uip_ip6addr_cmp(&m->ip6addr, ip6addr));
+  for(m = forward_hash[forward_hash_index(ip6addr, ip6port,
+                                          ip4addr, ip4port, protocol)];
+      m != NULL; m = m->hash_next) {
     if(m->protocol == protocol &&
        m->ip4port == ip4port &&
        m->ip6port == ip6port &&
        uip_ip4addr_cmp(&m->ip4addr, ip4addr) &&
        uip_ip6addr_cmp(&m->ip6addr, ip6addr)) {
+      if(timer_expired(&m->timer)) {
+        /* Expired, but the wheel has not reached it yet */
+        remove_entry(m);
+        return NULL;
+      }
       m->ip6to4++;
       return m;
     }
@@ -161,13 +285,14 @@ ip64_addrmap_lookup_port(uint16_t mapped_port, uint8_t protocol)
 {
   struct ip64_addrmap_entry *m;
 
-  check_age();
-  for(m = list_head(entrylist); m != NULL; m = list_item_next(m)) {
-    printf("mapped port %d %d, protocol %d %d\n",
-	   m->mapped_port, mapped_port,
-	   m->protocol, protocol);
+  for(m = port_hash[port_hash_index(mapped_port)];
+      m != NULL; m = m->port_next) {
     if(m->mapped_port == mapped_port &&
        m->protocol == protocol) {
+      if(timer_expired(&m->timer)) {
+        remove_entry(m);
+        return NULL;
+      }
       m->ip4to6++;
       return m;
     }
@@ -175,6 +300,19 @@ ip64_addrmap_lookup_port(uint16_t mapped_port, uint8_t protocol)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+static int
+mapped_port_in_use(uint16_t port)
+{
+  struct ip64_addrmap_entry *m;
+
+  for(m = port_hash[port_hash_index(port)]; m != NULL; m = m->port_next) {
+    if(m->mapped_port == port) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 static void
 increase_mapped_port(void)
 {
@@ -190,8 +328,8 @@ ip64_addrmap_create(const uip_ip6addr_t *ip6addr,
 		    uint8_t protocol)
 {
   struct ip64_addrmap_entry *m;
+  uint16_t h;
 
-  check_age();
   m = memb_alloc(&entrymemb);
   if(m == NULL) {
     /* We could not allocate an entry, try to recycle one and try to
@@ -214,22 +352,23 @@ ip64_addrmap_create(const uip_ip6addr_t *ip6addr,
     /* Pick a new, unused local port. First make sure that the
        mapped_port number does not belong to any active connection. If
        so, we keep increasing the mapped_port until we're free. */
-    {
-      struct ip64_addrmap_entry *n;
-      n = list_head(entrylist);
-      while(n != NULL) {
-	if(n->mapped_port == mapped_port) {
-	  increase_mapped_port();
-	  n = list_head(entrylist);
-	} else {
-	  n = list_item_next(m);
-	}
-      }
+    while(mapped_port_in_use(mapped_port)) {
+      increase_mapped_port();
     }
     m->mapped_port = mapped_port;
     increase_mapped_port();
 
     list_add(entrylist, m);
+
+    h = forward_hash_index(ip6addr, ip6port, ip4addr, ip4port, protocol);
+    m->hash_next = forward_hash[h];
+    forward_hash[h] = m;
+
+    h = port_hash_index(m->mapped_port);
+    m->port_next = port_hash[h];
+    port_hash[h] = m;
+
+    wheel_insert(m);
     return m;
   }
   return NULL;
@@ -241,6 +380,13 @@ ip64_addrmap_set_lifetime(struct ip64_addrmap_entry *e,
 {
   if(e != NULL) {
     timer_set(&e->timer, time);
+    /* The lifetime is checked when the wheel reaches the slot of the
+       entry. If the entry now expires before that, move it. */
+    if((time + WHEEL_TICK - 1) / WHEEL_TICK <
+       (clock_time_t)((e->wheel_slot + WHEEL_SLOTS - wheel_pos) % WHEEL_SLOTS)) {
+      wheel_remove(e);
+      wheel_insert(e);
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -38,6 +38,9 @@
 
 struct ip64_addrmap_entry {
   struct ip64_addrmap_entry *next;
+  struct ip64_addrmap_entry *hash_next; /* forward lookup chain */
+  struct ip64_addrmap_entry *port_next; /* mapped port lookup chain */
+  struct ip64_addrmap_entry *wheel_next; /* aging timer wheel slot */
   struct timer timer;
   uip_ip6addr_t ip6addr;
   uip_ip4addr_t ip4addr;
@@ -47,6 +50,7 @@ struct ip64_addrmap_entry {
   uint16_t ip4port;
   uint8_t protocol;
   uint8_t flags;
+  uint8_t wheel_slot;
 };
 
 #define FLAGS_NONE       0
@@ -358,6 +358,32 @@ ipv6_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
+static uint16_t
+chksum_add(uint16_t sum, uint16_t val)
+{
+  sum += val;
+  if(sum < val) {
+    sum++;		/* carry */
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+/* Incrementally update a checksum field (in network byte order) for
+   header fields that were changed during translation. old_sum and
+   new_sum are the one's complement sums of the fields before and
+   after translation. This is eqn. 3 of RFC 1624: HC' = ~(~HC + ~m +
+   m'). */
+static uint16_t
+chksum_adjust(uint16_t chksum_field, uint16_t old_sum, uint16_t new_sum)
+{
+  uint16_t sum;
+
+  sum = ~uip_ntohs(chksum_field);
+  sum = chksum_add(sum, ~old_sum);
+  sum = chksum_add(sum, new_sum);
+  return uip_htons(~sum);
+}
+/*---------------------------------------------------------------------------*/
 int
 ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
 	  uint8_t *resultpacket)
@@ -369,6 +395,8 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
   struct icmpv4_hdr *icmpv4hdr;
   struct icmpv6_hdr *icmpv6hdr;
   uint16_t ipv6len, ipv4len;
+  uint16_t old_sum, new_sum;
+  uint8_t incremental;
   struct ip64_addrmap_entry *m;
 
   v6hdr = (struct ipv6_hdr *)ipv6packet;
@@ -392,6 +420,12 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
   icmpv4hdr = (struct icmpv4_hdr *)&resultpacket[IPV4_HDRLEN];
   icmpv6hdr = (struct icmpv6_hdr *)&ipv6packet[IPV6_HDRLEN];
 
+  /* Unless we validate checksums, the transport layer checksum is
+     adjusted for the changed fields rather than recomputed over the
+     whole packet. This is not possible if the payload is rewritten
+     (DNS64). */
+  incremental = !IP64_CHECKSUM_VALIDATE;
+
   /* Translate the IPv6 header into an IPv4 header. */
 
   /* First the basics: the IPv4 version, header length, type of
@@ -425,13 +459,16 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
     PRINTF("ip64_6to4: TCP header\n");
     v4hdr->proto = IP_PROTO_TCP;
 
+#if IP64_CHECKSUM_VALIDATE
     /* Compute and check the TCP checksum - since we're going to
        recompute it ourselves, we must ensure that it was correct in
        the first place. */
     if(ipv6_transport_checksum(ipv6packet, ipv6len,
                                IP_PROTO_TCP) != 0xffff) {
       PRINTF("Bad TCP checksum, dropping packet\n");
+      return 0;
     }
+#endif /* IP64_CHECKSUM_VALIDATE */
 
     break;
 
@@ -446,14 +483,18 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
                       ipv6len - IPV6_HDRLEN - sizeof(struct udp_hdr),
                       (uint8_t *)udphdr + sizeof(struct udp_hdr),
                       BUFSIZE - IPV4_HDRLEN - sizeof(struct udp_hdr));
+      incremental = 0;
     }
+#if IP64_CHECKSUM_VALIDATE
     /* Compute and check the UDP checksum - since we're going to
        recompute it ourselves, we must ensure that it was correct in
        the first place. */
     if(ipv6_transport_checksum(ipv6packet, ipv6len,
                                IP_PROTO_UDP) != 0xffff) {
       PRINTF("Bad UDP checksum, dropping packet\n");
+      return 0;
     }
+#endif /* IP64_CHECKSUM_VALIDATE */
     break;
 
   case IP_PROTO_ICMPV6:
@@ -612,18 +653,50 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
   v4hdr->ipchksum = 0;
   v4hdr->ipchksum = ~(ipv4_checksum(v4hdr));
 
-
+  /* For an incremental update, sum up the fields covered by the
+     transport checksum that differ between the packets: the
+     addresses of the pseudo header and the port numbers or the ICMP
+     type and code. The length and protocol fields of the pseudo
+     header are the same for TCP and UDP, but ICMPv4 has no pseudo
+     header at all. */
+  if(incremental) {
+    if(v4hdr->proto == IP_PROTO_ICMPV4) {
+      old_sum = chksum(ipv6len - IPV6_HDRLEN + IP_PROTO_ICMPV6,
+                       (uint8_t *)&v6hdr->srcipaddr,
+                       2 * sizeof(uip_ip6addr_t));
+      old_sum = chksum(old_sum, &ipv6packet[IPV6_HDRLEN], 2);
+      new_sum = chksum(0, &resultpacket[IPV4_HDRLEN], 2);
+    } else {
+      old_sum = chksum(0, (uint8_t *)&v6hdr->srcipaddr,
+                       2 * sizeof(uip_ip6addr_t));
+      old_sum = chksum(old_sum, &ipv6packet[IPV6_HDRLEN], 4);
+      new_sum = chksum(0, (uint8_t *)&v4hdr->srcipaddr,
+                       2 * sizeof(uip_ip4addr_t));
+      new_sum = chksum(new_sum, &resultpacket[IPV4_HDRLEN], 4);
+    }
+  }
 
   /* The checksum is in different places in the different protocol
      headers, so we need to be sure that we update the correct
      field. */
   switch(v4hdr->proto) {
   case IP_PROTO_TCP:
+    if(incremental) {
+      tcphdr->tcpchksum = chksum_adjust(tcphdr->tcpchksum, old_sum, new_sum);
+      break;
+    }
     tcphdr->tcpchksum = 0;
     tcphdr->tcpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
 						  IP_PROTO_TCP));
     break;
   case IP_PROTO_UDP:
+    if(incremental) {
+      udphdr->udpchksum = chksum_adjust(udphdr->udpchksum, old_sum, new_sum);
+      if(udphdr->udpchksum == 0) {
+        udphdr->udpchksum = 0xffff;
+      }
+      break;
+    }
     udphdr->udpchksum = 0;
     udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
 						  IP_PROTO_UDP));
@@ -632,6 +705,11 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
     }
     break;
   case IP_PROTO_ICMPV4:
+    if(incremental) {
+      icmpv4hdr->icmpchksum = chksum_adjust(icmpv4hdr->icmpchksum,
+                                            old_sum, new_sum);
+      break;
+    }
     icmpv4hdr->icmpchksum = 0;
     icmpv4hdr->icmpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
 						      IP_PROTO_ICMPV4));
@@ -658,6 +736,8 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
   struct icmpv4_hdr *icmpv4hdr;
   struct icmpv6_hdr *icmpv6hdr;
   uint16_t ipv4len, ipv6len, ipv6_packet_len;
+  uint16_t old_sum, new_sum;
+  uint8_t incremental;
   struct ip64_addrmap_entry *m;
 
   v6hdr = (struct ipv6_hdr *)resultpacket;
@@ -693,6 +773,22 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
   ipv6len = ipv4len - IPV4_HDRLEN + IPV6_HDRLEN;
   ipv6_packet_len = ipv6len - IPV6_HDRLEN;
 
+  /* As in ip64_6to4(), adjust the transport layer checksum
+     incrementally unless we validate checksums or the payload is
+     rewritten. */
+  incremental = !IP64_CHECKSUM_VALIDATE;
+
+#if IP64_CHECKSUM_VALIDATE
+  /* Check the transport layer checksum before we recompute it. A zero
+     UDP checksum means that the sender did not compute one. */
+  if((v4hdr->proto == IP_PROTO_TCP || v4hdr->proto == IP_PROTO_ICMPV4 ||
+      (v4hdr->proto == IP_PROTO_UDP && udphdr->udpchksum != 0)) &&
+     ipv4_transport_checksum(ipv4packet, ipv4len, v4hdr->proto) != 0xffff) {
+    PRINTF("ip64_4to6: bad transport checksum, dropping packet\n");
+    return 0;
+  }
+#endif /* IP64_CHECKSUM_VALIDATE */
+
   /* Translate the IPv4 header into an IPv6 header. */
 
   /* We first fill in the simple fields: IP header version, traffic
@@ -741,7 +837,12 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
       v6hdr->len[0] = ipv6_packet_len >> 8;
       v6hdr->len[1] = ipv6_packet_len & 0xff;
       ipv6len = ipv6_packet_len + IPV6_HDRLEN;
-
+      incremental = 0;
+    }
+    /* IPv4 UDP packets may lack a checksum, but it is mandatory in
+       IPv6, so we have to compute it from scratch. */
+    if(udphdr->udpchksum == 0) {
+      incremental = 0;
     }
     break;
 
@@ -849,17 +950,48 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
     }
   }
 
+  /* Sum up the fields that differ between the packets, see
+     ip64_6to4(). Here it is the ICMPv6 checksum that covers a pseudo
+     header. */
+  if(incremental) {
+    if(v6hdr->nxthdr == IP_PROTO_ICMPV6) {
+      old_sum = chksum(0, &ipv4packet[IPV4_HDRLEN], 2);
+      new_sum = chksum(ipv6_packet_len + IP_PROTO_ICMPV6,
+                       (uint8_t *)&v6hdr->srcipaddr,
+                       2 * sizeof(uip_ip6addr_t));
+      new_sum = chksum(new_sum, &resultpacket[IPV6_HDRLEN], 2);
+    } else {
+      old_sum = chksum(0, (uint8_t *)&v4hdr->srcipaddr,
+                       2 * sizeof(uip_ip4addr_t));
+      old_sum = chksum(old_sum, &ipv4packet[IPV4_HDRLEN], 4);
+      new_sum = chksum(0, (uint8_t *)&v6hdr->srcipaddr,
+                       2 * sizeof(uip_ip6addr_t));
+      new_sum = chksum(new_sum, &resultpacket[IPV6_HDRLEN], 4);
+    }
+  }
+
   /* The checksum is in different places in the different protocol
      headers, so we need to be sure that we update the correct
      field. */
   switch(v6hdr->nxthdr) {
   case IP_PROTO_TCP:
+    if(incremental) {
+      tcphdr->tcpchksum = chksum_adjust(tcphdr->tcpchksum, old_sum, new_sum);
+      break;
+    }
     tcphdr->tcpchksum = 0;
     tcphdr->tcpchksum = ~(ipv6_transport_checksum(resultpacket,
 						  ipv6len,
 						  IP_PROTO_TCP));
     break;
   case IP_PROTO_UDP:
+    if(incremental) {
+      udphdr->udpchksum = chksum_adjust(udphdr->udpchksum, old_sum, new_sum);
+      if(udphdr->udpchksum == 0) {
+        udphdr->udpchksum = 0xffff;
+      }
+      break;
+    }
     udphdr->udpchksum = 0;
     udphdr->udpchksum = ~(ipv6_transport_checksum(resultpacket,
 						  ipv6len,
@@ -870,6 +1002,11 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
     break;
 
   case IP_PROTO_ICMPV6:
+    if(incremental) {
+      icmpv6hdr->icmpchksum = chksum_adjust(icmpv6hdr->icmpchksum,
+                                            old_sum, new_sum);
+      break;
+    }
     icmpv6hdr->icmpchksum = 0;
     icmpv6hdr->icmpchksum = ~(ipv6_transport_checksum(resultpacket,
                                                 ipv6len,
@@ -84,5 +84,15 @@ extern uint16_t ip64_packet_buffer_maxlen;
 #define IP64_DHCP 1
 #endif /* IP64_CONF_DHCP */
 
+#ifdef IP64_CONF_CHECKSUM_VALIDATE
+#define IP64_CHECKSUM_VALIDATE IP64_CONF_CHECKSUM_VALIDATE
+#else /* IP64_CONF_CHECKSUM_VALIDATE */
+/* Per default, transport checksums are not validated but adjusted
+   incrementally (RFC 1624) to reflect the translated headers. With
+   validation enabled, packets with bad checksums are dropped and the
+   checksum of the translated packet is recomputed in full. */
+#define IP64_CHECKSUM_VALIDATE 0
+#endif /* IP64_CONF_CHECKSUM_VALIDATE */
+
 #endif /* IP64_H */
 
@@ -44,6 +44,7 @@
 #include "contiki-net.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/ipv6/multicast/uip-mcast6-route.h"
+#include "net/ipv6/multicast/uip-mcast6-dup.h"
 #include "net/ipv6/multicast/uip-mcast6-stats.h"
 #include "net/ipv6/multicast/esmrf.h"
 #include "net/rpl/rpl.h"
@@ -307,6 +308,13 @@ in()
   }
 
   UIP_MCAST6_STATS_ADD(mcast_in_all);
+
+  /* Our parent may send us the same datagram more than once */
+  if(uip_mcast6_dup_check()) {
+    PRINTF("ESMRF: Duplicate, dropped\n");
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    return UIP_MCAST6_DROP;
+  }
   UIP_MCAST6_STATS_ADD(mcast_in_unique);
 
   /* If we have an entry in the mcast routing table, something with
@@ -367,6 +375,7 @@ static void
 init()
 {
   UIP_MCAST6_STATS_INIT(NULL);
+  uip_mcast6_dup_init();
   uip_mcast6_route_init();
   /* Register the ICMPv6 input handler */
   uip_icmp6_register_input_handler(&esmrf_icmp_handler);
@@ -194,7 +194,11 @@ struct trickle_param {
 #define SEQ_VAL_ADD(s, n) (((s) + (n)) % 0x8000)
 /*---------------------------------------------------------------------------*/
 /* Sliding Windows */
+struct mcast_packet;
+
 struct sliding_window {
+  struct sliding_window *next;  /* Next window in the same hash bucket */
+  struct mcast_packet *head;    /* Buffered messages, ordered by seq. value */
   seed_id_t seed_id;
   int16_t lower_bound;          /* lolipop */
   int16_t upper_bound;          /* lolipop */
@@ -225,7 +229,6 @@ struct sliding_window {
  * w: pointer to a sliding window
  */
 #define SLIDING_WINDOW_IS_USED_CLR(w) ((w)->flags &= ~SLIDING_WINDOW_U_BIT)
-#define window_free(w) SLIDING_WINDOW_IS_USED_CLR(w)
 
 /**
  * \brief Set 'Is Seen' bit for window w
@@ -266,6 +269,7 @@ struct sliding_window {
 /*---------------------------------------------------------------------------*/
 /* Multicast Packet Buffers */
 struct mcast_packet {
+  struct mcast_packet *next;    /* Next in the window's list or the pool */
 #if ROLL_TM_SHORT_SEEDS
   /* Short seeds are stored inside the message */
   seed_id_t seed_id;
@@ -442,7 +446,9 @@ static struct roll_tm_stats stats;
 /*---------------------------------------------------------------------------*/
 static struct trickle_param t[2];
 static struct sliding_window windows[ROLL_TM_WINS];
+static struct sliding_window *win_hash[ROLL_TM_WIN_HASH];
 static struct mcast_packet buffered_msgs[ROLL_TM_BUFF_NUM];
+static struct mcast_packet *free_msgs;
 /*---------------------------------------------------------------------------*/
 /* Temporary Stores */
 /*---------------------------------------------------------------------------*/
@@ -470,7 +476,9 @@ extern uint16_t uip_slen;
 /*---------------------------------------------------------------------------*/
 static void icmp_input(void);
 static void icmp_output(void);
-static void window_update_bounds(void);
+static void window_free(struct sliding_window *);
+static void window_update_bounds(struct sliding_window *);
+static void buffer_release(struct mcast_packet *);
 static void reset_trickle_timer(uint8_t);
 static void handle_timer(void *);
 /*---------------------------------------------------------------------------*/
@@ -538,6 +546,7 @@ handle_timer(void *ptr)
   struct trickle_param *param;
   clock_time_t diff_last;       /* Time diff from last pass */
   clock_time_t diff_start;      /* Time diff from interval start */
+  struct mcast_packet **pp;
   uint8_t m;
 
   param = (struct trickle_param *)ptr;
@@ -572,12 +581,16 @@ handle_timer(void *ptr)
     ("ROLL TM: M=%u Periodic diff from last %lu, from start %lu\n", m,
      (unsigned long)diff_last, (unsigned long)diff_start);
 
-  /* Handle all buffered messages */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)
-       && (SLIDING_WINDOW_GET_M(locmpptr->sw) == m)) {
+  /* Handle all buffered messages of windows using this timer */
+  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
+      iterswptr--) {
+    if(!SLIDING_WINDOW_IS_USED(iterswptr) ||
+       SLIDING_WINDOW_GET_M(iterswptr) != m) {
+      continue;
+    }
 
+    pp = &iterswptr->head;
+    while((locmpptr = *pp) != NULL) {
       /*
        * if()
        * If the packet was received during the last interval, its reception
@@ -604,24 +617,20 @@ handle_timer(void *ptr)
                      TRICKLE_ACTIVE(param));
 
       if(locmpptr->dwell > TRICKLE_DWELL(param)) {
-        locmpptr->sw->count--;
+        iterswptr->count--;
         PRINTF("ROLL TM: M=%u Free Packet %u (%lu > %lu), Window now at %u\n",
                m, locmpptr->seq_val, locmpptr->dwell,
-               TRICKLE_DWELL(param), locmpptr->sw->count);
-        if(locmpptr->sw->count == 0) {
-          PRINTF("ROLL TM: M=%u Free Window ", m);
-          PRINT_SEED(&locmpptr->sw->seed_id);
-          PRINTF("\n");
-          window_free(locmpptr->sw);
-        }
-        MCAST_PACKET_FREE(locmpptr);
+               TRICKLE_DWELL(param), iterswptr->count);
+        *pp = locmpptr->next;
+        buffer_release(locmpptr);
+        continue;
       } else if(MCAST_PACKET_TTL(locmpptr) > 0) {
         /* Handle multicast transmissions */
         if(locmpptr->active < TRICKLE_ACTIVE(param) &&
            ((SUPPRESSION_ENABLED(param) && MCAST_PACKET_MUST_SEND(locmpptr)) ||
            SUPPRESSION_DISABLED(param))) {
           PRINTF("ROLL TM: M=%u Periodic - Sending packet from Seed ", m);
-          PRINT_SEED(&locmpptr->sw->seed_id);
+          PRINT_SEED(&iterswptr->seed_id);
           PRINTF(" seq %u\n", locmpptr->seq_val);
           uip_len = locmpptr->buff_len;
           memcpy(UIP_IP_BUF, &locmpptr->buff, uip_len);
@@ -632,6 +641,16 @@ handle_timer(void *ptr)
           watchdog_periodic();
         }
       }
+      pp = &locmpptr->next;
+    }
+
+    if(iterswptr->count == 0) {
+      PRINTF("ROLL TM: M=%u Free Window ", m);
+      PRINT_SEED(&iterswptr->seed_id);
+      PRINTF("\n");
+      window_free(iterswptr);
+    } else {
+      window_update_bounds(iterswptr);
     }
   }
 
@@ -646,8 +665,6 @@ handle_timer(void *ptr)
   param->inconsistency = 0;
   param->c = 0;
 
-  window_update_bounds();
-
   /* Temporarily store 'now' in t_next */
   param->t_next = clock_time();
   if(param->t_next >= param->t_end) {
@@ -682,12 +699,27 @@ reset_trickle_timer(uint8_t index)
   ctimer_set(&t[index].ct, t[index].t_next, handle_timer, (void *)&t[index]);
 }
 /*---------------------------------------------------------------------------*/
+static uint8_t
+window_hash(seed_id_t *s, uint8_t m)
+{
+  uint8_t *b = (uint8_t *)s;
+  uint8_t h = m;
+  uint8_t i;
+
+  for(i = 0; i < sizeof(seed_id_t); i++) {
+    h = ((h << 3) | (h >> 5)) ^ b[i];
+  }
+  return h & (ROLL_TM_WIN_HASH - 1);
+}
+/*---------------------------------------------------------------------------*/
 static struct sliding_window *
 window_allocate()
 {
   for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
       iterswptr--) {
     if(!SLIDING_WINDOW_IS_USED(iterswptr)) {
+      iterswptr->next = NULL;
+      iterswptr->head = NULL;
       iterswptr->count = 0;
       iterswptr->lower_bound = -1;
       iterswptr->upper_bound = -1;
@@ -698,11 +730,36 @@ window_allocate()
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Make window w reachable by window_lookup(). Seed ID and M must be set */
+static void
+window_insert(struct sliding_window *w)
+{
+  uint8_t h = window_hash(&w->seed_id, SLIDING_WINDOW_GET_M(w));
+
+  w->next = win_hash[h];
+  win_hash[h] = w;
+}
+/*---------------------------------------------------------------------------*/
+static void
+window_free(struct sliding_window *w)
+{
+  struct sliding_window **wp;
+
+  wp = &win_hash[window_hash(&w->seed_id, SLIDING_WINDOW_GET_M(w))];
+  for(; *wp != NULL; wp = &(*wp)->next) {
+    if(*wp == w) {
+      *wp = w->next;
+      break;
+    }
+  }
+  SLIDING_WINDOW_IS_USED_CLR(w);
+}
+/*---------------------------------------------------------------------------*/
 static struct sliding_window *
 window_lookup(seed_id_t *s, uint8_t m)
 {
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
+  for(iterswptr = win_hash[window_hash(s, m)]; iterswptr != NULL;
+      iterswptr = iterswptr->next) {
     VERBOSE_PRINTF("ROLL TM: M=%u (%u) ", SLIDING_WINDOW_GET_M(iterswptr), m);
     VERBOSE_PRINT_SEED(&iterswptr->seed_id);
     VERBOSE_PRINTF("\n");
@@ -714,85 +771,112 @@ window_lookup(seed_id_t *s, uint8_t m)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * A window's messages are kept ordered by sequence value, so its lower bound
+ * is always the head of the list. The upper bound only ever moves forward and
+ * is maintained as messages get accepted
+ */
 static void
-window_update_bounds()
+window_update_bounds(struct sliding_window *w)
 {
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
-    iterswptr->lower_bound = -1;
+  w->lower_bound = w->head != NULL ? w->head->seq_val : -1;
+}
+/*---------------------------------------------------------------------------*/
+/* Find the buffered message with sequence value seq in window w */
+static struct mcast_packet *
+window_find_seq(struct sliding_window *w, uint16_t seq)
+{
+  for(locmpptr = w->head; locmpptr != NULL; locmpptr = locmpptr->next) {
+    if(SEQ_VAL_IS_EQ(locmpptr->seq_val, seq)) {
+      return locmpptr;
+    }
+    if(SEQ_VAL_IS_GT(locmpptr->seq_val, seq)) {
+      /* Sorted list, we've gone past it */
+      break;
+    }
   }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Link message p into window w, keeping the list ordered */
+static void
+buffer_insert(struct sliding_window *w, struct mcast_packet *p)
+{
+  struct mcast_packet **pp;
 
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)) {
-      iterswptr = locmpptr->sw;
-      VERBOSE_PRINTF("ROLL TM: Update Bounds: [%d - %d] vs %u\n",
-                     iterswptr->lower_bound, iterswptr->upper_bound,
-                     locmpptr->seq_val);
-      if(iterswptr->lower_bound < 0
-         || SEQ_VAL_IS_LT(locmpptr->seq_val, iterswptr->lower_bound)) {
-        iterswptr->lower_bound = locmpptr->seq_val;
-      }
-      if(iterswptr->upper_bound < 0 ||
-         SEQ_VAL_IS_GT(locmpptr->seq_val, iterswptr->upper_bound)) {
-        iterswptr->upper_bound = locmpptr->seq_val;
-      }
+  for(pp = &w->head; *pp != NULL; pp = &(*pp)->next) {
+    if(SEQ_VAL_IS_GT((*pp)->seq_val, p->seq_val)) {
+      break;
     }
   }
+  p->next = *pp;
+  *pp = p;
+  p->sw = w;
+  w->count++;
 }
 /*---------------------------------------------------------------------------*/
+/* Return an unlinked message buffer to the pool */
+static void
+buffer_release(struct mcast_packet *p)
+{
+  MCAST_PACKET_FREE(p);
+  p->next = free_msgs;
+  free_msgs = p;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Take the oldest message away from window w. If w is NULL, pick the window
+ * with the most buffered messages, as long as doing so won't empty it
+ */
 static struct mcast_packet *
-buffer_reclaim()
+buffer_reclaim(struct sliding_window *w)
 {
-  struct sliding_window *largest = windows;
   struct mcast_packet *rv;
 
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
-    if(iterswptr->count > largest->count) {
-      largest = iterswptr;
+  if(w == NULL) {
+    for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
+        iterswptr--) {
+      if(SLIDING_WINDOW_IS_USED(iterswptr) &&
+         (w == NULL || iterswptr->count > w->count)) {
+        w = iterswptr;
+      }
+    }
+
+    if(w == NULL || w->count <= 1) {
+      /* Can't reclaim last entry for a window and this is the largest window */
+      return NULL;
     }
   }
 
-  if(largest->count == 1) {
-    /* Can't reclaim last entry for a window and this is the largest window */
+  if(w->head == NULL) {
+    /* oops */
     return NULL;
   }
 
   PRINTF("ROLL TM: Reclaim from Seed ");
-  PRINT_SEED(&largest->seed_id);
-  PRINTF(" M=%u, count was %u\n",
-         SLIDING_WINDOW_GET_M(largest), largest->count);
-  /* Find the packet at the lowest bound for the largest window */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr) && (locmpptr->sw == largest) &&
-       SEQ_VAL_IS_EQ(locmpptr->seq_val, largest->lower_bound)) {
-      rv = locmpptr;
-      PRINTF("ROLL TM: Reclaim seq. val %u\n", locmpptr->seq_val);
-      MCAST_PACKET_FREE(rv);
-      largest->count--;
-      window_update_bounds();
-      VERBOSE_PRINTF("ROLL TM: Reclaim - new bounds [%u , %u]\n",
-                     largest->lower_bound, largest->upper_bound);
-      return rv;
-    }
-  }
-
-  /* oops */
-  return NULL;
+  PRINT_SEED(&w->seed_id);
+  PRINTF(" M=%u, count was %u\n", SLIDING_WINDOW_GET_M(w), w->count);
+
+  /* The packet at the lowest bound is at the head of the list */
+  rv = w->head;
+  PRINTF("ROLL TM: Reclaim seq. val %u\n", rv->seq_val);
+  w->head = rv->next;
+  w->count--;
+  MCAST_PACKET_FREE(rv);
+  window_update_bounds(w);
+  VERBOSE_PRINTF("ROLL TM: Reclaim - new bounds [%u , %u]\n",
+                 w->lower_bound, w->upper_bound);
+  return rv;
 }
 /*---------------------------------------------------------------------------*/
 static struct mcast_packet *
 buffer_allocate()
 {
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(!MCAST_PACKET_IS_USED(locmpptr)) {
-      return locmpptr;
-    }
+  locmpptr = free_msgs;
+  if(locmpptr != NULL) {
+    free_msgs = locmpptr->next;
   }
-  return NULL;
+  return locmpptr;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -818,6 +902,14 @@ icmp_output()
   for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
       iterswptr--) {
     if(SLIDING_WINDOW_IS_USED(iterswptr) && iterswptr->count > 0) {
+      /* Leave out windows whose sequence list would not fit in uip_buf */
+      if((uint8_t *)sl + sizeof(struct sequence_list_header) +
+         iterswptr->count * 2 > &uip_buf[UIP_BUFSIZE]) {
+        PRINTF("ROLL TM: ICMPv6 Out - No room for Seed ID ");
+        PRINT_SEED(&iterswptr->seed_id);
+        PRINTF("\n");
+        continue;
+      }
       memset(sl, 0, sizeof(struct sequence_list_header));
 #if ROLL_TM_SHORT_SEEDS
       sl->flags = SEQUENCE_LIST_S_BIT;
@@ -832,18 +924,15 @@ icmp_output()
 
       buffer = (uint8_t *)sl + sizeof(struct sequence_list_header);
 
-      for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-          locmpptr >= buffered_msgs; locmpptr--) {
-        if(MCAST_PACKET_IS_USED(locmpptr) &&
-           locmpptr->active < TRICKLE_ACTIVE((&t[SLIDING_WINDOW_GET_M(iterswptr)]))) {
-          if(locmpptr->sw == iterswptr) {
-            sl->seq_len++;
-            PRINTF(", %u", locmpptr->seq_val);
-            *buffer = (uint8_t)(locmpptr->seq_val >> 8);
-            buffer++;
-            *buffer = (uint8_t)(locmpptr->seq_val & 0xFF);
-            buffer++;
-          }
+      for(locmpptr = iterswptr->head; locmpptr != NULL;
+          locmpptr = locmpptr->next) {
+        if(locmpptr->active < TRICKLE_ACTIVE((&t[SLIDING_WINDOW_GET_M(iterswptr)]))) {
+          sl->seq_len++;
+          PRINTF(", %u", locmpptr->seq_val);
+          *buffer = (uint8_t)(locmpptr->seq_val >> 8);
+          buffer++;
+          *buffer = (uint8_t)(locmpptr->seq_val & 0xFF);
+          buffer++;
         }
       }
       PRINTF(", Len=%u\n", sl->seq_len);
@@ -895,6 +984,7 @@ accept(uint8_t in)
 {
   seed_id_t *seed_ptr;
   uint8_t m;
+  uint8_t new_window;
   uint16_t seq_val;
 
   PRINTF("ROLL TM: Multicast I/O\n");
@@ -978,17 +1068,11 @@ accept(uint8_t in)
       UIP_MCAST6_STATS_ADD(mcast_dropped);
       return UIP_MCAST6_DROP;
     }
-    for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-        locmpptr >= buffered_msgs; locmpptr--) {
-      if(MCAST_PACKET_IS_USED(locmpptr) &&
-         locmpptr->sw == locswptr &&
-         SLIDING_WINDOW_GET_M(locmpptr->sw) == m &&
-         SEQ_VAL_IS_EQ(seq_val, locmpptr->seq_val)) {
-        /* Seen before , drop */
-        PRINTF("ROLL TM: Seen before\n");
-        UIP_MCAST6_STATS_ADD(mcast_dropped);
-        return UIP_MCAST6_DROP;
-      }
+    if(window_find_seq(locswptr, seq_val) != NULL) {
+      /* Seen before , drop */
+      PRINTF("ROLL TM: Seen before\n");
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
     }
   }
 
@@ -996,8 +1080,10 @@ accept(uint8_t in)
 
   /* We have not seen this message before */
   /* Allocate a window if we have to */
+  new_window = 0;
   if(!locswptr) {
     locswptr = window_allocate();
+    new_window = 1;
     PRINTF("ROLL TM: New seed\n");
   }
   if(!locswptr) {
@@ -1007,22 +1093,30 @@ accept(uint8_t in)
     return UIP_MCAST6_DROP;
   }
 
-  /* Allocate a buffer */
-  locmpptr = buffer_allocate();
-  if(!locmpptr) {
-    PRINTF("ROLL TM: Buffer allocation failed, reclaiming\n");
-    locmpptr = buffer_reclaim();
+  /*
+   * Allocate a buffer. A window at its quota recycles its own oldest message,
+   * otherwise we take from the pool and only then steal from the largest
+   */
+  if(locswptr->count >= ROLL_TM_BUFF_PER_WIN) {
+    PRINTF("ROLL TM: Window full, reclaiming\n");
+    locmpptr = buffer_reclaim(locswptr);
+  } else {
+    locmpptr = buffer_allocate();
+    if(!locmpptr) {
+      PRINTF("ROLL TM: Buffer allocation failed, reclaiming\n");
+      locmpptr = buffer_reclaim(NULL);
+    }
   }
 
   if(!locmpptr) {
     /* Failed to allocate / reclaim a buffer. If the window has only just been
      * allocated, free it before dropping */
     PRINTF("ROLL TM: Buffer reclaim failed\n");
-    if(locswptr->count == 0) {
+    if(new_window) {
       window_free(locswptr);
-      UIP_MCAST6_STATS_ADD(mcast_dropped);
-      return UIP_MCAST6_DROP;
     }
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    return UIP_MCAST6_DROP;
   }
 #if UIP_MCAST6_STATS
   if(in == ROLL_TM_DGRAM_IN) {
@@ -1038,31 +1132,27 @@ accept(uint8_t in)
   }
   SLIDING_WINDOW_IS_USED_SET(locswptr);
   seed_id_cpy(&locswptr->seed_id, seed_ptr);
+  if(new_window) {
+    window_insert(locswptr);
+  }
   PRINTF("ROLL TM: Window for seed ");
   PRINT_SEED(&locswptr->seed_id);
   PRINTF(" M=%u, count=%u\n",
          SLIDING_WINDOW_GET_M(locswptr), locswptr->count);
 
-  /* If this window was previously empty, set its lower bound to this packet */
-  if(locswptr->count == 0) {
-    locswptr->lower_bound = seq_val;
-    VERBOSE_PRINTF("ROLL TM: New Lower Bound %u\n", locswptr->lower_bound);
-  }
-
   /* If this is a new Seq Num, update the window upper bound */
   if(locswptr->count == 0 || SEQ_VAL_IS_GT(seq_val, locswptr->upper_bound)) {
     locswptr->upper_bound = seq_val;
     VERBOSE_PRINTF("ROLL TM: New Upper Bound %u\n", locswptr->upper_bound);
   }
 
-  locswptr->count++;
-
   memset(locmpptr, 0, sizeof(struct mcast_packet));
   memcpy(&locmpptr->buff, UIP_IP_BUF, uip_len);
-  locmpptr->sw = locswptr;
   locmpptr->buff_len = uip_len;
   locmpptr->seq_val = seq_val;
   MCAST_PACKET_USED_SET(locmpptr);
+  buffer_insert(locswptr, locmpptr);
+  window_update_bounds(locswptr);
 
   PRINTF("ROLL TM: Window for seed ");
   PRINT_SEED(&locswptr->seed_id);
@@ -1136,16 +1226,16 @@ icmp_input()
 
   ROLL_TM_STATS_ADD(icmp_in);
 
-  /* Reset Is-Listed bit for all windows */
+  /* Reset Is-Listed bit for all windows and their cached packets */
   for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
       iterswptr--) {
     SLIDING_WINDOW_LISTED_CLR(iterswptr);
-  }
-
-  /* Reset Is-Listed bit for all cached packets */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    MCAST_PACKET_LISTED_CLR(locmpptr);
+    if(SLIDING_WINDOW_IS_USED(iterswptr)) {
+      for(locmpptr = iterswptr->head; locmpptr != NULL;
+          locmpptr = locmpptr->next) {
+        MCAST_PACKET_LISTED_CLR(locmpptr);
+      }
+    }
   }
 
   locslhptr = (struct sequence_list_header *)UIP_ICMP_PAYLOAD;
@@ -1222,23 +1312,16 @@ icmp_input()
 
           inconsistency = 1;
           /* Check if the advertised sequence is in our buffer */
-          for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-              locmpptr >= buffered_msgs; locmpptr--) {
-            if(MCAST_PACKET_IS_USED(locmpptr) && locmpptr->sw == locswptr) {
-              if(SEQ_VAL_IS_EQ(locmpptr->seq_val, val)) {
-
-                inconsistency = 0;
-                MCAST_PACKET_LISTED_SET(locmpptr);
-                PRINTF("ROLL TM: ICMPv6 In, %u listed\n", locmpptr->seq_val);
-
-                /* Update lowest seq. num listed for this window
-                 * We need this to check for "we have new" */
-                if(locswptr->min_listed == -1 ||
-                   SEQ_VAL_IS_LT(val, locswptr->min_listed)) {
-                  locswptr->min_listed = val;
-                }
-                break;
-              }
+          if(window_find_seq(locswptr, val) != NULL) {
+            inconsistency = 0;
+            MCAST_PACKET_LISTED_SET(locmpptr);
+            PRINTF("ROLL TM: ICMPv6 In, %u listed\n", locmpptr->seq_val);
+
+            /* Update lowest seq. num listed for this window
+             * We need this to check for "we have new" */
+            if(locswptr->min_listed == -1 ||
+               SEQ_VAL_IS_LT(val, locswptr->min_listed)) {
+              locswptr->min_listed = val;
             }
           }
           if(inconsistency) {
@@ -1265,17 +1348,22 @@ icmp_input()
 
   /* Check for "We have new */
   PRINTF("ROLL TM: ICMPv6 In, Check our buffer\n");
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)) {
-      locswptr = locmpptr->sw;
+  for(locswptr = &windows[ROLL_TM_WINS - 1]; locswptr >= windows;
+      locswptr--) {
+    if(!SLIDING_WINDOW_IS_USED(locswptr)) {
+      continue;
+    }
+
+    /* Point to the sliding window's trickle param */
+    loctpptr = &t[SLIDING_WINDOW_GET_M(locswptr)];
+
+    for(locmpptr = locswptr->head; locmpptr != NULL;
+        locmpptr = locmpptr->next) {
       PRINTF("ROLL TM: ICMPv6 In, ");
       PRINTF("Check %u, Seed L: %u, This L: %u Min L: %d\n",
              locmpptr->seq_val, SLIDING_WINDOW_IS_LISTED(locswptr),
              MCAST_PACKET_IS_LISTED(locmpptr), locswptr->min_listed);
 
-      /* Point to the sliding window's trickle param */
-      loctpptr = &t[SLIDING_WINDOW_GET_M(locswptr)];
       if(!SLIDING_WINDOW_IS_LISTED(locswptr)) {
         /* If a buffered packet's Seed ID was not listed */
         PRINTF("ROLL TM: Inconsistency - Seed ID ");
@@ -1414,9 +1502,16 @@ init()
   PRINTF("ROLL TM: ROLL Multicast - Draft #%u\n", ROLL_TM_VER);
 
   memset(windows, 0, sizeof(windows));
+  memset(win_hash, 0, sizeof(win_hash));
   memset(buffered_msgs, 0, sizeof(buffered_msgs));
   memset(t, 0, sizeof(t));
 
+  free_msgs = NULL;
+  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
+      locmpptr >= buffered_msgs; locmpptr--) {
+    buffer_release(locmpptr);
+  }
+
   ROLL_TM_STATS_INIT();
   UIP_MCAST6_STATS_INIT(&stats);
 
@@ -187,6 +187,30 @@
 #define ROLL_TM_BUFF_NUM 6
 #endif
 /*---------------------------------------------------------------------------*/
+/**
+ * Maximum Number of Buffered Messages per Sliding Window
+ * Caps how many of the ROLL_TM_BUFF_NUM buffers a single Seed ID may occupy.
+ * When a window is at its cap, a new message for it replaces that window's
+ * oldest buffered message instead of competing with other seeds. The default
+ * keeps the shared-buffer behaviour described above
+ */
+#ifdef ROLL_TM_CONF_BUFF_PER_WIN
+#define ROLL_TM_BUFF_PER_WIN ROLL_TM_CONF_BUFF_PER_WIN
+#else
+#define ROLL_TM_BUFF_PER_WIN ROLL_TM_BUFF_NUM
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Number of buckets in the Seed ID hash used to look up sliding windows.
+ * Must be a power of two. Raise this alongside ROLL_TM_WINS when tracking
+ * many seeds
+ */
+#ifdef ROLL_TM_CONF_WIN_HASH
+#define ROLL_TM_WIN_HASH ROLL_TM_CONF_WIN_HASH
+#else
+#define ROLL_TM_WIN_HASH 4
+#endif
+/*---------------------------------------------------------------------------*/
 /**
  * Use Short Seed IDs [short: 2, long: 16 (default)]
  * It can be argued that we should (and it would be easy to) support both at
@@ -45,6 +45,7 @@
 #include "contiki-net.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/ipv6/multicast/uip-mcast6-route.h"
+#include "net/ipv6/multicast/uip-mcast6-dup.h"
 #include "net/ipv6/multicast/uip-mcast6-stats.h"
 #include "net/ipv6/multicast/smrf.h"
 #include "net/rpl/rpl.h"
@@ -131,6 +132,13 @@ in()
   }
 
   UIP_MCAST6_STATS_ADD(mcast_in_all);
+
+  /* Our parent may send us the same datagram more than once */
+  if(uip_mcast6_dup_check()) {
+    PRINTF("SMRF: Duplicate, dropped\n");
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    return UIP_MCAST6_DROP;
+  }
   UIP_MCAST6_STATS_ADD(mcast_in_unique);
 
   /* If we have an entry in the mcast routing table, something with
@@ -191,6 +199,7 @@ static void
 init()
 {
   UIP_MCAST6_STATS_INIT(NULL);
+  uip_mcast6_dup_init();
 
   uip_mcast6_route_init();
 }
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Cache of recently seen multicast datagrams
+ */
+
+#include "contiki.h"
+#include "lib/crc16.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/multicast/uip-mcast6-dup.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+/*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_DUP_ENTRIES
+/*---------------------------------------------------------------------------*/
+#define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+/* Offsets of the checksum in the upper-layer headers */
+#define UDP_CHKSUM_OFFSET   6
+#define ICMP6_CHKSUM_OFFSET 2
+#define TCP_CHKSUM_OFFSET   16
+/*---------------------------------------------------------------------------*/
+struct dup_entry {
+  uip_ipaddr_t src;
+  uint16_t len;
+  uint16_t tag;
+  clock_time_t seen;
+};
+
+static struct dup_entry entries[UIP_MCAST6_DUP_ENTRIES];
+/* Number of valid entries, and the one to replace next */
+static uint8_t used;
+static uint8_t next;
+/*---------------------------------------------------------------------------*/
+/* Identify the upper-layer part of the datagram in uip_buf */
+static uint16_t
+datagram_tag(uint16_t *len)
+{
+  uint8_t *hdr = &uip_buf[UIP_LLIPH_LEN];
+  uint8_t *end = &uip_buf[UIP_LLH_LEN + uip_len];
+  uint8_t proto = UIP_IP_BUF->proto;
+  uint8_t offset;
+
+  while((proto == UIP_PROTO_HBHO || proto == UIP_PROTO_DESTO ||
+         proto == UIP_PROTO_ROUTING) && hdr + 2 <= end) {
+    proto = hdr[0];
+    hdr += (hdr[1] + 1) << 3;
+  }
+  if(hdr > end) {
+    hdr = end;
+  }
+  *len = end - hdr;
+
+  switch(proto) {
+  case UIP_PROTO_UDP:
+    offset = UDP_CHKSUM_OFFSET;
+    break;
+  case UIP_PROTO_ICMP6:
+    offset = ICMP6_CHKSUM_OFFSET;
+    break;
+  case UIP_PROTO_TCP:
+    offset = TCP_CHKSUM_OFFSET;
+    break;
+  default:
+    offset = 0;
+    break;
+  }
+  if(offset > 0 && *len >= offset + 2) {
+    /* The checksum already covers the group and the payload */
+    return (hdr[offset] << 8) | hdr[offset + 1];
+  }
+  return crc16_data(hdr, *len,
+                    crc16_data(UIP_IP_BUF->destipaddr.u8,
+                               sizeof(uip_ipaddr_t), 0));
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_mcast6_dup_check(void)
+{
+  struct dup_entry *e;
+  clock_time_t now = clock_time();
+  uint16_t len;
+  uint16_t tag;
+  uint8_t i;
+
+  tag = datagram_tag(&len);
+
+  for(i = 0; i < used; i++) {
+    e = &entries[i];
+    if(e->tag == tag && e->len == len &&
+       (clock_time_t)(now - e->seen) < UIP_MCAST6_DUP_LIFETIME &&
+       uip_ipaddr_cmp(&e->src, &UIP_IP_BUF->srcipaddr)) {
+      PRINTF("Multicast: duplicate from ");
+      PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
+      PRINTF(" tag 0x%04x\n", tag);
+      return 1;
+    }
+  }
+
+  e = &entries[next];
+  uip_ipaddr_copy(&e->src, &UIP_IP_BUF->srcipaddr);
+  e->len = len;
+  e->tag = tag;
+  e->seen = now;
+  next = (next + 1) % UIP_MCAST6_DUP_ENTRIES;
+  if(used < UIP_MCAST6_DUP_ENTRIES) {
+    used++;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_dup_init(void)
+{
+  used = 0;
+  next = 0;
+}
+/*---------------------------------------------------------------------------*/
+#else /* UIP_MCAST6_DUP_ENTRIES */
+/*---------------------------------------------------------------------------*/
+int
+uip_mcast6_dup_check(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_dup_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_MCAST6_DUP_ENTRIES */
+/*---------------------------------------------------------------------------*/
+/** @} */
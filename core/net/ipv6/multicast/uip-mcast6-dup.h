@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \addtogroup uip6-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Header file for the cache of recently seen multicast datagrams
+ *
+ *    Engines that forward without sequence numbers of their own (SMRF,
+ *    ESMRF) use this to drop copies of a datagram they already
+ *    processed. A datagram is identified by its source address, the
+ *    length of its upper-layer part and the upper-layer checksum (a
+ *    CRC over the group and the upper-layer part for other protocols).
+ *    Extension headers are skipped, as their contents may change hop
+ *    by hop.
+ *
+ *    There is no (source, sequence) key to use instead: SMRF and ESMRF
+ *    datagrams carry no sequence number, and neither does the RPL
+ *    hop-by-hop option. As a consequence, two distinct datagrams from
+ *    the same source with the same upper-layer length and checksum
+ *    are taken for copies of each other when the second arrives within
+ *    UIP_MCAST6_DUP_LIFETIME of the first, and the second is dropped.
+ *    This happens when an application sends the same payload to the
+ *    same group and port twice in a row, or, rarely, when two payloads
+ *    of the same length have the same checksum. Applications that send
+ *    identical datagrams on purpose should put a counter in their
+ *    payload, or the lifetime should be set below their send interval.
+ */
+#ifndef UIP_MCAST6_DUP_H_
+#define UIP_MCAST6_DUP_H_
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/* Configuration */
+/*---------------------------------------------------------------------------*/
+/* Number of datagrams remembered. 0 disables duplicate suppression */
+#ifdef UIP_MCAST6_DUP_CONF_ENTRIES
+#define UIP_MCAST6_DUP_ENTRIES UIP_MCAST6_DUP_CONF_ENTRIES
+#else
+#define UIP_MCAST6_DUP_ENTRIES 0
+#endif
+
+/*
+ * How long a datagram is remembered. Copies arrive within the
+ * forwarding delays of the engine, so this must be longer than the
+ * largest delay with which a copy can come back (the trickle or
+ * forwarding delays of the engine, over the depth of the DODAG). An
+ * identical datagram sent again within this time is dropped as a copy,
+ * see above.
+ */
+#ifdef UIP_MCAST6_DUP_CONF_LIFETIME
+#define UIP_MCAST6_DUP_LIFETIME UIP_MCAST6_DUP_CONF_LIFETIME
+#else
+#define UIP_MCAST6_DUP_LIFETIME (2 * CLOCK_SECOND)
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Check whether the datagram in uip_buf was seen recently, and
+ *        remember it if it wasn't
+ * \return 1 if the datagram is a duplicate, 0 otherwise
+ *
+ *        Always returns 0 when UIP_MCAST6_DUP_ENTRIES is 0.
+ */
+int uip_mcast6_dup_check(void);
+
+/**
+ * \brief Forget all datagrams
+ */
+void uip_mcast6_dup_init(void);
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_MCAST6_DUP_H_ */
+/** @} */
@@ -56,16 +56,87 @@
 #else
 #define UIP_MCAST6_ROUTE_ROUTES 1
 #endif /* UIP_CONF_DS6_MCAST_ROUTES */
+
+/*
+ * Size in bits of a Bloom filter of the groups in the table. Most
+ * multicast datagrams a forwarder sees are for groups it has no route
+ * for, and the filter answers those without scanning the list. Must
+ * be a power of two, at most 256. 0 disables the filter.
+ */
+#ifdef UIP_MCAST6_ROUTE_CONF_FILTER_BITS
+#define UIP_MCAST6_ROUTE_FILTER_BITS UIP_MCAST6_ROUTE_CONF_FILTER_BITS
+#else
+#define UIP_MCAST6_ROUTE_FILTER_BITS 64
+#endif /* UIP_MCAST6_ROUTE_CONF_FILTER_BITS */
+
+#if (UIP_MCAST6_ROUTE_FILTER_BITS & (UIP_MCAST6_ROUTE_FILTER_BITS - 1)) || \
+  UIP_MCAST6_ROUTE_FILTER_BITS > 256
+#error UIP_MCAST6_ROUTE_CONF_FILTER_BITS must be a power of two, at most 256
+#endif
 /*---------------------------------------------------------------------------*/
 LIST(mcast_route_list);
 MEMB(mcast_route_memb, uip_mcast6_route_t, UIP_MCAST6_ROUTE_ROUTES);
 
 static uip_mcast6_route_t *locmcastrt;
+
+#if UIP_MCAST6_ROUTE_FILTER_BITS
+static uint8_t filter[(UIP_MCAST6_ROUTE_FILTER_BITS + 7) / 8];
+
+/* Each group sets two bits, taken from the two bytes of a hash */
+#define FILTER_BIT(h) ((h) & (UIP_MCAST6_ROUTE_FILTER_BITS - 1))
+/*---------------------------------------------------------------------------*/
+static uint16_t
+filter_hash(const uip_ipaddr_t *group)
+{
+  uint16_t h = 0;
+  uint8_t i;
+
+  for(i = 0; i < sizeof(group->u8); i++) {
+    h = (h << 5) + h + group->u8[i];
+  }
+  return h;
+}
+/*---------------------------------------------------------------------------*/
+static void
+filter_add(const uip_ipaddr_t *group)
+{
+  uint16_t h = filter_hash(group);
+
+  filter[FILTER_BIT(h) >> 3] |= 1 << (FILTER_BIT(h) & 7);
+  filter[FILTER_BIT(h >> 8) >> 3] |= 1 << (FILTER_BIT(h >> 8) & 7);
+}
+/*---------------------------------------------------------------------------*/
+static int
+filter_contains(const uip_ipaddr_t *group)
+{
+  uint16_t h = filter_hash(group);
+
+  return (filter[FILTER_BIT(h) >> 3] & (1 << (FILTER_BIT(h) & 7))) &&
+    (filter[FILTER_BIT(h >> 8) >> 3] & (1 << (FILTER_BIT(h >> 8) & 7)));
+}
+/*---------------------------------------------------------------------------*/
+/* Bits can't be cleared for one group, so removals rebuild the filter */
+static void
+filter_rebuild(void)
+{
+  uip_mcast6_route_t *r;
+
+  memset(filter, 0, sizeof(filter));
+  for(r = list_head(mcast_route_list); r != NULL; r = list_item_next(r)) {
+    filter_add(&r->group);
+  }
+}
+#endif /* UIP_MCAST6_ROUTE_FILTER_BITS */
 /*---------------------------------------------------------------------------*/
 uip_mcast6_route_t *
 uip_mcast6_route_lookup(uip_ipaddr_t *group)
 {
   locmcastrt = NULL;
+#if UIP_MCAST6_ROUTE_FILTER_BITS
+  if(!filter_contains(group)) {
+    return NULL;
+  }
+#endif /* UIP_MCAST6_ROUTE_FILTER_BITS */
   for(locmcastrt = list_head(mcast_route_list);
       locmcastrt != NULL;
       locmcastrt = list_item_next(locmcastrt)) {
@@ -94,6 +165,9 @@ uip_mcast6_route_add(uip_ipaddr_t *group)
   /* Reaching here means we either found the prefix or allocated a new one */
 
   uip_ipaddr_copy(&(locmcastrt->group), group);
+#if UIP_MCAST6_ROUTE_FILTER_BITS
+  filter_add(group);
+#endif /* UIP_MCAST6_ROUTE_FILTER_BITS */
 
   return locmcastrt;
 }
@@ -108,6 +182,9 @@ uip_mcast6_route_rm(uip_mcast6_route_t *route)
     if(locmcastrt == route) {
       list_remove(mcast_route_list, route);
       memb_free(&mcast_route_memb, route);
+#if UIP_MCAST6_ROUTE_FILTER_BITS
+      filter_rebuild();
+#endif /* UIP_MCAST6_ROUTE_FILTER_BITS */
       return;
     }
   }
@@ -130,6 +207,9 @@ uip_mcast6_route_init()
 {
   memb_init(&mcast_route_memb);
   list_init(mcast_route_list);
+#if UIP_MCAST6_ROUTE_FILTER_BITS
+  memset(filter, 0, sizeof(filter));
+#endif /* UIP_MCAST6_ROUTE_FILTER_BITS */
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
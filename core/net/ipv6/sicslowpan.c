@@ -101,6 +101,38 @@ void uip_log(char *msg);
 #endif /* SICSLOWPAN_CONF_COMPRESSION */
 #endif /* SICSLOWPAN_COMPRESSION */
 
+/*
+ * 6LoWPAN routing headers (RFC 8138). When enabled with HC06
+ * compression, the RPL option, the RPL source routing header and an
+ * IPv6-in-IPv6 outer header are sent as 6LoRHs in page 1 rather than
+ * inline, which leaves LOWPAN_UDP to compress the UDP header behind
+ * them. All nodes of a network must agree on this setting.
+ */
+#ifdef SICSLOWPAN_CONF_6LORH
+#define SICSLOWPAN_6LORH SICSLOWPAN_CONF_6LORH
+#else
+#define SICSLOWPAN_6LORH 0
+#endif
+
+#if SICSLOWPAN_6LORH
+/* Source routes with more addresses are left inline. The header
+   lengths are kept in 8 bits, which bounds this to 8. */
+#ifdef SICSLOWPAN_CONF_6LORH_MAX_HOPS
+#define SICSLOWPAN_6LORH_MAX_HOPS SICSLOWPAN_CONF_6LORH_MAX_HOPS
+#else
+#define SICSLOWPAN_6LORH_MAX_HOPS 8
+#endif
+#if SICSLOWPAN_6LORH_MAX_HOPS > 8
+#error SICSLOWPAN_CONF_6LORH_MAX_HOPS must not exceed 8
+#endif
+
+/* Worst-case growth of the headers from uncompressing 6LoRHs: an
+   outer IPv6 header, the RPL option and a source routing header */
+#define SICSLOWPAN_6LORH_GROWTH (UIP_IPH_LEN + 8 + 8 + 16 * SICSLOWPAN_6LORH_MAX_HOPS)
+#else /* SICSLOWPAN_6LORH */
+#define SICSLOWPAN_6LORH_GROWTH 0
+#endif /* SICSLOWPAN_6LORH */
+
 #define GET16(ptr,index) (((uint16_t)((ptr)[index] << 8)) | ((ptr)[(index) + 1]))
 #define SET16(ptr,index,value) do {     \
   (ptr)[index] = ((value) >> 8) & 0xff; \
@@ -115,6 +147,12 @@ void uip_log(char *msg);
 #define PACKETBUF_FRAG_TAG           2   /* 16 bit */
 #define PACKETBUF_FRAG_OFFSET        4   /* 8 bit */
 
+#define PACKETBUF_RFRAG_DISPATCH     0   /* 8 bit */
+#define PACKETBUF_RFRAG_TAG          1   /* 8 bit */
+#define PACKETBUF_RFRAG_SEQ_SIZE     2   /* 16 bit */
+#define PACKETBUF_RFRAG_OFFSET       4   /* 16 bit */
+#define PACKETBUF_RFRAG_ACK_BITMAP   2   /* 32 bit */
+
 /* define the buffer as a byte array */
 #define PACKETBUF_IPHC_BUF              ((uint8_t *)(packetbuf_ptr + packetbuf_hdr_len))
 
@@ -222,10 +260,59 @@ static uint16_t my_tag;
 
 /** The total length of the IPv6 packet in the sicslowpan_buf. */
 
+/*
+ * Non-standard selective fragment recovery. When enabled, datagrams to
+ * a unicast link-layer destination are sent as recoverable fragments
+ * (RFRAG). The receiver acknowledges them with a bitmap of the
+ * fragments it holds, and only the missing fragments are sent again.
+ * The sender keeps a copy of the datagram until it is fully
+ * acknowledged, so this costs one uIP buffer of RAM. Only nodes with
+ * recovery enabled understand RFRAGs, so it must be enabled on all
+ * nodes of a network. They still receive RFC 4944 fragments, and a
+ * datagram that cannot be sent with recovery (e.g. while another one
+ * is in recovery) is fragmented as per RFC 4944.
+ *
+ * The wire format is private to Contiki. It uses dispatch values left
+ * unassigned by RFC 4944, and offsets in bytes of the uncompressed
+ * datagram, so that fragments can be placed before the first one
+ * arrives. It is not RFC 8931 and does not interoperate with it.
+ */
+#ifdef SICSLOWPAN_CONF_NONSTANDARD_FRAG_RECOVERY
+#define SICSLOWPAN_FRAG_RECOVERY SICSLOWPAN_CONF_NONSTANDARD_FRAG_RECOVERY
+#else
+#define SICSLOWPAN_FRAG_RECOVERY 0
+#endif
+
+#if SICSLOWPAN_FRAG_RECOVERY
+/* Time to wait for an RFRAG-ACK before asking for one again */
+#ifdef SICSLOWPAN_CONF_FRAG_RECOVERY_ACK_TIMEOUT
+#define SICSLOWPAN_FRAG_RECOVERY_ACK_TIMEOUT SICSLOWPAN_CONF_FRAG_RECOVERY_ACK_TIMEOUT
+#else
+#define SICSLOWPAN_FRAG_RECOVERY_ACK_TIMEOUT (CLOCK_SECOND / 2)
+#endif
+
+/* Number of recovery rounds before a datagram is given up */
+#ifdef SICSLOWPAN_CONF_FRAG_RECOVERY_MAX_RETRIES
+#define SICSLOWPAN_FRAG_RECOVERY_MAX_RETRIES SICSLOWPAN_CONF_FRAG_RECOVERY_MAX_RETRIES
+#else
+#define SICSLOWPAN_FRAG_RECOVERY_MAX_RETRIES 3
+#endif
+
+/* The bit of a fragment in an RFRAG-ACK bitmap */
+#define RFRAG_BIT(seq) ((uint32_t)0x80000000 >> (seq))
+#define RFRAG_BITMAP_FULL 0xffffffff
+#define RFRAG_BITMAP_NULL 0
+
+/* Length of a context whose first fragment has not been received */
+#define RFRAG_LEN_UNKNOWN 0xffff
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
+
 /* This needs to be defined in NBR / Nodes depending on available RAM   */
 /*   and expected reassembly requirements                               */
 #ifdef SICSLOWPAN_CONF_FRAGMENT_BUFFERS
 #define SICSLOWPAN_FRAGMENT_BUFFERS SICSLOWPAN_CONF_FRAGMENT_BUFFERS
+#elif SICSLOWPAN_FRAG_RECOVERY
+#define SICSLOWPAN_FRAGMENT_BUFFERS 14
 #else
 #define SICSLOWPAN_FRAGMENT_BUFFERS 12
 #endif
@@ -233,10 +320,16 @@ static uint16_t my_tag;
 /* REASS_CONTEXTS corresponds to the number of simultaneous
  * reassemblies that can be made. NOTE: the first buffer for each
  * reassembly is stored in the context since it can be larger than the
- * rest of the fragments due to header compression.
+ * rest of the fragments due to header compression. With fragment
+ * recovery, the first fragment may arrive last; a context then only
+ * holds the state of a reassembly, and all data, including the
+ * uncompressed first fragment, is kept in the shared pool of fragment
+ * buffers.
  **/
 #ifdef SICSLOWPAN_CONF_REASS_CONTEXTS
 #define SICSLOWPAN_REASS_CONTEXTS SICSLOWPAN_CONF_REASS_CONTEXTS
+#elif SICSLOWPAN_FRAG_RECOVERY
+#define SICSLOWPAN_REASS_CONTEXTS 4
 #else
 #define SICSLOWPAN_REASS_CONTEXTS 2
 #endif
@@ -248,15 +341,48 @@ static uint16_t my_tag;
 #define SICSLOWPAN_FRAGMENT_SIZE 110
 #endif
 
-/* Assuming that the worst growth for uncompression is 38 bytes */
-#define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38)
+/* Assuming that the worst growth for uncompression is 38 bytes, plus
+   that of the 6LoRHs if used */
+#define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38 + \
+                                        SICSLOWPAN_6LORH_GROWTH)
+
+#if SICSLOWPAN_FRAG_RECOVERY
+/* The uncompressed first fragment is split over fragment buffers in
+   chunks of this size, keeping the offsets of the chunks 8-byte
+   aligned */
+#define SICSLOWPAN_FIRST_FRAGMENT_CHUNK (SICSLOWPAN_FRAGMENT_SIZE & ~7)
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
+
+/*
+ * Fragment forwarding. When enabled, a router does not reassemble a
+ * datagram that it forwards. The first fragment is routed on its own,
+ * and a switching entry maps the (sender, tag) of its fragments to
+ * the next hop and a new tag. The following fragments are sent on as
+ * soon as they arrive, with the tag rewritten. Fragments that arrive
+ * before the first one are dropped. Datagrams sent as recoverable
+ * fragments are still reassembled at each hop, and so are datagrams
+ * whose headers grow on the way or no longer fit in the first
+ * fragment.
+ */
+#ifdef SICSLOWPAN_CONF_FRAG_FORWARDING
+#define SICSLOWPAN_FRAG_FORWARDING SICSLOWPAN_CONF_FRAG_FORWARDING
+#else
+#define SICSLOWPAN_FRAG_FORWARDING 0
+#endif
+
+#if SICSLOWPAN_FRAG_FORWARDING
+/* Number of datagrams that can be forwarded at the same time */
+#ifdef SICSLOWPAN_CONF_FRAG_FORWARDING_ENTRIES
+#define SICSLOWPAN_FRAG_FORWARDING_ENTRIES SICSLOWPAN_CONF_FRAG_FORWARDING_ENTRIES
+#else
+#define SICSLOWPAN_FRAG_FORWARDING_ENTRIES 4
+#endif
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 
 /* all information needed for reassembly */
 struct sicslowpan_frag_info {
   /** When reassembling, the source address of the fragments being merged */
   linkaddr_t sender;
-  /** The destination address of the fragments being merged */
-  linkaddr_t receiver;
   /** When reassembling, the tag in the fragments being merged. */
   uint16_t tag;
   /** Total length of the fragmented packet */
@@ -265,12 +391,18 @@ struct sicslowpan_frag_info {
   uint16_t reassembled_len;
   /** Reassembly %process %timer. */
   struct timer reass_timer;
-
+#if SICSLOWPAN_FRAG_RECOVERY
+  /** Fragments received so far, if the fragments are recoverable */
+  uint32_t rfrag_bitmap;
+  /** Non-zero if the fragments are recoverable (RFRAG) */
+  uint8_t rfrag;
+#else /* SICSLOWPAN_FRAG_RECOVERY */
   /** Fragment size of first fragment */
   uint16_t first_frag_len;
   /** First fragment - needs a larger buffer since the size is uncompressed size
    and we need to know total size to know when we have received last fragment. */
   uint8_t first_frag[SICSLOWPAN_FIRST_FRAGMENT_SIZE];
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
 };
 
 static struct sicslowpan_frag_info frag_info[SICSLOWPAN_REASS_CONTEXTS];
@@ -287,6 +419,16 @@ struct sicslowpan_frag_buf {
 
 static struct sicslowpan_frag_buf frag_buf[SICSLOWPAN_FRAGMENT_BUFFERS];
 
+#if SICSLOWPAN_FRAG_RECOVERY
+/* The first fragment is uncompressed here before it is stored in the
+   fragment buffers, since it can be larger than the rest of the
+   fragments due to header compression. */
+static uint8_t first_frag[SICSLOWPAN_FIRST_FRAGMENT_SIZE];
+#define FIRST_FRAG_BUF(context) first_frag
+#else /* SICSLOWPAN_FRAG_RECOVERY */
+#define FIRST_FRAG_BUF(context) frag_info[context].first_frag
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
+
 /*---------------------------------------------------------------------------*/
 static int
 clear_fragments(uint8_t frag_info_index)
@@ -320,17 +462,21 @@ timeout_fragments(int not_context)
 }
 /*---------------------------------------------------------------------------*/
 static int
-store_fragment(uint8_t index, uint8_t offset)
+store_fragment(uint8_t index, uint8_t offset, const uint8_t *data, uint16_t len)
 {
   int i;
+
+  if(len == 0 || len > SICSLOWPAN_FRAGMENT_SIZE) {
+    return -1;
+  }
+
   for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
     if(frag_buf[i].len == 0) {
-      /* copy over the data from packetbuf into the fragment buffer and store offset and len */
+      /* copy over the data into the fragment buffer and store offset and len */
       frag_buf[i].offset = offset; /* frag offset */
-      frag_buf[i].len = packetbuf_datalen() - packetbuf_hdr_len;
+      frag_buf[i].len = len;
       frag_buf[i].index = index;
-      memcpy(frag_buf[i].data, packetbuf_ptr + packetbuf_hdr_len,
-             packetbuf_datalen() - packetbuf_hdr_len);
+      memcpy(frag_buf[i].data, data, len);
 
       PRINTF("Fragsize: %d\n", frag_buf[i].len);
       /* return the length of the stored fragment */
@@ -341,49 +487,104 @@ store_fragment(uint8_t index, uint8_t offset)
   return -1;
 }
 /*---------------------------------------------------------------------------*/
-/* add a new fragment to the buffer */
+/* Store a fragment, freeing the buffers of expired reassemblies if
+   the pool is full */
+static int
+store_fragment_or_timeout(uint8_t index, uint8_t offset,
+                          const uint8_t *data, uint16_t len)
+{
+  int stored;
+
+  stored = store_fragment(index, offset, data, len);
+  if(stored < 0 && timeout_fragments(index) > 0) {
+    stored = store_fragment(index, offset, data, len);
+  }
+  return stored;
+}
+/*---------------------------------------------------------------------------*/
+/* Store the uncompressed first fragment, which is in FIRST_FRAG_BUF() */
+static int
+store_first_fragment(uint8_t index, uint16_t len)
+{
+#if SICSLOWPAN_FRAG_RECOVERY
+  uint16_t offset;
+  uint16_t chunk_len;
+
+  /* Split it over the pool in 8-byte aligned chunks */
+  for(offset = 0; offset < len; offset += chunk_len) {
+    chunk_len = MIN(SICSLOWPAN_FIRST_FRAGMENT_CHUNK, len - offset);
+    if(store_fragment_or_timeout(index, offset >> 3, &first_frag[offset],
+                                 chunk_len) < 0) {
+      return -1;
+    }
+  }
+#else /* SICSLOWPAN_FRAG_RECOVERY */
+  frag_info[index].first_frag_len = len;
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* Allocate a reassembly context, freeing all expired contexts */
 static int8_t
-add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
+new_context(uint16_t tag, uint16_t frag_size)
 {
   int i;
-  int len;
   int8_t found = -1;
 
-  if(offset == 0) {
-    /* This is a first fragment - check if we can add this */
-    for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
-      /* clear all fragment info with expired timer to free all fragment buffers */
-      if(frag_info[i].len > 0 && timer_expired(&frag_info[i].reass_timer)) {
-	clear_fragments(i);
-      }
-
-      /* We use len as indication on used or not used */
-      if(found < 0 && frag_info[i].len == 0) {
-        /* We remember the first free fragment info but must continue
-           the loop to free any other expired fragment buffers. */
-        found = i;
-      }
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    /* clear all fragment info with expired timer to free all fragment buffers */
+    if(frag_info[i].len > 0 && timer_expired(&frag_info[i].reass_timer)) {
+      clear_fragments(i);
     }
 
-    if(found < 0) {
-      PRINTF("*** Failed to store new fragment session - tag: %d\n", tag);
-      return -1;
+    /* We use len as indication on used or not used */
+    if(found < 0 && frag_info[i].len == 0) {
+      /* We remember the first free fragment info but must continue
+         the loop to free any other expired fragment buffers. */
+      found = i;
     }
+  }
 
-    /* Found a free fragment info to store data in */
-    frag_info[found].len = frag_size;
-    frag_info[found].tag = tag;
-    linkaddr_copy(&frag_info[found].sender,
-                  packetbuf_addr(PACKETBUF_ADDR_SENDER));
-    timer_set(&frag_info[found].reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
-    /* first fragment can not be stored immediately but is moved into
-       the buffer while uncompressing */
-    return found;
+  if(found < 0) {
+    PRINTF("*** Failed to store new fragment session - tag: %d\n", tag);
+    return -1;
+  }
+
+  /* Found a free fragment info to store data in */
+  frag_info[found].len = frag_size;
+  frag_info[found].tag = tag;
+  frag_info[found].reassembled_len = 0;
+  linkaddr_copy(&frag_info[found].sender,
+                packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  timer_set(&frag_info[found].reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+#if SICSLOWPAN_FRAG_RECOVERY
+  frag_info[found].rfrag = 0;
+  frag_info[found].rfrag_bitmap = 0;
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
+  return found;
+}
+/*---------------------------------------------------------------------------*/
+/* add a new fragment to the buffer */
+static int8_t
+add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
+{
+  int i;
+  int len;
+  int8_t found = -1;
+
+  if(offset == 0) {
+    /* This is a first fragment - check if we can add this. The first
+       fragment can not be stored immediately but is moved into the
+       buffer while uncompressing. */
+    return new_context(tag, frag_size);
   }
 
   /* This is a N-fragment - should find the info */
   for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
     if(frag_info[i].tag == tag && frag_info[i].len > 0 &&
+#if SICSLOWPAN_FRAG_RECOVERY
+       !frag_info[i].rfrag &&
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
        linkaddr_cmp(&frag_info[i].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
       /* Tag and Sender match - this must be the correct info to store in */
       found = i;
@@ -398,10 +599,8 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
   }
 
   /* i is the index of the reassembly context */
-  len = store_fragment(i, offset);
-  if(len < 0 && timeout_fragments(i) > 0) {
-    len = store_fragment(i, offset);
-  }
+  len = store_fragment_or_timeout(i, offset, packetbuf_ptr + packetbuf_hdr_len,
+                                  packetbuf_datalen() - packetbuf_hdr_len);
   if(len > 0) {
     frag_info[i].reassembled_len += len;
     return i;
@@ -420,12 +619,16 @@ copy_frags2uip(int context)
 {
   int i;
 
+#if !SICSLOWPAN_FRAG_RECOVERY
   /* Copy from the fragment context info buffer first */
   memcpy((uint8_t *)UIP_IP_BUF, (uint8_t *)frag_info[context].first_frag,
 	 frag_info[context].first_frag_len);
+#endif /* !SICSLOWPAN_FRAG_RECOVERY */
   for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    /* And also copy all matching fragments */
-    if(frag_buf[i].len > 0 && frag_buf[i].index == context) {
+    /* Copy all matching fragments */
+    if(frag_buf[i].len > 0 && frag_buf[i].index == context &&
+       (uint16_t)(frag_buf[i].offset << 3) + frag_buf[i].len <=
+       UIP_BUFSIZE - UIP_LLH_LEN) {
       memcpy((uint8_t *)UIP_IP_BUF + (uint16_t)(frag_buf[i].offset << 3),
 	     (uint8_t *)frag_buf[i].data, frag_buf[i].len);
     }
@@ -630,6 +833,315 @@ uncompress_addr(uip_ipaddr_t *ipaddr, uint8_t const prefix[],
   PRINTF("\n");
 }
 
+#if SICSLOWPAN_6LORH
+/*--------------------------------------------------------------------*/
+/* Layout of the RPL option (RFC 6553) and source routing header
+   (RFC 6554) */
+#define LORH_RPI_HDR_LEN 8
+#define LORH_RPI_OPT_LEN 4
+#define LORH_SRH_HDR_LEN 8
+#define LORH_SRH_TYPE    3
+#define LORH_PROTO_IPV6  41
+
+/* The most IPHC uncompresses to: an IPv6 and a UDP header */
+#define LORH_IPHC_MAX_LEN (UIP_IPH_LEN + UIP_UDPH_LEN)
+/* The room for the uncompressed headers in uip_buf */
+#define LORH_BUF_SIZE (UIP_BUFSIZE - UIP_LLH_LEN)
+
+/* RH3-6LoRHs may take at most half of the first frame, to leave room
+   for IPHC */
+#define LORH_RH3_MAX_LEN ((MAC_MAX_PAYLOAD - SICSLOWPAN_FIXED_HDRLEN) / 2)
+
+/* The addresses of the source route being compressed or uncompressed */
+static uip_ipaddr_t lorh_hops[SICSLOWPAN_6LORH_MAX_HOPS + 1];
+/*--------------------------------------------------------------------*/
+static uint8_t
+lorh_matching_bytes(const uip_ipaddr_t *a, const uip_ipaddr_t *b)
+{
+  uint8_t i;
+
+  for(i = 0; i < 16 && a->u8[i] == b->u8[i]; i++);
+  return i;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Write a RPL source routing header
+ *
+ * The header lists the given addresses, each eliding the prefix that
+ * all of them share with the IPv6 destination. A receiver rebuilds
+ * exactly this header from an RH3-6LoRH, so a sender rewrites its own
+ * to this layout before compressing it.
+ *
+ * \param hdr Where to write the header, NULL to only get its length
+ * \return The length of the header
+ */
+static uint8_t
+lorh_srh_layout(uint8_t *hdr, uint8_t next, const uip_ipaddr_t *dest,
+                const uip_ipaddr_t *hops, uint8_t count)
+{
+  uint8_t i, cmpr, len, pad;
+
+  cmpr = 15;
+  for(i = 0; i < count; i++) {
+    cmpr = MIN(cmpr, lorh_matching_bytes(&hops[i], dest));
+  }
+  len = LORH_SRH_HDR_LEN + count * (16 - cmpr);
+  pad = (8 - (len & 7)) & 7;
+
+  if(hdr != NULL) {
+    memset(hdr, 0, len + pad);
+    hdr[0] = next;
+    hdr[1] = (len + pad - 8) / 8;
+    hdr[2] = LORH_SRH_TYPE;
+    hdr[3] = count; /* Segments left */
+    hdr[4] = (cmpr << 4) | cmpr;
+    hdr[5] = pad << 4;
+    for(i = 0; i < count; i++) {
+      memcpy(&hdr[LORH_SRH_HDR_LEN + i * (16 - cmpr)], &hops[i].u8[cmpr],
+             16 - cmpr);
+    }
+  }
+  return len + pad;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Read the addresses left to visit in a source routing header
+ *
+ * \return The number of addresses read into hops, -1 if the header is
+ * malformed or has too many of them
+ */
+static int
+lorh_srh_read(const uint8_t *hdr, const uip_ipaddr_t *dest,
+              uip_ipaddr_t *hops)
+{
+  uint8_t len, seg_left, cmpri, cmpre, pad, count, i, index, cmpr;
+
+  len = (hdr[1] + 1) * 8;
+  seg_left = hdr[3];
+  cmpri = hdr[4] >> 4;
+  cmpre = hdr[4] & 0x0f;
+  pad = hdr[5] >> 4;
+  if(len < LORH_SRH_HDR_LEN + pad + 16 - cmpre) {
+    return -1;
+  }
+  count = (len - LORH_SRH_HDR_LEN - pad - (16 - cmpre)) / (16 - cmpri) + 1;
+  if(seg_left > count || seg_left > SICSLOWPAN_6LORH_MAX_HOPS) {
+    return -1;
+  }
+
+  for(i = 0; i < seg_left; i++) {
+    index = count - seg_left + i;
+    cmpr = index == count - 1 ? cmpre : cmpri;
+    uip_ipaddr_copy(&hops[i], dest);
+    memcpy(&hops[i].u8[cmpr], &hdr[LORH_SRH_HDR_LEN + index * (16 - cmpri)],
+           16 - cmpr);
+  }
+  return seg_left;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Write RH3-6LoRHs for a list of addresses
+ *
+ * Each address is compressed against the one before it, the first
+ * against ref. Consecutive addresses that compress to the same size
+ * share one RH3-6LoRH.
+ *
+ * \param ptr Where to write the 6LoRHs, NULL to only get their length
+ * \return The length of the 6LoRHs
+ */
+static uint8_t
+lorh_rh3_write(uint8_t *ptr, const uip_ipaddr_t *ref,
+               const uip_ipaddr_t *hops, uint8_t count)
+{
+  uint8_t i, type, size, shared;
+  uint8_t *group = NULL;
+  uint8_t group_type = 0;
+  uint8_t group_count = 0;
+  uint8_t len = 0;
+
+  for(i = 0; i < count; i++) {
+    shared = lorh_matching_bytes(&hops[i], ref);
+    for(type = 0; type < SICSLOWPAN_6LORH_TYPE_RH3_MAX &&
+          16 - (1 << type) > shared; type++);
+    size = 1 << type;
+
+    if(i == 0 || type != group_type ||
+       group_count == SICSLOWPAN_6LORH_LEN_MASK + 1) {
+      group = ptr != NULL ? &ptr[len] : NULL;
+      group_type = type;
+      group_count = 0;
+      len += 2;
+    }
+    if(ptr != NULL) {
+      group[0] = SICSLOWPAN_6LORH_CRITICAL | group_count;
+      group[1] = type;
+      memcpy(&ptr[len], &hops[i].u8[16 - size], size);
+    }
+    group_count++;
+    len += size;
+    ref = &hops[i];
+  }
+  return len;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Compress the outer headers of uip_buf into 6LoRHs (RFC 8138)
+ *
+ * A RPL option, a RPL source routing header and, once both are dealt
+ * with, an IPv6-in-IPv6 outer header are written as 6LoRHs after a
+ * page 1 dispatch at the start of the compressed headers. Nothing is
+ * written if none of them is found.
+ *
+ * The RPL option is compressed when it is the only option of the
+ * hop-by-hop header. The source routing header is first rewritten with
+ * only the addresses left to visit, see lorh_srh_layout(). The outer
+ * IPv6 header is elided when it only carries a hop limit, an
+ * encapsulator address and a destination that the RH3-6LoRH lists
+ * first; the destination is omitted if the inner one is the same.
+ *
+ * \param buf Returns the IPv6 header that IPHC is to compress
+ * \param ext_len Returns the length of the extension headers between
+ * that header and the next one, which the 6LoRHs replace
+ * \param proto Returns the protocol of the header after them
+ */
+static void
+compress_hdr_6lorh(uint8_t **buf, uint8_t *ext_len, uint8_t *proto)
+{
+  uint8_t *ip = (uint8_t *)UIP_IP_BUF;
+  uint8_t *next_ptr = &UIP_IP_BUF->proto;
+  uint8_t *rpi = NULL;
+  uint8_t *srh = NULL;
+  uint8_t *lorh_ptr;
+  uint8_t srh_len = 0;
+  uint8_t srh_next = 0;
+  uint8_t encap = 0;
+  uint8_t next;
+  int count = -1;
+  int hops_count = 0;
+  uip_ipaddr_t *hops = &lorh_hops[1];
+  uip_ipaddr_t ref;
+  uint16_t off = UIP_IPH_LEN;
+
+  /* RPL option */
+  if(*next_ptr == UIP_PROTO_HBHO && uip_len >= off + LORH_RPI_HDR_LEN &&
+     ip[off + 1] == 0 && ip[off + 2] == UIP_EXT_HDR_OPT_RPL &&
+     ip[off + 3] == LORH_RPI_OPT_LEN && (ip[off + 4] & 0x1f) == 0) {
+    rpi = &ip[off];
+    next_ptr = rpi;
+    off += LORH_RPI_HDR_LEN;
+  }
+
+  /* Source routing header. Its addresses go in lorh_hops after the
+     first entry, which is kept for the destination of an outer header */
+  if(*next_ptr == UIP_PROTO_ROUTING && uip_len >= off + LORH_SRH_HDR_LEN &&
+     ip[off + 2] == LORH_SRH_TYPE &&
+     uip_len >= off + (ip[off + 1] + 1) * 8) {
+    srh = &ip[off];
+    srh_len = (srh[1] + 1) * 8;
+    srh_next = srh[0];
+    count = lorh_srh_read(srh, &UIP_IP_BUF->destipaddr, &lorh_hops[1]);
+    hops_count = MAX(count, 0);
+  }
+
+  /* IPv6-in-IPv6 */
+  next = count >= 0 ? srh_next : *next_ptr;
+  if(next == LORH_PROTO_IPV6 &&
+     uip_len >= off + (count >= 0 ? srh_len : 0) + UIP_IPH_LEN &&
+     UIP_IP_BUF->vtc == 0x60 && UIP_IP_BUF->tcflow == 0 &&
+     UIP_IP_BUF->flow == 0) {
+    encap = 1;
+    uip_ipaddr_copy(&ref, &UIP_IP_BUF->srcipaddr);
+    uip_ipaddr_copy(&lorh_hops[0], &UIP_IP_BUF->destipaddr);
+    if(count > 0 || !uip_ipaddr_cmp(&lorh_hops[0],
+         &SICSLOWPAN_IP_BUF(&ip[off + (count >= 0 ? srh_len : 0)])->destipaddr)) {
+      hops = &lorh_hops[0];
+      hops_count++;
+    }
+  } else {
+    uip_ipaddr_copy(&ref, &UIP_IP_BUF->destipaddr);
+  }
+
+  if(count > 0 && lorh_rh3_write(NULL, &ref, hops, hops_count) > LORH_RH3_MAX_LEN) {
+    /* Leave the source route inline */
+    count = -1;
+    encap = 0;
+    hops_count = 0;
+  }
+
+  if(rpi == NULL && count < 0 && !encap) {
+    return;
+  }
+
+  if(count >= 0) {
+    /* Rewrite the source routing header as it will be uncompressed,
+       or remove it if all its addresses have been visited */
+    uint8_t new_len = 0;
+
+    if(count > 0) {
+      new_len = lorh_srh_layout(NULL, srh_next, &UIP_IP_BUF->destipaddr,
+                                &lorh_hops[1], count);
+    }
+    memmove(srh + new_len, srh + srh_len, uip_len - (srh - ip) - srh_len);
+    if(count > 0) {
+      lorh_srh_layout(srh, srh_next, &UIP_IP_BUF->destipaddr,
+                      &lorh_hops[1], count);
+      next_ptr = srh;
+      off += new_len;
+    } else {
+      *next_ptr = srh_next;
+    }
+    uip_len = uip_len - srh_len + new_len;
+    UIP_IP_BUF->len[0] = (uip_len - UIP_IPH_LEN) >> 8;
+    UIP_IP_BUF->len[1] = (uip_len - UIP_IPH_LEN) & 0xff;
+  }
+
+  lorh_ptr = packetbuf_ptr + packetbuf_hdr_len;
+  *lorh_ptr++ = SICSLOWPAN_DISPATCH_PAGING_1;
+
+  if(encap) {
+    *lorh_ptr++ = SICSLOWPAN_6LORH_ELECTIVE | 17;
+    *lorh_ptr++ = SICSLOWPAN_6LORH_TYPE_IPINIP;
+    *lorh_ptr++ = UIP_IP_BUF->ttl;
+    memcpy(lorh_ptr, &UIP_IP_BUF->srcipaddr, 16);
+    lorh_ptr += 16;
+  }
+
+  lorh_ptr += lorh_rh3_write(lorh_ptr, &ref, hops, hops_count);
+
+  if(rpi != NULL) {
+    /* The O, R and F flags move from the top bits of the option */
+    uint8_t *flags = lorh_ptr;
+
+    *lorh_ptr++ = SICSLOWPAN_6LORH_CRITICAL | (rpi[4] >> 3);
+    *lorh_ptr++ = SICSLOWPAN_6LORH_TYPE_RPI;
+    if(rpi[5] == 0) {
+      /* Instance 0 is elided */
+      *flags |= SICSLOWPAN_6LORH_RPI_I;
+    } else {
+      *lorh_ptr++ = rpi[5];
+    }
+    *lorh_ptr++ = rpi[6];
+    if(rpi[7] == 0) {
+      /* The low-order byte of the rank is elided */
+      *flags |= SICSLOWPAN_6LORH_RPI_K;
+    } else {
+      *lorh_ptr++ = rpi[7];
+    }
+  }
+  packetbuf_hdr_len = lorh_ptr - packetbuf_ptr;
+
+  if(encap) {
+    /* IPHC compresses the inner header */
+    *buf = &ip[off];
+    *proto = SICSLOWPAN_IP_BUF(*buf)->proto;
+    uncomp_hdr_len = off;
+  } else {
+    *ext_len = off - UIP_IPH_LEN;
+    *proto = *next_ptr;
+  }
+}
+#endif /* SICSLOWPAN_6LORH */
+
 /*--------------------------------------------------------------------*/
 /**
  * \brief Compress IP/UDP header
@@ -659,6 +1171,8 @@ uncompress_addr(uip_ipaddr_t *ipaddr, uint8_t const prefix[],
  * | L4 data ...                                                   |
  * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  * \endverbatim
+ * \note With SICSLOWPAN_6LORH, the 6LoRHs written by compress_hdr_6lorh()
+ * come first, and IPHC compresses the IPv6 header they leave.
  * \note The context number 00 is reserved for the link local prefix.
  * For unicast addresses, if we cannot compress the prefix, we neither
  * compress the IID.
@@ -669,6 +1183,10 @@ static void
 compress_hdr_iphc(linkaddr_t *link_destaddr)
 {
   uint8_t tmp, iphc0, iphc1;
+  uint8_t *buf = (uint8_t *)UIP_IP_BUF;
+  uint8_t ext_len = 0;
+  uint8_t proto = UIP_IP_BUF->proto;
+  struct uip_udp_hdr *udp_buf;
 #if DEBUG
   { uint16_t ndx;
     PRINTF("before compression (%d): ", UIP_IP_BUF->len[1]);
@@ -680,7 +1198,12 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
   }
 #endif
 
-  hc06_ptr = packetbuf_ptr + 2;
+#if SICSLOWPAN_6LORH
+  compress_hdr_6lorh(&buf, &ext_len, &proto);
+#endif /* SICSLOWPAN_6LORH */
+  udp_buf = (struct uip_udp_hdr *)&buf[UIP_IPH_LEN + ext_len];
+
+  hc06_ptr = packetbuf_ptr + packetbuf_hdr_len + 2;
   /*
    * As we copy some bit-length fields, in the IPHC encoding bytes,
    * we sometimes use |=
@@ -702,8 +1225,8 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
   /* check if dest context exists (for allocating third byte) */
   /* TODO: fix this so that it remembers the looked up values for
      avoiding two lookups - or set the lookup values immediately */
-  if(addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr) != NULL ||
-     addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr) != NULL) {
+  if(addr_context_lookup_by_prefix(&SICSLOWPAN_IP_BUF(buf)->destipaddr) != NULL ||
+     addr_context_lookup_by_prefix(&SICSLOWPAN_IP_BUF(buf)->srcipaddr) != NULL) {
     /* set context flag and increase hc06_ptr */
     PRINTF("IPHC: compressing dest or src ipaddr - setting CID\n");
     iphc1 |= SICSLOWPAN_IPHC_CID;
@@ -719,15 +1242,15 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
 
   /* IPHC format of tc is ECN | DSCP , original is DSCP | ECN */
 
-  tmp = (UIP_IP_BUF->vtc << 4) | (UIP_IP_BUF->tcflow >> 4);
+  tmp = (SICSLOWPAN_IP_BUF(buf)->vtc << 4) | (SICSLOWPAN_IP_BUF(buf)->tcflow >> 4);
   tmp = ((tmp & 0x03) << 6) | (tmp >> 2);
 
-  if(((UIP_IP_BUF->tcflow & 0x0F) == 0) &&
-     (UIP_IP_BUF->flow == 0)) {
+  if(((SICSLOWPAN_IP_BUF(buf)->tcflow & 0x0F) == 0) &&
+     (SICSLOWPAN_IP_BUF(buf)->flow == 0)) {
     /* flow label can be compressed */
     iphc0 |= SICSLOWPAN_IPHC_FL_C;
-    if(((UIP_IP_BUF->vtc & 0x0F) == 0) &&
-       ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
+    if(((SICSLOWPAN_IP_BUF(buf)->vtc & 0x0F) == 0) &&
+       ((SICSLOWPAN_IP_BUF(buf)->tcflow & 0xF0) == 0)) {
       /* compress (elide) all */
       iphc0 |= SICSLOWPAN_IPHC_TC_C;
     } else {
@@ -737,17 +1260,17 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     }
   } else {
     /* Flow label cannot be compressed */
-    if(((UIP_IP_BUF->vtc & 0x0F) == 0) &&
-       ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
+    if(((SICSLOWPAN_IP_BUF(buf)->vtc & 0x0F) == 0) &&
+       ((SICSLOWPAN_IP_BUF(buf)->tcflow & 0xF0) == 0)) {
       /* compress only traffic class */
       iphc0 |= SICSLOWPAN_IPHC_TC_C;
       *hc06_ptr = (tmp & 0xc0) |
-        (UIP_IP_BUF->tcflow & 0x0F);
-      memcpy(hc06_ptr + 1, &UIP_IP_BUF->flow, 2);
+        (SICSLOWPAN_IP_BUF(buf)->tcflow & 0x0F);
+      memcpy(hc06_ptr + 1, &SICSLOWPAN_IP_BUF(buf)->flow, 2);
       hc06_ptr += 3;
     } else {
       /* compress nothing */
-      memcpy(hc06_ptr, &UIP_IP_BUF->vtc, 4);
+      memcpy(hc06_ptr, &SICSLOWPAN_IP_BUF(buf)->vtc, 4);
       /* but replace the top byte with the new ECN | DSCP format*/
       *hc06_ptr = tmp;
       hc06_ptr += 4;
@@ -758,13 +1281,13 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
 
   /* Next header. We compress it if UDP */
 #if UIP_CONF_UDP || UIP_CONF_ROUTER
-  if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
+  if(proto == UIP_PROTO_UDP) {
     iphc0 |= SICSLOWPAN_IPHC_NH_C;
   }
 #endif /*UIP_CONF_UDP*/
 
   if ((iphc0 & SICSLOWPAN_IPHC_NH_C) == 0) {
-    *hc06_ptr = UIP_IP_BUF->proto;
+    *hc06_ptr = proto;
     hc06_ptr += 1;
   }
 
@@ -775,7 +1298,7 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
    * if 255: compress, encoding is 11
    * else do not compress
    */
-  switch(UIP_IP_BUF->ttl) {
+  switch(SICSLOWPAN_IP_BUF(buf)->ttl) {
     case 1:
       iphc0 |= SICSLOWPAN_IPHC_TTL_1;
       break;
@@ -786,17 +1309,17 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
       iphc0 |= SICSLOWPAN_IPHC_TTL_255;
       break;
     default:
-      *hc06_ptr = UIP_IP_BUF->ttl;
+      *hc06_ptr = SICSLOWPAN_IP_BUF(buf)->ttl;
       hc06_ptr += 1;
       break;
   }
 
   /* source address - cannot be multicast */
-  if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+  if(uip_is_addr_unspecified(&SICSLOWPAN_IP_BUF(buf)->srcipaddr)) {
     PRINTF("IPHC: compressing unspecified - setting SAC\n");
     iphc1 |= SICSLOWPAN_IPHC_SAC;
     iphc1 |= SICSLOWPAN_IPHC_SAM_00;
-  } else if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr))
+  } else if((context = addr_context_lookup_by_prefix(&SICSLOWPAN_IP_BUF(buf)->srcipaddr))
      != NULL) {
     /* elide the prefix - indicate by CID and set context + SAC */
     PRINTF("IPHC: compressing src with context - setting CID & SAC ctx: %d\n",
@@ -806,121 +1329,121 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     /* compession compare with this nodes address (source) */
 
     iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_SAM_BIT,
-                              &UIP_IP_BUF->srcipaddr, &uip_lladdr);
+                              &SICSLOWPAN_IP_BUF(buf)->srcipaddr, &uip_lladdr);
     /* No context found for this address */
-  } else if(uip_is_addr_linklocal(&UIP_IP_BUF->srcipaddr) &&
-            UIP_IP_BUF->destipaddr.u16[1] == 0 &&
-            UIP_IP_BUF->destipaddr.u16[2] == 0 &&
-            UIP_IP_BUF->destipaddr.u16[3] == 0) {
+  } else if(uip_is_addr_linklocal(&SICSLOWPAN_IP_BUF(buf)->srcipaddr) &&
+            SICSLOWPAN_IP_BUF(buf)->destipaddr.u16[1] == 0 &&
+            SICSLOWPAN_IP_BUF(buf)->destipaddr.u16[2] == 0 &&
+            SICSLOWPAN_IP_BUF(buf)->destipaddr.u16[3] == 0) {
     iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_SAM_BIT,
-                              &UIP_IP_BUF->srcipaddr, &uip_lladdr);
+                              &SICSLOWPAN_IP_BUF(buf)->srcipaddr, &uip_lladdr);
   } else {
     /* send the full address => SAC = 0, SAM = 00 */
     iphc1 |= SICSLOWPAN_IPHC_SAM_00; /* 128-bits */
-    memcpy(hc06_ptr, &UIP_IP_BUF->srcipaddr.u16[0], 16);
+    memcpy(hc06_ptr, &SICSLOWPAN_IP_BUF(buf)->srcipaddr.u16[0], 16);
     hc06_ptr += 16;
   }
 
   /* dest address*/
-  if(uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
+  if(uip_is_addr_mcast(&SICSLOWPAN_IP_BUF(buf)->destipaddr)) {
     /* Address is multicast, try to compress */
     iphc1 |= SICSLOWPAN_IPHC_M;
-    if(sicslowpan_is_mcast_addr_compressable8(&UIP_IP_BUF->destipaddr)) {
+    if(sicslowpan_is_mcast_addr_compressable8(&SICSLOWPAN_IP_BUF(buf)->destipaddr)) {
       iphc1 |= SICSLOWPAN_IPHC_DAM_11;
       /* use last byte */
-      *hc06_ptr = UIP_IP_BUF->destipaddr.u8[15];
+      *hc06_ptr = SICSLOWPAN_IP_BUF(buf)->destipaddr.u8[15];
       hc06_ptr += 1;
-    } else if(sicslowpan_is_mcast_addr_compressable32(&UIP_IP_BUF->destipaddr)) {
+    } else if(sicslowpan_is_mcast_addr_compressable32(&SICSLOWPAN_IP_BUF(buf)->destipaddr)) {
       iphc1 |= SICSLOWPAN_IPHC_DAM_10;
       /* second byte + the last three */
-      *hc06_ptr = UIP_IP_BUF->destipaddr.u8[1];
-      memcpy(hc06_ptr + 1, &UIP_IP_BUF->destipaddr.u8[13], 3);
+      *hc06_ptr = SICSLOWPAN_IP_BUF(buf)->destipaddr.u8[1];
+      memcpy(hc06_ptr + 1, &SICSLOWPAN_IP_BUF(buf)->destipaddr.u8[13], 3);
       hc06_ptr += 4;
-    } else if(sicslowpan_is_mcast_addr_compressable48(&UIP_IP_BUF->destipaddr)) {
+    } else if(sicslowpan_is_mcast_addr_compressable48(&SICSLOWPAN_IP_BUF(buf)->destipaddr)) {
       iphc1 |= SICSLOWPAN_IPHC_DAM_01;
       /* second byte + the last five */
-      *hc06_ptr = UIP_IP_BUF->destipaddr.u8[1];
-      memcpy(hc06_ptr + 1, &UIP_IP_BUF->destipaddr.u8[11], 5);
+      *hc06_ptr = SICSLOWPAN_IP_BUF(buf)->destipaddr.u8[1];
+      memcpy(hc06_ptr + 1, &SICSLOWPAN_IP_BUF(buf)->destipaddr.u8[11], 5);
       hc06_ptr += 6;
     } else {
       iphc1 |= SICSLOWPAN_IPHC_DAM_00;
       /* full address */
-      memcpy(hc06_ptr, &UIP_IP_BUF->destipaddr.u8[0], 16);
+      memcpy(hc06_ptr, &SICSLOWPAN_IP_BUF(buf)->destipaddr.u8[0], 16);
       hc06_ptr += 16;
     }
   } else {
     /* Address is unicast, try to compress */
-    if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr)) != NULL) {
+    if((context = addr_context_lookup_by_prefix(&SICSLOWPAN_IP_BUF(buf)->destipaddr)) != NULL) {
       /* elide the prefix */
       iphc1 |= SICSLOWPAN_IPHC_DAC;
       PACKETBUF_IPHC_BUF[2] |= context->number;
       /* compession compare with link adress (destination) */
 
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
-                                &UIP_IP_BUF->destipaddr,
+                                &SICSLOWPAN_IP_BUF(buf)->destipaddr,
                                 (uip_lladdr_t *)link_destaddr);
       /* No context found for this address */
-    } else if(uip_is_addr_linklocal(&UIP_IP_BUF->destipaddr) &&
-              UIP_IP_BUF->destipaddr.u16[1] == 0 &&
-              UIP_IP_BUF->destipaddr.u16[2] == 0 &&
-              UIP_IP_BUF->destipaddr.u16[3] == 0) {
+    } else if(uip_is_addr_linklocal(&SICSLOWPAN_IP_BUF(buf)->destipaddr) &&
+              SICSLOWPAN_IP_BUF(buf)->destipaddr.u16[1] == 0 &&
+              SICSLOWPAN_IP_BUF(buf)->destipaddr.u16[2] == 0 &&
+              SICSLOWPAN_IP_BUF(buf)->destipaddr.u16[3] == 0) {
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
-               &UIP_IP_BUF->destipaddr, (uip_lladdr_t *)link_destaddr);
+               &SICSLOWPAN_IP_BUF(buf)->destipaddr, (uip_lladdr_t *)link_destaddr);
     } else {
       /* send the full address */
       iphc1 |= SICSLOWPAN_IPHC_DAM_00; /* 128-bits */
-      memcpy(hc06_ptr, &UIP_IP_BUF->destipaddr.u16[0], 16);
+      memcpy(hc06_ptr, &SICSLOWPAN_IP_BUF(buf)->destipaddr.u16[0], 16);
       hc06_ptr += 16;
     }
   }
 
-  uncomp_hdr_len = UIP_IPH_LEN;
+  uncomp_hdr_len += UIP_IPH_LEN + ext_len;
 
 #if UIP_CONF_UDP || UIP_CONF_ROUTER
   /* UDP header compression */
-  if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
+  if(proto == UIP_PROTO_UDP) {
     PRINTF("IPHC: Uncompressed UDP ports on send side: %x, %x\n",
-           UIP_HTONS(UIP_UDP_BUF->srcport), UIP_HTONS(UIP_UDP_BUF->destport));
+           UIP_HTONS(udp_buf->srcport), UIP_HTONS(udp_buf->destport));
     /* Mask out the last 4 bits can be used as a mask */
-    if(((UIP_HTONS(UIP_UDP_BUF->srcport) & 0xfff0) == SICSLOWPAN_UDP_4_BIT_PORT_MIN) &&
-       ((UIP_HTONS(UIP_UDP_BUF->destport) & 0xfff0) == SICSLOWPAN_UDP_4_BIT_PORT_MIN)) {
+    if(((UIP_HTONS(udp_buf->srcport) & 0xfff0) == SICSLOWPAN_UDP_4_BIT_PORT_MIN) &&
+       ((UIP_HTONS(udp_buf->destport) & 0xfff0) == SICSLOWPAN_UDP_4_BIT_PORT_MIN)) {
       /* we can compress 12 bits of both source and dest */
       *hc06_ptr = SICSLOWPAN_NHC_UDP_CS_P_11;
       PRINTF("IPHC: remove 12 b of both source & dest with prefix 0xFOB\n");
       *(hc06_ptr + 1) =
-        (uint8_t)((UIP_HTONS(UIP_UDP_BUF->srcport) -
+        (uint8_t)((UIP_HTONS(udp_buf->srcport) -
                    SICSLOWPAN_UDP_4_BIT_PORT_MIN) << 4) +
-        (uint8_t)((UIP_HTONS(UIP_UDP_BUF->destport) -
+        (uint8_t)((UIP_HTONS(udp_buf->destport) -
                    SICSLOWPAN_UDP_4_BIT_PORT_MIN));
       hc06_ptr += 2;
-    } else if((UIP_HTONS(UIP_UDP_BUF->destport) & 0xff00) == SICSLOWPAN_UDP_8_BIT_PORT_MIN) {
+    } else if((UIP_HTONS(udp_buf->destport) & 0xff00) == SICSLOWPAN_UDP_8_BIT_PORT_MIN) {
       /* we can compress 8 bits of dest, leave source. */
       *hc06_ptr = SICSLOWPAN_NHC_UDP_CS_P_01;
       PRINTF("IPHC: leave source, remove 8 bits of dest with prefix 0xF0\n");
-      memcpy(hc06_ptr + 1, &UIP_UDP_BUF->srcport, 2);
+      memcpy(hc06_ptr + 1, &udp_buf->srcport, 2);
       *(hc06_ptr + 3) =
-        (uint8_t)((UIP_HTONS(UIP_UDP_BUF->destport) -
+        (uint8_t)((UIP_HTONS(udp_buf->destport) -
                    SICSLOWPAN_UDP_8_BIT_PORT_MIN));
       hc06_ptr += 4;
-    } else if((UIP_HTONS(UIP_UDP_BUF->srcport) & 0xff00) == SICSLOWPAN_UDP_8_BIT_PORT_MIN) {
+    } else if((UIP_HTONS(udp_buf->srcport) & 0xff00) == SICSLOWPAN_UDP_8_BIT_PORT_MIN) {
       /* we can compress 8 bits of src, leave dest. Copy compressed port */
       *hc06_ptr = SICSLOWPAN_NHC_UDP_CS_P_10;
       PRINTF("IPHC: remove 8 bits of source with prefix 0xF0, leave dest. hch: %i\n", *hc06_ptr);
       *(hc06_ptr + 1) =
-        (uint8_t)((UIP_HTONS(UIP_UDP_BUF->srcport) -
+        (uint8_t)((UIP_HTONS(udp_buf->srcport) -
                    SICSLOWPAN_UDP_8_BIT_PORT_MIN));
-      memcpy(hc06_ptr + 2, &UIP_UDP_BUF->destport, 2);
+      memcpy(hc06_ptr + 2, &udp_buf->destport, 2);
       hc06_ptr += 4;
     } else {
       /* we cannot compress. Copy uncompressed ports, full checksum  */
       *hc06_ptr = SICSLOWPAN_NHC_UDP_CS_P_00;
       PRINTF("IPHC: cannot compress headers\n");
-      memcpy(hc06_ptr + 1, &UIP_UDP_BUF->srcport, 4);
+      memcpy(hc06_ptr + 1, &udp_buf->srcport, 4);
       hc06_ptr += 5;
     }
     /* always inline the checksum  */
     if(1) {
-      memcpy(hc06_ptr, &UIP_UDP_BUF->udpchksum, 2);
+      memcpy(hc06_ptr, &udp_buf->udpchksum, 2);
       hc06_ptr += 2;
     }
     uncomp_hdr_len += UIP_UDPH_LEN;
@@ -1185,6 +1708,214 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
 
   return;
 }
+#if SICSLOWPAN_6LORH
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Read the addresses of consecutive RH3-6LoRHs into lorh_hops
+ *
+ * \return The number of addresses, -1 if more than max
+ */
+static int
+lorh_rh3_read(const uint8_t *ptr, const uint8_t *end,
+              const uip_ipaddr_t *ref, uint8_t max)
+{
+  uint8_t count = 0;
+  uint8_t n, size;
+
+  while(ptr < end) {
+    n = (ptr[0] & SICSLOWPAN_6LORH_LEN_MASK) + 1;
+    size = 1 << ptr[1];
+    ptr += 2;
+    while(n-- > 0) {
+      if(count == max) {
+        return -1;
+      }
+      uip_ipaddr_copy(&lorh_hops[count], ref);
+      memcpy(&lorh_hops[count].u8[16 - size], ptr, size);
+      ref = &lorh_hops[count];
+      ptr += size;
+      count++;
+    }
+  }
+  return count;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Uncompress 6LoRHs (RFC 8138) and the IPHC header after them
+ *
+ * This function is called by the input function when the dispatch is
+ * page 1. The IPHC header is uncompressed with uncompress_hdr_iphc(),
+ * and the headers the 6LoRHs stand for are put back around it: the
+ * outer IPv6 header, the RPL option and the source routing header,
+ * see compress_hdr_6lorh(). Unknown elective 6LoRHs are skipped.
+ *
+ * \param buf Pointer to the buffer to uncompress the packet into.
+ * \param ip_len Equal to 0 if the packet is not a fragment, the size
+ * of the datagram if it is a 1st fragment.
+ * \return 1 on success, 0 if the packet is to be dropped, e.g. if
+ * the uncompressed headers do not fit in uip_buf
+ */
+static int
+uncompress_hdr_6lorh(uint8_t *buf, uint16_t ip_len)
+{
+  uint8_t *ptr, *end;
+  uint8_t *encap = NULL;
+  uint8_t *rpi = NULL;
+  uint8_t *rh3 = NULL;
+  uint8_t *rh3_end = NULL;
+  uint8_t *hdr;
+  uint8_t len, next, srh_len;
+  uint8_t ext_len = 0;
+  uint8_t udp;
+  uint16_t total;
+  int count = 0;
+  uip_ipaddr_t ref;
+  uip_ipaddr_t *dest;
+  uip_ipaddr_t *hops = lorh_hops;
+  struct uip_ip_hdr *inner;
+
+  ptr = packetbuf_ptr + packetbuf_hdr_len + 1;
+  end = packetbuf_ptr + packetbuf_datalen();
+  while(ptr + 2 <= end && (ptr[0] & 0xc0) == SICSLOWPAN_6LORH_CRITICAL) {
+    if((ptr[0] & SICSLOWPAN_6LORH_MASK) == SICSLOWPAN_6LORH_ELECTIVE) {
+      len = ptr[0] & SICSLOWPAN_6LORH_LEN_MASK;
+      if(ptr[1] == SICSLOWPAN_6LORH_TYPE_IPINIP) {
+        if(len != 17) {
+          PRINTFI("6LoRH: unsupported encapsulator address\n");
+          return 0;
+        }
+        encap = ptr;
+      }
+    } else if(ptr[1] <= SICSLOWPAN_6LORH_TYPE_RH3_MAX) {
+      if(rh3_end != NULL && rh3_end != ptr) {
+        PRINTFI("6LoRH: split RH3\n");
+        return 0;
+      }
+      if(rh3 == NULL) {
+        rh3 = ptr;
+      }
+      len = ((ptr[0] & SICSLOWPAN_6LORH_LEN_MASK) + 1) << ptr[1];
+      rh3_end = ptr + 2 + len;
+    } else if(ptr[1] == SICSLOWPAN_6LORH_TYPE_RPI) {
+      rpi = ptr;
+      len = ((ptr[0] & SICSLOWPAN_6LORH_RPI_I) ? 0 : 1) +
+        ((ptr[0] & SICSLOWPAN_6LORH_RPI_K) ? 1 : 2);
+    } else {
+      PRINTFI("6LoRH: unknown critical type %u\n", ptr[1]);
+      return 0;
+    }
+    ptr += 2 + len;
+  }
+  if(ptr + 2 > end || (ptr[0] & 0xe0) != SICSLOWPAN_DISPATCH_IPHC) {
+    PRINTFI("6LoRH: no IPHC header\n");
+    return 0;
+  }
+  packetbuf_hdr_len = ptr - packetbuf_ptr;
+
+  if(encap != NULL) {
+    /* The outer header, then the extension headers, then the inner
+       header that IPHC compressed */
+    memcpy(&ref, &encap[3], 16);
+    if(rh3 != NULL) {
+      count = lorh_rh3_read(rh3, rh3_end, &ref,
+                            SICSLOWPAN_6LORH_MAX_HOPS + 1);
+    }
+    if(count < 0) {
+      return 0;
+    }
+    dest = &lorh_hops[0];
+    if(count > 0) {
+      hops++;
+      count--;
+    }
+    srh_len = count > 0 ? lorh_srh_layout(NULL, 0, dest, hops, count) : 0;
+    ext_len = (rpi != NULL ? LORH_RPI_HDR_LEN : 0) + srh_len;
+    if(UIP_IPH_LEN + ext_len + LORH_IPHC_MAX_LEN > LORH_BUF_SIZE) {
+      PRINTFI("6LoRH: headers do not fit in uip_buf\n");
+      return 0;
+    }
+    uncomp_hdr_len = UIP_IPH_LEN + ext_len;
+    uncompress_hdr_iphc(buf + uncomp_hdr_len, ip_len);
+    udp = uncomp_hdr_len == UIP_IPH_LEN + ext_len + UIP_IPH_LEN + UIP_UDPH_LEN;
+
+    inner = (struct uip_ip_hdr *)&buf[UIP_IPH_LEN + ext_len];
+    if(rh3 == NULL) {
+      uip_ipaddr_copy(&lorh_hops[0], &inner->destipaddr);
+    }
+    SICSLOWPAN_IP_BUF(buf)->vtc = 0x60;
+    SICSLOWPAN_IP_BUF(buf)->tcflow = 0;
+    SICSLOWPAN_IP_BUF(buf)->flow = 0;
+    SICSLOWPAN_IP_BUF(buf)->ttl = encap[2];
+    memcpy(&SICSLOWPAN_IP_BUF(buf)->srcipaddr, &encap[3], 16);
+    uip_ipaddr_copy(&SICSLOWPAN_IP_BUF(buf)->destipaddr, dest);
+    next = LORH_PROTO_IPV6;
+  } else {
+    /* The extension headers go between the IPv6 header and the one
+       IPHC may have uncompressed after it */
+    uncompress_hdr_iphc(buf, ip_len);
+    udp = uncomp_hdr_len == UIP_IPH_LEN + UIP_UDPH_LEN;
+    dest = &SICSLOWPAN_IP_BUF(buf)->destipaddr;
+    if(rh3 != NULL) {
+      count = lorh_rh3_read(rh3, rh3_end, dest, SICSLOWPAN_6LORH_MAX_HOPS);
+    }
+    if(count < 0) {
+      return 0;
+    }
+    srh_len = count > 0 ? lorh_srh_layout(NULL, 0, dest, hops, count) : 0;
+    ext_len = (rpi != NULL ? LORH_RPI_HDR_LEN : 0) + srh_len;
+    if(uncomp_hdr_len + ext_len > LORH_BUF_SIZE) {
+      PRINTFI("6LoRH: headers do not fit in uip_buf\n");
+      return 0;
+    }
+    memmove(buf + UIP_IPH_LEN + ext_len, buf + UIP_IPH_LEN,
+            uncomp_hdr_len - UIP_IPH_LEN);
+    uncomp_hdr_len += ext_len;
+    inner = SICSLOWPAN_IP_BUF(buf);
+    next = inner->proto;
+  }
+
+  hdr = buf + UIP_IPH_LEN;
+  SICSLOWPAN_IP_BUF(buf)->proto = rpi != NULL ? UIP_PROTO_HBHO :
+    (srh_len > 0 ? UIP_PROTO_ROUTING : next);
+  if(rpi != NULL) {
+    ptr = rpi + 2;
+    hdr[0] = srh_len > 0 ? UIP_PROTO_ROUTING : next;
+    hdr[1] = 0;
+    hdr[2] = UIP_EXT_HDR_OPT_RPL;
+    hdr[3] = LORH_RPI_OPT_LEN;
+    hdr[4] = (rpi[0] & (SICSLOWPAN_6LORH_RPI_O | SICSLOWPAN_6LORH_RPI_R |
+                        SICSLOWPAN_6LORH_RPI_F)) << 3;
+    hdr[5] = (rpi[0] & SICSLOWPAN_6LORH_RPI_I) ? 0 : *ptr++;
+    hdr[6] = *ptr++;
+    hdr[7] = (rpi[0] & SICSLOWPAN_6LORH_RPI_K) ? 0 : *ptr++;
+    hdr += LORH_RPI_HDR_LEN;
+  }
+  if(srh_len > 0) {
+    lorh_srh_layout(hdr, next, dest, hops, count);
+  }
+
+  /* Length fields, from the size of the whole datagram */
+  if(ip_len == 0) {
+    total = packetbuf_datalen() - packetbuf_hdr_len + uncomp_hdr_len;
+  } else {
+    total = ip_len;
+  }
+  SICSLOWPAN_IP_BUF(buf)->len[0] = (total - UIP_IPH_LEN) >> 8;
+  SICSLOWPAN_IP_BUF(buf)->len[1] = (total - UIP_IPH_LEN) & 0xff;
+  total -= UIP_IPH_LEN + ext_len;
+  if(encap != NULL) {
+    total -= UIP_IPH_LEN;
+    inner->len[0] = total >> 8;
+    inner->len[1] = total & 0xff;
+  }
+  if(udp) {
+    /* LOWPAN_UDP elided the UDP length */
+    ((struct uip_udp_hdr *)&buf[uncomp_hdr_len - UIP_UDPH_LEN])->udplen =
+      UIP_HTONS(total);
+  }
+  return 1;
+}
+#endif /* SICSLOWPAN_6LORH */
 /** @} */
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
 
@@ -1235,12 +1966,12 @@ packet_sent(void *ptr, int status, int transmissions)
 }
 /*--------------------------------------------------------------------*/
 /**
- * \brief This function is called by the 6lowpan code to send out a
- * packet.
+ * \brief Send out the packet in packetbuf
  * \param dest the link layer destination address of the packet
+ * \param sent the function to call with the result of the transmission
  */
 static void
-send_packet(linkaddr_t *dest)
+send_frame(linkaddr_t *dest, mac_callback_t sent)
 {
   /* Set the link layer destination address for the packet as a
    * packetbuf attribute. The MAC layer can access the destination
@@ -1255,13 +1986,649 @@ send_packet(linkaddr_t *dest)
 
   /* Provide a callback function to receive the result of
      a packet transmission. */
-  NETSTACK_LLSEC.send(&packet_sent, NULL);
+  NETSTACK_LLSEC.send(sent, NULL);
 
   /* If we are sending multiple packets in a row, we need to let the
      watchdog know that we are still alive. */
   watchdog_periodic();
 }
 /*--------------------------------------------------------------------*/
+/**
+ * \brief This function is called by the 6lowpan code to send out a
+ * packet.
+ * \param dest the link layer destination address of the packet
+ */
+static void
+send_packet(linkaddr_t *dest)
+{
+  send_frame(dest, packet_sent);
+}
+#if SICSLOWPAN_FRAG_RECOVERY
+/*--------------------------------------------------------------------*/
+/** \name Selective fragment recovery
+ * @{
+ */
+
+/* The longest compressed header that can be carried by a first fragment */
+#define RFRAG_MAX_HDR_LEN (SICSLOWPAN_IPV6_HDR_LEN + UIP_IPH_LEN + UIP_UDPH_LEN)
+
+/** The datagram being sent with recoverable fragments */
+static struct {
+  /** Link-layer destination of the fragments */
+  linkaddr_t dest;
+  /** Timer to request an RFRAG-ACK when none arrives */
+  struct ctimer timer;
+  /** Length of the uncompressed datagram */
+  uint16_t len;
+  /** Payload length of the first and of the following fragments */
+  uint16_t first_payload_len;
+  uint16_t payload_len;
+  /** Length of the headers before and after compression */
+  uint8_t uncomp_hdr_len;
+  uint8_t hdr_len;
+  /** Number of fragments */
+  uint8_t count;
+  uint8_t tag;
+  /** Number of recovery rounds so far */
+  uint8_t retries;
+  /** Non-zero until the datagram is acknowledged or given up */
+  uint8_t busy;
+  /** Compressed headers */
+  uint8_t hdr[RFRAG_MAX_HDR_LEN];
+  /** Packetbuf attributes of the datagram, for each fragment */
+  struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
+  struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+  /** Uncompressed datagram */
+  uint8_t data[UIP_BUFSIZE - UIP_LLH_LEN];
+} rfrag_out;
+
+static uint8_t rfrag_tag;
+
+/** Recently reassembled datagrams */
+static struct {
+  linkaddr_t sender;
+  struct timer timer;
+  uint8_t tag;
+} rfrag_done[SICSLOWPAN_REASS_CONTEXTS];
+static uint8_t rfrag_done_next;
+/*--------------------------------------------------------------------*/
+/* Give up the datagram in rfrag_out */
+static void
+rfrag_abort(void)
+{
+  ctimer_stop(&rfrag_out.timer);
+  rfrag_out.busy = 0;
+}
+/*--------------------------------------------------------------------*/
+/* The MAC reports each fragment here. A fragment that did not get
+   through is sent again after the next RFRAG-ACK, but the datagram is
+   given up if the MAC can never send it. */
+static void
+rfrag_packet_sent(void *ptr, int status, int transmissions)
+{
+  packet_sent(ptr, status, transmissions);
+
+  if(status == MAC_TX_ERR_FATAL && rfrag_out.busy) {
+    PRINTFO("sicslowpan output: RFRAG tag %d can not be sent, giving up\n",
+            rfrag_out.tag);
+    rfrag_abort();
+  }
+}
+/*--------------------------------------------------------------------*/
+/** \brief Send a fragment of the datagram in rfrag_out
+ *  \param seq the sequence number of the fragment
+ *  \param ack_request non-zero to request an RFRAG-ACK
+ *  \return 0 if the MAC refused the fragment, 1 otherwise
+ */
+static int
+rfrag_send(uint8_t seq, uint8_t ack_request)
+{
+  uint16_t offset;
+  uint16_t len;
+
+  packetbuf_clear();
+  packetbuf_attr_copyfrom(rfrag_out.attrs, rfrag_out.addrs);
+  packetbuf_ptr = packetbuf_dataptr();
+
+  if(seq == 0) {
+    /* The first fragment carries the datagram size in place of the
+       offset, followed by the compressed headers */
+    offset = rfrag_out.len;
+    len = rfrag_out.hdr_len + rfrag_out.first_payload_len;
+    memcpy(packetbuf_ptr + SICSLOWPAN_RFRAG_HDR_LEN,
+           rfrag_out.hdr, rfrag_out.hdr_len);
+    memcpy(packetbuf_ptr + SICSLOWPAN_RFRAG_HDR_LEN + rfrag_out.hdr_len,
+           rfrag_out.data + rfrag_out.uncomp_hdr_len,
+           rfrag_out.first_payload_len);
+  } else {
+    /* The offset of the following fragments is in bytes of the
+       uncompressed datagram */
+    offset = rfrag_out.uncomp_hdr_len + rfrag_out.first_payload_len +
+      (seq - 1) * rfrag_out.payload_len;
+    len = MIN(rfrag_out.payload_len, rfrag_out.len - offset);
+    memcpy(packetbuf_ptr + SICSLOWPAN_RFRAG_HDR_LEN,
+           rfrag_out.data + offset, len);
+  }
+
+  PACKETBUF_FRAG_PTR[PACKETBUF_RFRAG_DISPATCH] = SICSLOWPAN_DISPATCH_RFRAG;
+  PACKETBUF_FRAG_PTR[PACKETBUF_RFRAG_TAG] = rfrag_out.tag;
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_RFRAG_SEQ_SIZE,
+        (ack_request ? 0x8000 : 0) | (seq << 10) | len);
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_RFRAG_OFFSET, offset);
+  packetbuf_set_datalen(SICSLOWPAN_RFRAG_HDR_LEN + len);
+
+  PRINTFO("sicslowpan output: RFRAG (tag %d, seq %d, offset %d, len %d%s)\n",
+          rfrag_out.tag, seq, seq == 0 ? 0 : offset, len,
+          ack_request ? ", ack request" : "");
+
+  /* Reset last tx status to ok in case the transmission is deferred */
+  last_tx_status = MAC_TX_OK;
+  send_frame(&rfrag_out.dest, rfrag_packet_sent);
+  return last_tx_status != MAC_TX_COLLISION &&
+    last_tx_status != MAC_TX_ERR &&
+    last_tx_status != MAC_TX_ERR_FATAL;
+}
+/*--------------------------------------------------------------------*/
+static void
+rfrag_timeout(void *ptr)
+{
+  if(++rfrag_out.retries > SICSLOWPAN_FRAG_RECOVERY_MAX_RETRIES) {
+    PRINTFO("sicslowpan output: RFRAG tag %d not acknowledged, giving up\n",
+            rfrag_out.tag);
+    rfrag_abort();
+    return;
+  }
+  /* Ask for the state of the reassembly, with the last fragment */
+  rfrag_send(rfrag_out.count - 1, 1);
+  if(rfrag_out.busy) {
+    ctimer_restart(&rfrag_out.timer);
+  }
+}
+/*--------------------------------------------------------------------*/
+/** \brief Send the current packet in uip_buf as recoverable fragments
+ *  \param dest the link-layer destination
+ *  \param max_payload the space available in a frame
+ *  \return 1 if the packet was sent, 0 if it must be sent otherwise,
+ *  -1 if it was dropped
+ *
+ *  The compressed headers of the packet are at the start of packetbuf.
+ *  Fragments that the MAC refuses are sent in the next recovery round.
+ */
+static int
+rfrag_output(const linkaddr_t *dest, int max_payload)
+{
+  int first_payload_len;
+  int payload_len;
+  int count;
+  uint8_t seq;
+
+  if(rfrag_out.busy ||
+     packetbuf_hdr_len > RFRAG_MAX_HDR_LEN ||
+     uip_len > sizeof(rfrag_out.data)) {
+    return 0;
+  }
+
+  first_payload_len = (max_payload - SICSLOWPAN_RFRAG_HDR_LEN - packetbuf_hdr_len) & ~7;
+  payload_len = (max_payload - SICSLOWPAN_RFRAG_HDR_LEN) & ~7;
+  if(first_payload_len <= 0 || payload_len <= 0) {
+    return 0;
+  }
+  count = 1 + (uip_len - uncomp_hdr_len - first_payload_len + payload_len - 1) / payload_len;
+  if(count > 32) {
+    /* The RFRAG-ACK bitmap only covers 32 fragments */
+    return 0;
+  }
+
+  linkaddr_copy(&rfrag_out.dest, dest);
+  rfrag_out.len = uip_len;
+  rfrag_out.first_payload_len = first_payload_len;
+  rfrag_out.payload_len = payload_len;
+  rfrag_out.uncomp_hdr_len = uncomp_hdr_len;
+  rfrag_out.hdr_len = packetbuf_hdr_len;
+  rfrag_out.count = count;
+  rfrag_out.tag = rfrag_tag++;
+  rfrag_out.retries = 0;
+  rfrag_out.busy = 1;
+  memcpy(rfrag_out.hdr, packetbuf_ptr, packetbuf_hdr_len);
+  memcpy(rfrag_out.data, UIP_IP_BUF, uip_len);
+  /* The attributes set by output(), e.g. for the MAC to classify
+     traffic, also apply to fragments sent again later */
+  packetbuf_attr_copyto(rfrag_out.attrs, rfrag_out.addrs);
+
+  PRINTFO("sicslowpan output: %d recoverable fragments, tag %d\n",
+          count, rfrag_out.tag);
+
+  for(seq = 0; seq < rfrag_out.count; seq++) {
+    if(!rfrag_send(seq, seq == rfrag_out.count - 1)) {
+      PRINTFO("sicslowpan output: error in fragment tx, deferring subsequent fragments\n");
+      break;
+    }
+  }
+  if(!rfrag_out.busy) {
+    return -1;
+  }
+  ctimer_set(&rfrag_out.timer, SICSLOWPAN_FRAG_RECOVERY_ACK_TIMEOUT,
+             rfrag_timeout, NULL);
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+/* Process an RFRAG-ACK for the datagram in rfrag_out */
+static void
+rfrag_ack_input(void)
+{
+  uint32_t bitmap;
+  uint8_t seq;
+  uint8_t last;
+
+  if(packetbuf_datalen() < SICSLOWPAN_RFRAG_ACK_HDR_LEN) {
+    return;
+  }
+  if(!rfrag_out.busy ||
+     PACKETBUF_FRAG_PTR[PACKETBUF_RFRAG_TAG] != rfrag_out.tag ||
+     !linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_SENDER), &rfrag_out.dest)) {
+    PRINTFI("sicslowpan input: RFRAG-ACK for unknown tag %d\n",
+            PACKETBUF_FRAG_PTR[PACKETBUF_RFRAG_TAG]);
+    return;
+  }
+
+  bitmap = ((uint32_t)GET16(PACKETBUF_FRAG_PTR, PACKETBUF_RFRAG_ACK_BITMAP) << 16) |
+    GET16(PACKETBUF_FRAG_PTR, PACKETBUF_RFRAG_ACK_BITMAP + 2);
+  PRINTFI("sicslowpan input: RFRAG-ACK tag %d bitmap %08lx\n",
+          rfrag_out.tag, (unsigned long)bitmap);
+
+  /* Find the last fragment that the receiver misses */
+  last = rfrag_out.count;
+  for(seq = 0; seq < rfrag_out.count; seq++) {
+    if((bitmap & RFRAG_BIT(seq)) == 0) {
+      last = seq;
+    }
+  }
+
+  if(bitmap == RFRAG_BITMAP_FULL || bitmap == RFRAG_BITMAP_NULL ||
+     last == rfrag_out.count ||
+     ++rfrag_out.retries > SICSLOWPAN_FRAG_RECOVERY_MAX_RETRIES) {
+    /* The datagram was reassembled, aborted by the receiver, or is
+       not going to make it */
+    rfrag_abort();
+    return;
+  }
+
+  /* Send the missing fragments again. If the MAC refuses one, the
+     next round sends the rest. */
+  for(seq = 0; seq <= last; seq++) {
+    if((bitmap & RFRAG_BIT(seq)) == 0 && !rfrag_send(seq, seq == last)) {
+      break;
+    }
+  }
+  if(rfrag_out.busy) {
+    ctimer_restart(&rfrag_out.timer);
+  }
+}
+/*--------------------------------------------------------------------*/
+/* Acknowledge the fragments of a datagram that have been received */
+static void
+rfrag_ack_output(const linkaddr_t *sender, uint8_t tag, uint32_t bitmap)
+{
+  linkaddr_t dest;
+
+  linkaddr_copy(&dest, sender);
+  packetbuf_clear();
+  packetbuf_ptr = packetbuf_dataptr();
+  PACKETBUF_FRAG_PTR[PACKETBUF_RFRAG_DISPATCH] = SICSLOWPAN_DISPATCH_RFRAG_ACK;
+  PACKETBUF_FRAG_PTR[PACKETBUF_RFRAG_TAG] = tag;
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_RFRAG_ACK_BITMAP, bitmap >> 16);
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_RFRAG_ACK_BITMAP + 2, bitmap & 0xffff);
+  packetbuf_set_datalen(SICSLOWPAN_RFRAG_ACK_HDR_LEN);
+  PRINTFI("sicslowpan input: RFRAG-ACK tag %d bitmap %08lx\n",
+          tag, (unsigned long)bitmap);
+  send_packet(&dest);
+}
+/*--------------------------------------------------------------------*/
+/* Remember a reassembled datagram. If the acknowledgment of the last
+   fragment is lost, the sender sends fragments of it again; these are
+   then acknowledged without starting a new reassembly. */
+static void
+rfrag_done_add(const linkaddr_t *sender, uint8_t tag)
+{
+  linkaddr_copy(&rfrag_done[rfrag_done_next].sender, sender);
+  rfrag_done[rfrag_done_next].tag = tag;
+  timer_set(&rfrag_done[rfrag_done_next].timer,
+            SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+  rfrag_done_next = (rfrag_done_next + 1) % SICSLOWPAN_REASS_CONTEXTS;
+}
+/*--------------------------------------------------------------------*/
+static int
+rfrag_done_lookup(const linkaddr_t *sender, uint8_t tag)
+{
+  int i;
+
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    if(rfrag_done[i].tag == tag && !timer_expired(&rfrag_done[i].timer) &&
+       linkaddr_cmp(&rfrag_done[i].sender, sender)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*--------------------------------------------------------------------*/
+/* Find or allocate the reassembly context of a recoverable fragment */
+static int8_t
+rfrag_context(uint8_t tag)
+{
+  int i;
+  int8_t context;
+
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    if(frag_info[i].len > 0 && frag_info[i].rfrag && frag_info[i].tag == tag &&
+       linkaddr_cmp(&frag_info[i].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
+      return i;
+    }
+  }
+
+  /* Fragments may arrive in any order, so whichever comes first
+     allocates the context */
+  context = new_context(tag, RFRAG_LEN_UNKNOWN);
+  if(context >= 0) {
+    frag_info[context].rfrag = 1;
+  }
+  return context;
+}
+/** @} */
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
+#if SICSLOWPAN_FRAG_FORWARDING
+/*--------------------------------------------------------------------*/
+/** \name Fragment forwarding
+ * @{
+ */
+
+/** A switching entry for the fragments of a forwarded datagram */
+struct sicslowpan_fwd_entry {
+  /** Link-layer sender and tag of the incoming fragments */
+  linkaddr_t sender;
+  uint16_t tag_in;
+  /** Link-layer next hop and tag of the outgoing fragments */
+  linkaddr_t nexthop;
+  uint16_t tag_out;
+  /** Bytes of the datagram not forwarded yet; 0 if the entry is unused */
+  uint16_t remaining;
+  /** Attributes of the first fragment, given to the following ones */
+  packetbuf_attr_t network_id;
+  packetbuf_attr_t channel;
+  /** Time after which the entry may be reused */
+  struct timer timer;
+};
+
+static struct sicslowpan_fwd_entry fwd_table[SICSLOWPAN_FRAG_FORWARDING_ENTRIES];
+
+/** The first fragment being routed by the IP stack */
+static struct {
+  linkaddr_t sender;
+  uint16_t tag;
+  /** Length of the datagram and of its first fragment, uncompressed */
+  uint16_t len;
+  uint16_t first_len;
+  uint8_t state;
+} fwd_first;
+
+#define FWD_NONE        0
+#define FWD_PENDING     1
+#define FWD_SENT        2
+#define FWD_REASSEMBLE  3
+/*--------------------------------------------------------------------*/
+static struct sicslowpan_fwd_entry *
+fwd_entry_alloc(void)
+{
+  int i;
+
+  for(i = 0; i < SICSLOWPAN_FRAG_FORWARDING_ENTRIES; i++) {
+    if(fwd_table[i].remaining == 0 || timer_expired(&fwd_table[i].timer)) {
+      return &fwd_table[i];
+    }
+  }
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+/** \brief Send the first fragment of a datagram being forwarded
+ *  \param dest the next hop chosen by the IP stack
+ *  \param max_payload the space available in a frame
+ *  \return 1 if the fragment was sent
+ *
+ *  Called from output() with the headers of the first fragment in
+ *  uip_buf, as updated by the IP stack, and compressed in packetbuf.
+ */
+static int
+fwd_first_fragment_output(const linkaddr_t *dest, int max_payload)
+{
+  struct sicslowpan_fwd_entry *e;
+  int payload_len;
+
+  payload_len = fwd_first.first_len - uncomp_hdr_len;
+  if(uip_len != fwd_first.len || payload_len <= 0 ||
+     SICSLOWPAN_FRAG1_HDR_LEN + packetbuf_hdr_len + payload_len > max_payload) {
+    /* The headers changed size on the way, or no longer fit with the
+       payload of the first fragment */
+    PRINTFO("sicslowpan output: first fragment can not be forwarded\n");
+    fwd_first.state = FWD_REASSEMBLE;
+    return 0;
+  }
+
+  e = fwd_entry_alloc();
+  if(e == NULL) {
+    fwd_first.state = FWD_REASSEMBLE;
+    return 0;
+  }
+
+  linkaddr_copy(&e->sender, &fwd_first.sender);
+  e->tag_in = fwd_first.tag;
+  linkaddr_copy(&e->nexthop, dest);
+  e->tag_out = my_tag++;
+  e->remaining = fwd_first.len - fwd_first.first_len;
+  e->network_id = packetbuf_attr(PACKETBUF_ATTR_NETWORK_ID);
+  e->channel = packetbuf_attr(PACKETBUF_ATTR_CHANNEL);
+  timer_set(&e->timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+
+  memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAG1 << 8) | uip_len));
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, e->tag_out);
+  packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
+  memcpy(packetbuf_ptr + packetbuf_hdr_len,
+         (uint8_t *)UIP_IP_BUF + uncomp_hdr_len, payload_len);
+  packetbuf_set_datalen(packetbuf_hdr_len + payload_len);
+
+  PRINTFO("sicslowpan output: forwarding tag %d as %d\n",
+          e->tag_in, e->tag_out);
+  send_packet(&e->nexthop);
+  fwd_first.state = FWD_SENT;
+  return 1;
+}
+#if UIP_CONF_IPV6_QUEUE_PKT
+/*--------------------------------------------------------------------*/
+/** \brief Collect the packets queued for address resolution
+ *  \param queued the buffers of the queued packets
+ *  \return the number of queued packets
+ */
+static int
+fwd_queued_packets(uint8_t *queued[])
+{
+  uip_ds6_nbr_t *nbr;
+  int n = 0;
+
+  for(nbr = nbr_table_head(ds6_neighbors); nbr != NULL;
+      nbr = nbr_table_next(ds6_neighbors, nbr)) {
+    if(uip_packetqueue_buf(&nbr->packethandle) != NULL) {
+      queued[n++] = uip_packetqueue_buf(&nbr->packethandle);
+    }
+  }
+  return n;
+}
+/*--------------------------------------------------------------------*/
+/** \brief Drop the first fragment if it was queued by the IP stack
+ *  \param queued the buffers queued before the fragment was routed
+ *  \param n the number of buffers in queued
+ *
+ *  A neighbor can only queue a packet when it has none, so a buffer
+ *  that was not queued before holds the first fragment, padded with
+ *  zeros, waiting for its next hop to be resolved.
+ */
+static void
+fwd_drop_queued(uint8_t *queued[], int n)
+{
+  uip_ds6_nbr_t *nbr;
+  uint8_t *buf;
+  int i;
+
+  for(nbr = nbr_table_head(ds6_neighbors); nbr != NULL;
+      nbr = nbr_table_next(ds6_neighbors, nbr)) {
+    buf = uip_packetqueue_buf(&nbr->packethandle);
+    if(buf == NULL || uip_packetqueue_buflen(&nbr->packethandle) != fwd_first.len ||
+       uip_ds6_is_my_addr(&SICSLOWPAN_IP_BUF(buf)->srcipaddr)) {
+      continue;
+    }
+    for(i = 0; i < n && queued[i] != buf; i++);
+    if(i == n) {
+      PRINTFI("sicslowpan input: dropping queued first fragment\n");
+      uip_packetqueue_free(&nbr->packethandle);
+    }
+  }
+}
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
+/*--------------------------------------------------------------------*/
+/** \brief Route the first fragment of a datagram that is not for us
+ *  \param context the reassembly context of the datagram
+ *  \param tag the tag of the fragments
+ *  \param len the length of the datagram
+ *  \param first_len the length of the uncompressed first fragment
+ *  \return 1 if the datagram is handled, 0 if it must be reassembled
+ *
+ *  The uncompressed first fragment is in FIRST_FRAG_BUF(context).
+ */
+static int
+fwd_first_fragment_input(int8_t context, uint16_t tag, uint16_t len,
+                         uint16_t first_len)
+{
+  struct uip_ip_hdr *hdr = SICSLOWPAN_IP_BUF(FIRST_FRAG_BUF(context));
+  uint8_t *saved_packetbuf_ptr;
+  uint8_t saved_packetbuf_hdr_len;
+  int saved_packetbuf_payload_len;
+  uint8_t saved_uncomp_hdr_len;
+  uint8_t state;
+#if UIP_CONF_IPV6_QUEUE_PKT
+  uint8_t *queued[NBR_TABLE_MAX_NEIGHBORS];
+  int nqueued;
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
+
+  if(first_len >= len || hdr->ttl <= 1 ||
+     uip_is_addr_mcast(&hdr->destipaddr) ||
+     uip_is_addr_linklocal(&hdr->destipaddr) ||
+     uip_ds6_is_my_addr(&hdr->destipaddr)) {
+    return 0;
+  }
+
+  /* Let the IP stack route the datagram as if it were complete. Only
+     the headers are looked at on the way to output(), which sends
+     the first fragment only. */
+  memcpy(UIP_IP_BUF, FIRST_FRAG_BUF(context), first_len);
+  memset((uint8_t *)UIP_IP_BUF + first_len, 0, len - first_len);
+  uip_len = len;
+  linkaddr_copy(&fwd_first.sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  fwd_first.tag = tag;
+  fwd_first.len = len;
+  fwd_first.first_len = first_len;
+  fwd_first.state = FWD_PENDING;
+#if UIP_CONF_IPV6_QUEUE_PKT
+  nqueued = fwd_queued_packets(queued);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
+
+  /* output() uses the same state as input() */
+  saved_packetbuf_ptr = packetbuf_ptr;
+  saved_packetbuf_hdr_len = packetbuf_hdr_len;
+  saved_packetbuf_payload_len = packetbuf_payload_len;
+  saved_uncomp_hdr_len = uncomp_hdr_len;
+  tcpip_input();
+  packetbuf_ptr = saved_packetbuf_ptr;
+  packetbuf_hdr_len = saved_packetbuf_hdr_len;
+  packetbuf_payload_len = saved_packetbuf_payload_len;
+  uncomp_hdr_len = saved_uncomp_hdr_len;
+
+  state = fwd_first.state;
+  fwd_first.state = FWD_NONE;
+
+  if(state == FWD_PENDING) {
+    /* output() was not reached, e.g. the datagram was queued until
+       its next hop is resolved. Only its first fragment is there, so
+       drop the queued copy and forward the datagram once it is
+       reassembled. */
+#if UIP_CONF_IPV6_QUEUE_PKT
+    fwd_drop_queued(queued, nqueued);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
+    return 0;
+  }
+  if(state == FWD_REASSEMBLE) {
+    /* Forward the datagram as a whole once it is reassembled */
+    return 0;
+  }
+
+  /* Sent, or dropped by the IP stack; either way, the following
+     fragments are not reassembled */
+  clear_fragments(context);
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+/** \brief Forward a following fragment of a datagram
+ *  \param tag the tag of the fragment
+ *  \return 1 if the fragment was forwarded
+ */
+static int
+fwd_fragment_input(uint16_t tag)
+{
+  struct sicslowpan_fwd_entry *e;
+  uint8_t *frag;
+  uint16_t len;
+  int i;
+
+  for(i = 0; i < SICSLOWPAN_FRAG_FORWARDING_ENTRIES; i++) {
+    e = &fwd_table[i];
+    if(e->remaining > 0 && e->tag_in == tag &&
+       !timer_expired(&e->timer) &&
+       linkaddr_cmp(&e->sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
+      break;
+    }
+  }
+  if(i == SICSLOWPAN_FRAG_FORWARDING_ENTRIES) {
+    return 0;
+  }
+
+  len = packetbuf_datalen();
+  if(len <= SICSLOWPAN_FRAGN_HDR_LEN) {
+    return 1;
+  }
+  frag = packetbuf_dataptr();
+  SET16(frag, PACKETBUF_FRAG_TAG, e->tag_out);
+
+  if(e->remaining > len - SICSLOWPAN_FRAGN_HDR_LEN) {
+    e->remaining -= len - SICSLOWPAN_FRAGN_HDR_LEN;
+    timer_restart(&e->timer);
+  } else {
+    /* This was the last one */
+    e->remaining = 0;
+  }
+
+  PRINTFI("sicslowpan input: forwarding fragment of tag %d as %d\n",
+          tag, e->tag_out);
+  /* Drop the attributes of the received frame, keeping the fragment
+     in place, and classify it as the first one was */
+  packetbuf_clear();
+  memmove(packetbuf_dataptr(), frag, len);
+  packetbuf_set_datalen(len);
+  packetbuf_set_attr(PACKETBUF_ATTR_NETWORK_ID, e->network_id);
+  packetbuf_set_attr(PACKETBUF_ATTR_CHANNEL, e->channel);
+  send_packet(&e->nexthop);
+  return 1;
+}
+/** @} */
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+/*--------------------------------------------------------------------*/
 /** \brief Take an IP packet and format it to be sent on an 802.15.4
  *  network using 6lowpan.
  *  \param localdest The MAC address of the destination
@@ -1276,6 +2643,9 @@ output(const uip_lladdr_t *localdest)
 {
   int framer_hdrlen;
   int max_payload;
+#if SICSLOWPAN_FRAG_RECOVERY
+  int rfrag;
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
 
   /* The MAC address of the destination of the packet */
   linkaddr_t dest;
@@ -1288,11 +2658,10 @@ output(const uip_lladdr_t *localdest)
   packetbuf_clear();
   packetbuf_ptr = packetbuf_dataptr();
 
-  if(callback) {
-    /* call the attribution when the callback comes, but set attributes
-       here ! */
-    set_packet_attrs();
-  }
+  /* Set the protocol attributes here: they are used by the sniffer
+     callback for attribution, and by the MAC layer to classify
+     traffic. */
+  set_packet_attrs();
 
 #if PACKETBUF_WITH_PACKET_TYPE
 #define TCP_FIN 0x01
@@ -1352,6 +2721,16 @@ output(const uip_lladdr_t *localdest)
 #endif /* USE_FRAMER_HDRLEN */
 
   max_payload = MAC_MAX_PAYLOAD - framer_hdrlen;
+
+#if SICSLOWPAN_FRAG_FORWARDING
+  if(fwd_first.state == FWD_PENDING &&
+     !uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr)) {
+    /* The first fragment of a datagram we forward. Anything else we
+       send meanwhile, e.g. an ICMP error, has one of our addresses
+       as source. */
+    return fwd_first_fragment_output(&dest, max_payload);
+  }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
   if((int)uip_len - (int)uncomp_hdr_len > max_payload - (int)packetbuf_hdr_len) {
 #if SICSLOWPAN_CONF_FRAG
     /* Number of bytes processed. */
@@ -1375,6 +2754,16 @@ output(const uip_lladdr_t *localdest)
       return 0;
     }
 
+#if SICSLOWPAN_FRAG_RECOVERY
+    /* Broadcast fragments can not be acknowledged */
+    if(!linkaddr_cmp(&dest, &linkaddr_null)) {
+      rfrag = rfrag_output(&dest, max_payload);
+      if(rfrag != 0) {
+        return rfrag > 0;
+      }
+    }
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
+
     PRINTFO("Fragmentation sending packet len %d\n", uip_len);
 
     /* Create 1st Fragment */
@@ -1515,6 +2904,11 @@ input(void)
   /* tag of the fragment */
   uint16_t frag_tag = 0;
   uint8_t first_fragment = 0, last_fragment = 0;
+#if SICSLOWPAN_FRAG_RECOVERY
+  uint8_t rfrag = 0, rfrag_seq = 0, rfrag_ack_request = 0;
+  uint32_t rfrag_bitmap = RFRAG_BITMAP_NULL;
+  linkaddr_t rfrag_sender;
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
 #endif /*SICSLOWPAN_CONF_FRAG*/
 
   /* Update link statistics */
@@ -1540,6 +2934,90 @@ input(void)
    * Since we don't support the mesh and broadcast header, the first header
    * we look for is the fragmentation header
    */
+#if SICSLOWPAN_FRAG_RECOVERY
+  if((PACKETBUF_FRAG_PTR[PACKETBUF_RFRAG_DISPATCH] & 0xfe) == SICSLOWPAN_DISPATCH_RFRAG_ACK) {
+    rfrag_ack_input();
+    return;
+  }
+  if((PACKETBUF_FRAG_PTR[PACKETBUF_RFRAG_DISPATCH] & 0xfe) == SICSLOWPAN_DISPATCH_RFRAG) {
+    uint16_t rfrag_offset;
+    uint16_t rfrag_len;
+    int len;
+
+    PRINTFI("sicslowpan input: RFRAG ");
+    frag_tag = PACKETBUF_FRAG_PTR[PACKETBUF_RFRAG_TAG];
+    rfrag_ack_request = (GET16(PACKETBUF_FRAG_PTR, PACKETBUF_RFRAG_SEQ_SIZE) & 0x8000) != 0;
+    rfrag_seq = (GET16(PACKETBUF_FRAG_PTR, PACKETBUF_RFRAG_SEQ_SIZE) >> 10) & 0x1f;
+    rfrag_len = GET16(PACKETBUF_FRAG_PTR, PACKETBUF_RFRAG_SEQ_SIZE) & 0x03ff;
+    rfrag_offset = GET16(PACKETBUF_FRAG_PTR, PACKETBUF_RFRAG_OFFSET);
+    PRINTFI("tag %d, seq %d, offset %d, len %d)\n",
+            frag_tag, rfrag_seq, rfrag_offset, rfrag_len);
+    packetbuf_hdr_len += SICSLOWPAN_RFRAG_HDR_LEN;
+
+    if(rfrag_len == 0 || packetbuf_datalen() < packetbuf_hdr_len + rfrag_len) {
+      PRINTFI("sicslowpan input: RFRAG with bad length\n");
+      return;
+    }
+    /* Ignore anything after the fragment */
+    packetbuf_set_datalen(packetbuf_hdr_len + rfrag_len);
+
+    linkaddr_copy(&rfrag_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+    if(rfrag_done_lookup(&rfrag_sender, frag_tag)) {
+      if(rfrag_ack_request) {
+        rfrag_ack_output(&rfrag_sender, frag_tag, RFRAG_BITMAP_FULL);
+      }
+      return;
+    }
+
+    frag_context = rfrag_context(frag_tag);
+    if(frag_context == -1) {
+      return;
+    }
+    /* The reassembly is kept as long as fragments keep coming */
+    timer_restart(&frag_info[frag_context].reass_timer);
+    rfrag = 1;
+    is_fragment = 1;
+
+    if(frag_info[frag_context].rfrag_bitmap & RFRAG_BIT(rfrag_seq)) {
+      /* Sent again before our acknowledgment got through */
+      if(rfrag_ack_request) {
+        rfrag_ack_output(&rfrag_sender, frag_tag,
+                         frag_info[frag_context].rfrag_bitmap);
+      }
+      return;
+    }
+
+    if(rfrag_seq == 0) {
+      /* The offset of the first fragment is the datagram size */
+      frag_size = rfrag_offset;
+      if(frag_size == 0 || frag_size > UIP_BUFSIZE - UIP_LLH_LEN) {
+        clear_fragments(frag_context);
+        return;
+      }
+      frag_info[frag_context].len = frag_size;
+      first_fragment = 1;
+      buffer = first_frag;
+    } else {
+      if(rfrag_offset == 0 || (rfrag_offset & 7) != 0 || (rfrag_offset >> 3) > 0xff) {
+        PRINTFI("sicslowpan input: RFRAG with bad offset\n");
+        return;
+      }
+      frag_offset = rfrag_offset >> 3;
+      len = store_fragment_or_timeout(frag_context, frag_offset,
+                                      packetbuf_ptr + packetbuf_hdr_len, rfrag_len);
+      if(len < 0) {
+        /* The sender will send it again */
+        return;
+      }
+      frag_info[frag_context].reassembled_len += len;
+      frag_size = frag_info[frag_context].len;
+      if(frag_info[frag_context].reassembled_len >= frag_size) {
+        last_fragment = 1;
+      }
+      buffer = NULL;
+    }
+  } else
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
   switch((GET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE) & 0xf800) >> 8) {
     case SICSLOWPAN_DISPATCH_FRAG1:
       PRINTFI("sicslowpan input: FRAG1 ");
@@ -1562,7 +3040,7 @@ input(void)
         return;
       }
 
-      buffer = frag_info[frag_context].first_frag;
+      buffer = FIRST_FRAG_BUF(frag_context);
 
       break;
     case SICSLOWPAN_DISPATCH_FRAGN:
@@ -1578,6 +3056,12 @@ input(void)
              frag_size, frag_tag, frag_offset);
       packetbuf_hdr_len += SICSLOWPAN_FRAGN_HDR_LEN;
 
+#if SICSLOWPAN_FRAG_FORWARDING
+      if(fwd_fragment_input(frag_tag)) {
+        return;
+      }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
       /* If this is the last fragment, we may shave off any extrenous
          bytes at the end. We must be liberal in what we accept. */
       PRINTFI("last_fragment?: packetbuf_payload_len %d frag_size %d\n",
@@ -1616,6 +3100,15 @@ input(void)
     PRINTFI("sicslowpan input: IPHC\n");
     uncompress_hdr_iphc(buffer, frag_size);
   } else
+#if SICSLOWPAN_6LORH
+  if(PACKETBUF_HC1_PTR[PACKETBUF_HC1_DISPATCH] == SICSLOWPAN_DISPATCH_PAGING_1) {
+    PRINTFI("sicslowpan input: 6LoRH\n");
+    if(!uncompress_hdr_6lorh(buffer, frag_size)) {
+      PRINTFI("sicslowpan input: malformed 6LoRH, dropping packet\n");
+      return;
+    }
+  } else
+#endif /* SICSLOWPAN_6LORH */
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
     switch(PACKETBUF_HC1_PTR[PACKETBUF_HC1_DISPATCH]) {
     case SICSLOWPAN_DISPATCH_IPV6:
@@ -1666,21 +3159,59 @@ input(void)
     }
   }
 
+#if SICSLOWPAN_CONF_FRAG
+  if(first_fragment != 0 &&
+     uncomp_hdr_len + packetbuf_payload_len > SICSLOWPAN_FIRST_FRAGMENT_SIZE) {
+    PRINTF("SICSLOWPAN: first fragment dropped, %d bytes uncompressed\n",
+           uncomp_hdr_len + packetbuf_payload_len);
+    clear_fragments(frag_context);
+    return;
+  }
+#endif /* SICSLOWPAN_CONF_FRAG */
+
   /* copy the payload if buffer is non-null - which is only the case with first fragment
      or packets that are non fragmented */
   if(buffer != NULL) {
     memcpy((uint8_t *)buffer + uncomp_hdr_len, packetbuf_ptr + packetbuf_hdr_len, packetbuf_payload_len);
   }
 
+#if SICSLOWPAN_FRAG_FORWARDING
+  if(first_fragment != 0 &&
+#if SICSLOWPAN_FRAG_RECOVERY
+     rfrag == 0 &&
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
+     fwd_first_fragment_input(frag_context, frag_tag, frag_size,
+                              uncomp_hdr_len + packetbuf_payload_len)) {
+    return;
+  }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
   /* update processed_ip_in_len if fragment, sicslowpan_len otherwise */
 
 #if SICSLOWPAN_CONF_FRAG
   if(frag_size > 0) {
     /* Add the size of the header only for the first fragment. */
     if(first_fragment != 0) {
-      frag_info[frag_context].reassembled_len = uncomp_hdr_len + packetbuf_payload_len;
-      frag_info[frag_context].first_frag_len = uncomp_hdr_len + packetbuf_payload_len;
+      if(store_first_fragment(frag_context, uncomp_hdr_len + packetbuf_payload_len) < 0) {
+        PRINTF("*** Failed to store first fragment - tag: %d\n", frag_tag);
+        clear_fragments(frag_context);
+        return;
+      }
+      frag_info[frag_context].reassembled_len += uncomp_hdr_len + packetbuf_payload_len;
+      if(frag_info[frag_context].reassembled_len >= frag_size) {
+        last_fragment = 1;
+      }
     }
+#if SICSLOWPAN_FRAG_RECOVERY
+    if(rfrag != 0) {
+      frag_info[frag_context].rfrag_bitmap |= RFRAG_BIT(rfrag_seq);
+      rfrag_bitmap = frag_info[frag_context].rfrag_bitmap;
+      if(last_fragment != 0) {
+        rfrag_bitmap = RFRAG_BITMAP_FULL;
+        rfrag_done_add(&rfrag_sender, frag_tag);
+      }
+    }
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
     /* For the last fragment, we are OK if there is extrenous bytes at
        the end of the packet. */
     if(last_fragment != 0) {
@@ -1729,6 +3260,14 @@ input(void)
 #if SICSLOWPAN_CONF_FRAG
   }
 #endif /* SICSLOWPAN_CONF_FRAG */
+
+#if SICSLOWPAN_FRAG_RECOVERY
+  /* A completed datagram is always acknowledged, so that the sender
+     does not send fragments of it again */
+  if(rfrag != 0 && (rfrag_ack_request || last_fragment)) {
+    rfrag_ack_output(&rfrag_sender, frag_tag, rfrag_bitmap);
+  }
+#endif /* SICSLOWPAN_FRAG_RECOVERY */
 }
 /** @} */
 
@@ -82,6 +82,39 @@
 #define SICSLOWPAN_DISPATCH_IPHC                    0x60 /* 011xxxxx = ... */
 #define SICSLOWPAN_DISPATCH_FRAG1                   0xc0 /* 11000xxx */
 #define SICSLOWPAN_DISPATCH_FRAGN                   0xe0 /* 11100xxx */
+#define SICSLOWPAN_DISPATCH_PAGING_1                0xf1 /* 11110001 */
+/** @} */
+
+/**
+ * \name Non-standard dispatches of the fragment recovery enabled with
+ * SICSLOWPAN_CONF_NONSTANDARD_FRAG_RECOVERY. They are unassigned in
+ * RFC 4944, and are not those of RFC 8931.
+ * @{
+ */
+#define SICSLOWPAN_DISPATCH_RFRAG                   0xd0 /* 1101000x */
+#define SICSLOWPAN_DISPATCH_RFRAG_ACK               0xd2 /* 1101001x */
+/** @} */
+
+/**
+ * \name 6LoWPAN routing header (6LoRH) encoding, RFC 8138
+ * @{
+ */
+#define SICSLOWPAN_6LORH_MASK                       0xe0
+#define SICSLOWPAN_6LORH_CRITICAL                   0x80 /* 100xxxxx */
+#define SICSLOWPAN_6LORH_ELECTIVE                   0xa0 /* 101xxxxx */
+#define SICSLOWPAN_6LORH_LEN_MASK                   0x1f
+
+/* RH3-6LoRH types 0 to 4 carry addresses of 1 << type bytes */
+#define SICSLOWPAN_6LORH_TYPE_RH3_MAX               4
+#define SICSLOWPAN_6LORH_TYPE_RPI                   5
+#define SICSLOWPAN_6LORH_TYPE_IPINIP                6
+
+/* Flags of the RPI-6LoRH, in the first byte */
+#define SICSLOWPAN_6LORH_RPI_O                      0x10
+#define SICSLOWPAN_6LORH_RPI_R                      0x08
+#define SICSLOWPAN_6LORH_RPI_F                      0x04
+#define SICSLOWPAN_6LORH_RPI_I                      0x02
+#define SICSLOWPAN_6LORH_RPI_K                      0x01
 /** @} */
 
 /** \name HC1 encoding
@@ -175,6 +208,8 @@
 #define SICSLOWPAN_HC1_HC_UDP_HDR_LEN               7
 #define SICSLOWPAN_FRAG1_HDR_LEN                    4
 #define SICSLOWPAN_FRAGN_HDR_LEN                    5
+#define SICSLOWPAN_RFRAG_HDR_LEN                    6
+#define SICSLOWPAN_RFRAG_ACK_HDR_LEN                6
 /** @} */
 
 /**
@@ -71,11 +71,45 @@ void LINK_NEIGHBOR_CALLBACK(const linkaddr_t *addr, int status, int numtx);
 
 NBR_TABLE_GLOBAL(uip_ds6_nbr_t, ds6_neighbors);
 
+/* The neighbors, indexed by IPv6 address */
+static uip_ds6_nbr_t *nbr_hash[UIP_DS6_NBR_HASH_SIZE];
+
+/*---------------------------------------------------------------------------*/
+static unsigned
+ipaddr_hash(const uip_ipaddr_t *ipaddr)
+{
+  uint16_t h;
+  int i;
+
+  /* Neighbors mostly differ by their interface identifier, which for
+     autoconfigured addresses is their link-layer address. A
+     multiplicative hash over its 16-bit words spreads link-layer
+     addresses that repeat a byte, which an XOR of the bytes does not. */
+  h = 0;
+  for(i = 8; i < sizeof(uip_ipaddr_t); i += 2) {
+    h = (h + ((uint16_t)ipaddr->u8[i] << 8) + ipaddr->u8[i + 1]) * 0x9e37;
+  }
+  return (h ^ (h >> 8)) % UIP_DS6_NBR_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_remove(uip_ds6_nbr_t *nbr)
+{
+  uip_ds6_nbr_t **p;
+
+  for(p = &nbr_hash[ipaddr_hash(&nbr->ipaddr)]; *p != NULL; p = &(*p)->hash_next) {
+    if(*p == nbr) {
+      *p = nbr->hash_next;
+      return;
+    }
+  }
+}
 /*---------------------------------------------------------------------------*/
 void
 uip_ds6_neighbors_init(void)
 {
   link_stats_init();
+  memset(nbr_hash, 0, sizeof(nbr_hash));
   nbr_table_register(ds6_neighbors, (nbr_table_callback *)uip_ds6_nbr_rm);
 }
 /*---------------------------------------------------------------------------*/
@@ -84,10 +118,22 @@ uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr, const uip_lladdr_t *lladdr,
                 uint8_t isrouter, uint8_t state, nbr_table_reason_t reason,
                 void *data)
 {
-  uip_ds6_nbr_t *nbr = nbr_table_add_lladdr(ds6_neighbors, (linkaddr_t*)lladdr
-                                            , reason, data);
+  uip_ds6_nbr_t *nbr;
+  unsigned h;
+
+  /* An existing entry for this link-layer address is reset below */
+  nbr = nbr_table_get_from_lladdr(ds6_neighbors, (linkaddr_t *)lladdr);
+  if(nbr != NULL) {
+    hash_remove(nbr);
+  }
+
+  nbr = nbr_table_add_lladdr(ds6_neighbors, (linkaddr_t*)lladdr
+                             , reason, data);
   if(nbr) {
     uip_ipaddr_copy(&nbr->ipaddr, ipaddr);
+    h = ipaddr_hash(ipaddr);
+    nbr->hash_next = nbr_hash[h];
+    nbr_hash[h] = nbr;
 #if UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
     nbr->isrouter = isrouter;
 #endif /* UIP_ND6_SEND_RA || !UIP_CONF_ROUTER */
@@ -131,6 +177,7 @@ uip_ds6_nbr_rm(uip_ds6_nbr_t *nbr)
     uip_packetqueue_free(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
     NEIGHBOR_STATE_CHANGED(nbr);
+    hash_remove(nbr);
     return nbr_table_remove(ds6_neighbors, nbr);
   }
   return 0;
@@ -168,13 +215,12 @@ uip_ds6_nbr_num(void)
 uip_ds6_nbr_t *
 uip_ds6_nbr_lookup(const uip_ipaddr_t *ipaddr)
 {
-  uip_ds6_nbr_t *nbr = nbr_table_head(ds6_neighbors);
+  uip_ds6_nbr_t *nbr;
   if(ipaddr != NULL) {
-    while(nbr != NULL) {
+    for(nbr = nbr_hash[ipaddr_hash(ipaddr)]; nbr != NULL; nbr = nbr->hash_next) {
       if(uip_ipaddr_cmp(&nbr->ipaddr, ipaddr)) {
         return nbr;
       }
-      nbr = nbr_table_next(ds6_neighbors, nbr);
     }
   }
   return NULL;
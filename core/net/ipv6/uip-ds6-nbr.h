@@ -62,10 +62,19 @@
 #define  NBR_DELAY 3
 #define  NBR_PROBE 4
 
+/** \brief Number of buckets of the hash table indexing neighbors by
+    IPv6 address */
+#ifdef UIP_DS6_NBR_CONF_HASH_SIZE
+#define UIP_DS6_NBR_HASH_SIZE UIP_DS6_NBR_CONF_HASH_SIZE
+#else /* UIP_DS6_NBR_CONF_HASH_SIZE */
+#define UIP_DS6_NBR_HASH_SIZE 8
+#endif /* UIP_DS6_NBR_CONF_HASH_SIZE */
+
 NBR_TABLE_DECLARE(ds6_neighbors);
 
 /** \brief An entry in the nbr cache */
 typedef struct uip_ds6_nbr {
+  struct uip_ds6_nbr *hash_next;
   uip_ipaddr_t ipaddr;
   uint8_t isrouter;
   uint8_t state;
@@ -76,38 +76,64 @@ anti_replay_get_counter(void)
   return LLSEC802154_HTONL(disordered_counter.u32); 
 }
 /*---------------------------------------------------------------------------*/
-void
-anti_replay_init_info(struct anti_replay_info *info)
+static void
+init_window(struct anti_replay_window *window, uint32_t received_counter)
 {
-  info->last_broadcast_counter
-      = info->last_unicast_counter
-      = anti_replay_get_counter();
+  window->last_counter = received_counter;
+#if ANTI_REPLAY_WITH_WINDOW
+  window->bitmap = 1;
+#endif /* ANTI_REPLAY_WITH_WINDOW */
 }
 /*---------------------------------------------------------------------------*/
-int
-anti_replay_was_replayed(struct anti_replay_info *info)
+void
+anti_replay_init_info(struct anti_replay_info *info)
 {
   uint32_t received_counter;
   
   received_counter = anti_replay_get_counter();
+  init_window(&info->broadcast, received_counter);
+  init_window(&info->unicast, received_counter);
+}
+/*---------------------------------------------------------------------------*/
+static int
+was_replayed(struct anti_replay_window *window, uint32_t received_counter)
+{
+#if ANTI_REPLAY_WITH_WINDOW
+  uint32_t diff;
   
-  if(packetbuf_holds_broadcast()) {
-    /* broadcast */
-    if(received_counter <= info->last_broadcast_counter) {
-      return 1;
-    } else {
-      info->last_broadcast_counter = received_counter;
-      return 0;
-    }
-  } else {
-    /* unicast */
-    if(received_counter <= info->last_unicast_counter) {
-      return 1;
-    } else {
-      info->last_unicast_counter = received_counter;
-      return 0;
-    }
+  if(received_counter > window->last_counter) {
+    /* slide the window */
+    diff = received_counter - window->last_counter;
+    window->bitmap = diff < ANTI_REPLAY_WINDOW_SIZE
+        ? (window->bitmap << diff) | 1
+        : 1;
+    window->last_counter = received_counter;
+    return 0;
   }
+  
+  diff = window->last_counter - received_counter;
+  if((diff >= ANTI_REPLAY_WINDOW_SIZE)
+      || (window->bitmap & ((uint32_t)1 << diff))) {
+    return 1;
+  }
+  window->bitmap |= (uint32_t)1 << diff;
+  return 0;
+#else /* ANTI_REPLAY_WITH_WINDOW */
+  if(received_counter <= window->last_counter) {
+    return 1;
+  }
+  window->last_counter = received_counter;
+  return 0;
+#endif /* ANTI_REPLAY_WITH_WINDOW */
+}
+/*---------------------------------------------------------------------------*/
+int
+anti_replay_was_replayed(struct anti_replay_info *info)
+{
+  return was_replayed(packetbuf_holds_broadcast()
+      ? &info->broadcast
+      : &info->unicast,
+      anti_replay_get_counter());
 }
 /*---------------------------------------------------------------------------*/
 #endif /* LLSEC802154_USES_FRAME_COUNTER */
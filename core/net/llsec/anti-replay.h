@@ -47,9 +47,29 @@
 
 #include "contiki.h"
 
+/* With a window, frames that arrive out of order are accepted as long
+   as they are at most 31 frames older than the newest frame and have
+   not been received before. Without, frame counters must strictly
+   increase. */
+#ifdef ANTI_REPLAY_CONF_WITH_WINDOW
+#define ANTI_REPLAY_WITH_WINDOW ANTI_REPLAY_CONF_WITH_WINDOW
+#else /* ANTI_REPLAY_CONF_WITH_WINDOW */
+#define ANTI_REPLAY_WITH_WINDOW 1
+#endif /* ANTI_REPLAY_CONF_WITH_WINDOW */
+
+#define ANTI_REPLAY_WINDOW_SIZE 32
+
+struct anti_replay_window {
+  uint32_t last_counter;
+#if ANTI_REPLAY_WITH_WINDOW
+  /* bit i is set if frame last_counter - i was received */
+  uint32_t bitmap;
+#endif /* ANTI_REPLAY_WITH_WINDOW */
+};
+
 struct anti_replay_info {
-  uint32_t last_broadcast_counter;
-  uint32_t last_unicast_counter;
+  struct anti_replay_window broadcast;
+  struct anti_replay_window unicast;
 };
 
 /**
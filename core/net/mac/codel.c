@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Sojourn-time based active queue management (CoDel), after
+ *         Nichols and Jacobson, "Controlling Queue Delay", ACM Queue 2012.
+ */
+
+#include "net/mac/codel.h"
+
+/*---------------------------------------------------------------------------*/
+static uint16_t
+isqrt(uint16_t x)
+{
+  uint16_t r = 0;
+  uint16_t bit = 1 << 14;
+
+  while(bit > x) {
+    bit >>= 2;
+  }
+  while(bit != 0) {
+    if(x >= r + bit) {
+      x -= r + bit;
+      r = (r >> 1) + bit;
+    } else {
+      r >>= 1;
+    }
+    bit >>= 2;
+  }
+  return r;
+}
+/*---------------------------------------------------------------------------*/
+void
+codel_init(struct codel *c)
+{
+  c->above = 0;
+  c->dropping = 0;
+  c->count = 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+codel_drop(struct codel *c, clock_time_t sojourn, int queue_len)
+{
+  clock_time_t now = clock_time();
+  int ok_to_drop = 0;
+
+  if(sojourn < CODEL_TARGET || queue_len <= 1) {
+    /* Went below target, or the queue holds a single packet */
+    c->above = 0;
+  } else if(!c->above) {
+    c->above = 1;
+    c->above_since = now;
+  } else if((clock_time_t)(now - c->above_since) >= CODEL_INTERVAL) {
+    ok_to_drop = 1;
+  }
+
+  if(c->dropping) {
+    if(!ok_to_drop) {
+      c->dropping = 0;
+      return 0;
+    }
+    if((clock_time_t)(now - c->last_drop) < c->drop_delay) {
+      return 0;
+    }
+    if(c->count < 0xffff) {
+      c->count++;
+    }
+  } else {
+    if(!ok_to_drop) {
+      return 0;
+    }
+    c->dropping = 1;
+    /* If we were dropping recently, resume close to the previous rate */
+    if(c->count > 2 &&
+       (clock_time_t)(now - c->last_drop) < 8 * CODEL_INTERVAL) {
+      c->count -= 2;
+    } else {
+      c->count = 1;
+    }
+  }
+
+  /* Control law: drop rate grows with the square root of the count */
+  c->last_drop = now;
+  c->drop_delay = CODEL_INTERVAL / isqrt(c->count);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
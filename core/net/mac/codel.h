@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Sojourn-time based active queue management (CoDel) for MAC
+ *         layer packet queues. The queue owner timestamps packets when
+ *         they are enqueued and asks, when a packet reaches the head of
+ *         the queue, whether it should be dropped.
+ */
+
+#ifndef CODEL_H_
+#define CODEL_H_
+
+#include "contiki.h"
+
+/* Acceptable standing queue delay */
+#ifdef CODEL_CONF_TARGET
+#define CODEL_TARGET CODEL_CONF_TARGET
+#else
+#define CODEL_TARGET (CLOCK_SECOND / 8)
+#endif
+
+/* Time the delay must stay above target before dropping starts. Should
+   be in the order of a worst-case end-to-end round trip time. */
+#ifdef CODEL_CONF_INTERVAL
+#define CODEL_INTERVAL CODEL_CONF_INTERVAL
+#else
+#define CODEL_INTERVAL (2 * CLOCK_SECOND)
+#endif
+
+/* Per-queue CoDel state */
+struct codel {
+  clock_time_t above_since; /* when the delay first exceeded the target */
+  clock_time_t last_drop;   /* time of the last drop */
+  clock_time_t drop_delay;  /* time between last_drop and the next drop */
+  uint16_t count;           /* drops since entering the dropping state */
+  uint8_t above;
+  uint8_t dropping;
+};
+
+/**
+ * \brief      Reset the state of a queue
+ * \param c    The CoDel state of the queue
+ */
+void codel_init(struct codel *c);
+
+/**
+ * \brief      Decide whether the head packet of a queue should be dropped
+ * \param c    The CoDel state of the queue
+ * \param sojourn The time the head packet has spent in the queue
+ * \param queue_len The number of packets in the queue, head included
+ * \return     Non-zero if the head packet should be dropped
+ *
+ *             This function is called when a packet is about to be
+ *             dequeued. If it returns non-zero, the caller drops the
+ *             packet and calls the function again for the next one.
+ */
+int codel_drop(struct codel *c, clock_time_t sojourn, int queue_len);
+
+#endif /* CODEL_H_ */
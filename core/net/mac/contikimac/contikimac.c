@@ -824,7 +824,7 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
 
   if(!is_broadcast) {
     if(collisions == 0 && is_receiver_awake == 0) {
-      phase_update(packetbuf_addr(PACKETBUF_ADDR_RECEIVER),
+      phase_update(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), CYCLE_TIME,
 		   encounter_time, ret);
     }
   }
@@ -885,7 +885,12 @@ qsend_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
       }
 
       packetbuf_set_attr(PACKETBUF_ATTR_IS_CREATED_AND_SECURED, 1);
-      queuebuf_update_from_packetbuf(curr->buf);
+      if(!queuebuf_update_from_packetbuf(curr->buf)) {
+        /* The queued frame would go out without its header */
+        PRINTF("contikimac: could not store the created frame\n");
+        mac_call_sent_callback(sent, ptr, MAC_TX_ERR, 1);
+        return;
+      }
     }
     curr = next;
   } while(next != NULL);
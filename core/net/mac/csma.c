@@ -38,6 +38,7 @@
  */
 
 #include "net/mac/csma.h"
+#include "net/mac/codel.h"
 #include "net/packetbuf.h"
 #include "net/queuebuf.h"
 
@@ -51,6 +52,11 @@
 #include "lib/list.h"
 #include "lib/memb.h"
 
+#if NETSTACK_CONF_WITH_IPV6
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-icmp6.h"
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
 #include <string.h>
 
 #include <stdio.h>
@@ -93,11 +99,37 @@
 #define CSMA_MAX_MAX_FRAME_RETRIES 7
 #endif
 
+/* Fair queuing: neighbors whose backoff has expired are served by a
+   scheduler instead of transmitting directly from their own timer.
+   Control traffic is served with strict priority, the remaining
+   neighbors are served in deficit round robin order. */
+#ifdef CSMA_CONF_FAIR_QUEUING
+#define CSMA_FAIR_QUEUING CSMA_CONF_FAIR_QUEUING
+#else
+#define CSMA_FAIR_QUEUING 0
+#endif
+
+/* DRR quantum, in bytes, granted to a neighbor per scheduling round */
+#ifdef CSMA_CONF_DRR_QUANTUM
+#define CSMA_DRR_QUANTUM CSMA_CONF_DRR_QUANTUM
+#else
+#define CSMA_DRR_QUANTUM 128
+#endif
+
+/* Drop packets that have been queued for too long, using CoDel */
+#ifdef CSMA_CONF_WITH_CODEL
+#define CSMA_WITH_CODEL CSMA_CONF_WITH_CODEL
+#else
+#define CSMA_WITH_CODEL 0
+#endif
+
 /* Packet metadata */
 struct qbuf_metadata {
   mac_callback_t sent;
   void *cptr;
   uint8_t max_transmissions;
+  uint8_t traffic_class;
+  clock_time_t enqueued;
 };
 
 /* Every neighbor has its own packet queue */
@@ -107,6 +139,13 @@ struct neighbor_queue {
   struct ctimer transmit_timer;
   uint8_t transmissions;
   uint8_t collisions;
+#if CSMA_FAIR_QUEUING
+  uint8_t ready;
+  int16_t deficit;
+#endif /* CSMA_FAIR_QUEUING */
+#if CSMA_WITH_CODEL
+  struct codel codel;
+#endif /* CSMA_WITH_CODEL */
   LIST_STRUCT(queued_packet_list);
 };
 
@@ -130,8 +169,48 @@ MEMB(packet_memb, struct rdc_buf_list, MAX_QUEUED_PACKETS);
 MEMB(metadata_memb, struct qbuf_metadata, MAX_QUEUED_PACKETS);
 LIST(neighbor_list);
 
+static struct csma_class_stats class_stats[CSMA_NUM_CLASSES];
+
+#if CSMA_FAIR_QUEUING
+static struct ctimer scheduler_timer;
+static struct neighbor_queue *drr_next;
+#endif /* CSMA_FAIR_QUEUING */
+
 static void packet_sent(void *ptr, int status, int num_transmissions);
 static void transmit_packet_list(void *ptr);
+static void remove_packet(struct neighbor_queue *n, struct rdc_buf_list *p);
+static void free_neighbor(struct neighbor_queue *n);
+/*---------------------------------------------------------------------------*/
+static uint8_t
+packet_class(void)
+{
+#if PACKETBUF_WITH_PACKET_TYPE
+  if(packetbuf_attr(PACKETBUF_ATTR_PACKET_TYPE) ==
+     PACKETBUF_ATTR_PACKET_TYPE_ACK) {
+    return CSMA_CLASS_CONTROL;
+  }
+#endif /* PACKETBUF_WITH_PACKET_TYPE */
+#if NETSTACK_CONF_WITH_IPV6
+  /* sicslowpan stores the protocol and the ICMPv6 type in the
+     NETWORK_ID and CHANNEL attributes */
+  if(packetbuf_attr(PACKETBUF_ATTR_NETWORK_ID) == UIP_PROTO_ICMP6) {
+    uint8_t type = packetbuf_attr(PACKETBUF_ATTR_CHANNEL) >> 8;
+    if(type == ICMP6_RPL || (type >= ICMP6_RS && type <= ICMP6_REDIRECT)) {
+      return CSMA_CLASS_CONTROL;
+    }
+  }
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+  return CSMA_CLASS_DATA;
+}
+/*---------------------------------------------------------------------------*/
+const struct csma_class_stats *
+csma_get_class_stats(uint8_t traffic_class)
+{
+  if(traffic_class >= CSMA_NUM_CLASSES) {
+    return NULL;
+  }
+  return &class_stats[traffic_class];
+}
 /*---------------------------------------------------------------------------*/
 static struct neighbor_queue *
 neighbor_queue_from_addr(const linkaddr_t *addr)
@@ -163,12 +242,54 @@ backoff_period(void)
   return time;
 }
 /*---------------------------------------------------------------------------*/
+#if CSMA_WITH_CODEL
+/* Drop packets from the head of the queue until CoDel accepts one.
+   Returns the new head, or NULL if the queue ran empty and the neighbor
+   was freed. */
+static struct rdc_buf_list *
+codel_drop_head(struct neighbor_queue *n)
+{
+  struct rdc_buf_list *q;
+  struct qbuf_metadata *metadata;
+  mac_callback_t sent;
+  void *cptr;
+
+  while((q = list_head(n->queued_packet_list)) != NULL) {
+    metadata = (struct qbuf_metadata *)q->ptr;
+    if(metadata->traffic_class == CSMA_CLASS_CONTROL) {
+      /* Never drop control traffic */
+      break;
+    }
+    if(!codel_drop(&n->codel, clock_time() - metadata->enqueued,
+                   list_length(n->queued_packet_list))) {
+      break;
+    }
+    PRINTF("csma: codel drop, queue length %d\n",
+           list_length(n->queued_packet_list));
+    class_stats[metadata->traffic_class].dropped++;
+    sent = metadata->sent;
+    cptr = metadata->cptr;
+    remove_packet(n, q);
+    mac_call_sent_callback(sent, cptr, MAC_TX_ERR, 0);
+  }
+  if(q == NULL) {
+    free_neighbor(n);
+  }
+  return q;
+}
+#endif /* CSMA_WITH_CODEL */
+/*---------------------------------------------------------------------------*/
 static void
 transmit_packet_list(void *ptr)
 {
   struct neighbor_queue *n = ptr;
   if(n) {
+#if CSMA_WITH_CODEL
+    /* Drop without going through a backoff for every dropped packet */
+    struct rdc_buf_list *q = codel_drop_head(n);
+#else /* CSMA_WITH_CODEL */
     struct rdc_buf_list *q = list_head(n->queued_packet_list);
+#endif /* CSMA_WITH_CODEL */
     if(q != NULL) {
       PRINTF("csma: preparing number %d %p, queue len %d\n", n->transmissions, q,
           list_length(n->queued_packet_list));
@@ -178,6 +299,92 @@ transmit_packet_list(void *ptr)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if CSMA_FAIR_QUEUING
+static uint8_t
+head_class(struct neighbor_queue *n)
+{
+  struct rdc_buf_list *q = list_head(n->queued_packet_list);
+  if(q != NULL && q->ptr != NULL) {
+    return ((struct qbuf_metadata *)q->ptr)->traffic_class;
+  }
+  return CSMA_CLASS_DATA;
+}
+/*---------------------------------------------------------------------------*/
+static struct neighbor_queue *
+select_neighbor(void)
+{
+  struct neighbor_queue *n;
+  int ready;
+
+  /* Strict priority for neighbors with control traffic at the head */
+  ready = 0;
+  for(n = list_head(neighbor_list); n != NULL; n = list_item_next(n)) {
+    if(n->ready) {
+      if(head_class(n) == CSMA_CLASS_CONTROL) {
+        return n;
+      }
+      ready = 1;
+    }
+  }
+  if(!ready) {
+    return NULL;
+  }
+
+  /* Deficit round robin over the remaining neighbors. A neighbor keeps
+     its turn for as long as its deficit is positive; the deficit is
+     charged with the length of every frame actually transmitted. */
+  n = drr_next != NULL ? drr_next : list_head(neighbor_list);
+  while(1) {
+    if(n->ready) {
+      if(n->deficit > 0) {
+        drr_next = n;
+        return n;
+      }
+      n->deficit += CSMA_DRR_QUANTUM;
+    }
+    n = list_item_next(n);
+    if(n == NULL) {
+      n = list_head(neighbor_list);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_scheduler(void *ptr)
+{
+  struct neighbor_queue *n;
+  struct neighbor_queue *other;
+
+  n = select_neighbor();
+  if(n == NULL) {
+    return;
+  }
+  n->ready = 0;
+
+  /* Serve the remaining ready neighbors after this transmission */
+  for(other = list_head(neighbor_list); other != NULL;
+      other = list_item_next(other)) {
+    if(other->ready) {
+      ctimer_set(&scheduler_timer, 0, run_scheduler, NULL);
+      break;
+    }
+  }
+
+  transmit_packet_list(n);
+}
+/*---------------------------------------------------------------------------*/
+static void
+backoff_expired(void *ptr)
+{
+  struct neighbor_queue *n = ptr;
+
+  n->ready = 1;
+  if(ctimer_expired(&scheduler_timer)) {
+    ctimer_set(&scheduler_timer, 0, run_scheduler, NULL);
+  }
+}
+#endif /* CSMA_FAIR_QUEUING */
+/*---------------------------------------------------------------------------*/
 static void
 schedule_transmission(struct neighbor_queue *n)
 {
@@ -195,19 +402,54 @@ schedule_transmission(struct neighbor_queue *n)
 
   PRINTF("csma: scheduling transmission in %u ticks, NB=%u, BE=%u\n",
       (unsigned)delay, n->collisions, backoff_exponent);
+#if CSMA_FAIR_QUEUING
+  n->ready = 0;
+  ctimer_set(&n->transmit_timer, delay, backoff_expired, n);
+#else /* CSMA_FAIR_QUEUING */
   ctimer_set(&n->transmit_timer, delay, transmit_packet_list, n);
+#endif /* CSMA_FAIR_QUEUING */
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_packet(struct neighbor_queue *n, struct rdc_buf_list *p)
+{
+  struct qbuf_metadata *metadata = (struct qbuf_metadata *)p->ptr;
+  struct csma_class_stats *stats = &class_stats[metadata->traffic_class];
+  clock_time_t sojourn = clock_time() - metadata->enqueued;
+
+  stats->queued--;
+  stats->dequeued++;
+  stats->sojourn_total += sojourn;
+  if(sojourn > stats->sojourn_max) {
+    stats->sojourn_max = sojourn;
+  }
+
+  /* Remove packet from list and deallocate */
+  list_remove(n->queued_packet_list, p);
+
+  queuebuf_free(p->buf);
+  memb_free(&metadata_memb, p->ptr);
+  memb_free(&packet_memb, p);
+}
+/*---------------------------------------------------------------------------*/
+static void
+free_neighbor(struct neighbor_queue *n)
+{
+  ctimer_stop(&n->transmit_timer);
+#if CSMA_FAIR_QUEUING
+  if(drr_next == n) {
+    drr_next = list_item_next(n);
+  }
+#endif /* CSMA_FAIR_QUEUING */
+  list_remove(neighbor_list, n);
+  memb_free(&neighbor_memb, n);
 }
 /*---------------------------------------------------------------------------*/
 static void
 free_packet(struct neighbor_queue *n, struct rdc_buf_list *p, int status)
 {
   if(p != NULL) {
-    /* Remove packet from list and deallocate */
-    list_remove(n->queued_packet_list, p);
-
-    queuebuf_free(p->buf);
-    memb_free(&metadata_memb, p->ptr);
-    memb_free(&packet_memb, p);
+    remove_packet(n, p);
     PRINTF("csma: free_queued_packet, queue length %d, free packets %d\n",
            list_length(n->queued_packet_list), memb_numfree(&packet_memb));
     if(list_head(n->queued_packet_list) != NULL) {
@@ -218,9 +460,7 @@ free_packet(struct neighbor_queue *n, struct rdc_buf_list *p, int status)
       schedule_transmission(n);
     } else {
       /* This was the last packet in the queue, we free the neighbor */
-      ctimer_stop(&n->transmit_timer);
-      list_remove(neighbor_list, n);
-      memb_free(&neighbor_memb, n);
+      free_neighbor(n);
     }
   }
 }
@@ -262,7 +502,12 @@ rexmit(struct rdc_buf_list *q, struct neighbor_queue *n)
   schedule_transmission(n);
   /* This is needed to correctly attribute energy that we spent
      transmitting this packet. */
-  queuebuf_update_attr_from_packetbuf(q->buf);
+  if(!queuebuf_update_attr_from_packetbuf(q->buf)) {
+    /* The queued copy keeps its previous attributes, which still
+       carry the sequence number that identifies the frame. Only the
+       energy attribution of this attempt is lost. */
+    PRINTF("csma: could not update the attributes of the queued packet\n");
+  }
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -344,6 +589,13 @@ packet_sent(void *ptr, int status, int num_transmissions)
     return;
   }
 
+#if CSMA_FAIR_QUEUING
+  if(status != MAC_TX_DEFERRED) {
+    /* Charge the neighbor for the air time it used */
+    n->deficit -= queuebuf_datalen(q->buf) * num_transmissions;
+  }
+#endif /* CSMA_FAIR_QUEUING */
+
   switch(status) {
   case MAC_TX_OK:
     tx_ok(q, n, num_transmissions);
@@ -394,6 +646,13 @@ send_packet(mac_callback_t sent, void *ptr)
       linkaddr_copy(&n->addr, addr);
       n->transmissions = 0;
       n->collisions = CSMA_MIN_BE;
+#if CSMA_FAIR_QUEUING
+      n->ready = 0;
+      n->deficit = 0;
+#endif /* CSMA_FAIR_QUEUING */
+#if CSMA_WITH_CODEL
+      codel_init(&n->codel);
+#endif /* CSMA_WITH_CODEL */
       /* Init packet list for this neighbor */
       LIST_STRUCT_INIT(n, queued_packet_list);
       /* Add neighbor to the list */
@@ -421,16 +680,39 @@ send_packet(mac_callback_t sent, void *ptr)
             }
             metadata->sent = sent;
             metadata->cptr = ptr;
+            metadata->traffic_class = packet_class();
+            metadata->enqueued = clock_time();
 #if PACKETBUF_WITH_PACKET_TYPE
             if(packetbuf_attr(PACKETBUF_ATTR_PACKET_TYPE) ==
                PACKETBUF_ATTR_PACKET_TYPE_ACK) {
               list_push(n->queued_packet_list, q);
             } else
 #endif
+#if CSMA_FAIR_QUEUING
+            if(metadata->traffic_class == CSMA_CLASS_CONTROL) {
+              /* Queue control packets behind the packet currently being
+                 sent and any earlier control packets, but ahead of data */
+              struct rdc_buf_list *prev = list_head(n->queued_packet_list);
+              struct rdc_buf_list *next;
+              while(prev != NULL && (next = list_item_next(prev)) != NULL &&
+                    ((struct qbuf_metadata *)next->ptr)->traffic_class ==
+                    CSMA_CLASS_CONTROL) {
+                prev = next;
+              }
+              list_insert(n->queued_packet_list, prev, q);
+            } else
+#endif /* CSMA_FAIR_QUEUING */
             {
               list_add(n->queued_packet_list, q);
             }
 
+            class_stats[metadata->traffic_class].queued++;
+            if(class_stats[metadata->traffic_class].queued >
+               class_stats[metadata->traffic_class].max_queued) {
+              class_stats[metadata->traffic_class].max_queued =
+                class_stats[metadata->traffic_class].queued;
+            }
+
             PRINTF("csma: send_packet, queue length %d, free packets %d\n",
                    list_length(n->queued_packet_list), memb_numfree(&packet_memb));
             /* If q is the first packet in the neighbor's queue, send asap */
@@ -43,9 +43,34 @@
 
 #include "net/mac/mac.h"
 #include "dev/radio.h"
+#include "sys/clock.h"
+
+/* Traffic classes used for scheduling and statistics */
+enum {
+  CSMA_CLASS_CONTROL,
+  CSMA_CLASS_DATA,
+  CSMA_NUM_CLASSES
+};
+
+/* Per-class queueing statistics */
+struct csma_class_stats {
+  uint16_t queued;        /* packets currently queued */
+  uint16_t max_queued;    /* highest number of packets queued at once */
+  uint32_t dequeued;      /* packets removed from the queue */
+  uint32_t sojourn_total; /* total time spent queued, in clock ticks */
+  clock_time_t sojourn_max;
+  uint16_t dropped;       /* packets dropped by active queue management */
+};
 
 extern const struct mac_driver csma_driver;
 
+/**
+ * \brief      Get queueing statistics for a traffic class
+ * \param traffic_class One of CSMA_CLASS_CONTROL or CSMA_CLASS_DATA
+ * \return     A pointer to the statistics, or NULL for an unknown class
+ */
+const struct csma_class_stats *csma_get_class_stats(uint8_t traffic_class);
+
 const struct mac_driver *csma_init(const struct mac_driver *r);
 
 #endif /* CSMA_H_ */
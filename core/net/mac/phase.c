@@ -50,10 +50,39 @@
 #define PHASE_DRIFT_CORRECT 0
 #endif
 
+#if PHASE_DRIFT_CORRECT
+/* Samples taken further apart than this are not used to estimate the
+   drift, and no drift correction is applied further than this from the
+   last update. */
+#ifdef PHASE_CONF_DRIFT_MAX_AGE
+#define PHASE_DRIFT_MAX_AGE PHASE_CONF_DRIFT_MAX_AGE
+#else
+#define PHASE_DRIFT_MAX_AGE (10 * 60 * CLOCK_SECOND)
+#endif
+
+/* Largest relative clock drift we expect between two nodes, in ppm.
+   Samples implying a larger drift are discarded. */
+#ifdef PHASE_CONF_DRIFT_MAX_PPM
+#define PHASE_DRIFT_MAX_PPM PHASE_CONF_DRIFT_MAX_PPM
+#else
+#define PHASE_DRIFT_MAX_PPM 200
+#endif
+
+/* A sample spanning this many cycles or more gets full weight in the
+   drift average. Shorter samples are dominated by strobe timing jitter
+   and get proportionally less weight. */
+#define DRIFT_FULL_WEIGHT_CYCLES 64
+
+/* The drift is stored in 1/256 rtimer ticks per cycle */
+#define DRIFT_SHIFT 8
+#endif /* PHASE_DRIFT_CORRECT */
+
 struct phase {
   rtimer_clock_t time;
 #if PHASE_DRIFT_CORRECT
-  rtimer_clock_t drift;
+  clock_time_t clock;   /* clock_time() when time was recorded */
+  int32_t drift;        /* estimated phase drift per cycle */
+  uint8_t has_drift;
 #endif
   uint8_t noacks;
   struct timer noacks_timer;
@@ -87,9 +116,73 @@ NBR_TABLE(struct phase, nbr_phase);
 #define PRINTDEBUG(...)
 #endif
 /*---------------------------------------------------------------------------*/
+#if PHASE_DRIFT_CORRECT
+/* Time elapsed since the phase of e was recorded, in rtimer ticks. If
+   rtimer_clock_t is narrower than 32 bits, it wraps too often to measure
+   long intervals: clock_time() is then used to count the wraps. */
+static uint32_t
+elapsed_since(const struct phase *e, rtimer_clock_t now)
+{
+  rtimer_clock_t fine = now - e->time;
+  uint32_t ticks;
+  uint32_t coarse;
+
+  if(sizeof(rtimer_clock_t) >= sizeof(uint32_t)) {
+    return (uint32_t)fine;
+  }
+  ticks = (clock_time_t)(clock_time() - e->clock);
+  coarse = (ticks / CLOCK_SECOND) * RTIMER_ARCH_SECOND +
+    (ticks % CLOCK_SECOND) * RTIMER_ARCH_SECOND / CLOCK_SECOND;
+  return coarse + (int16_t)(rtimer_clock_t)(fine - (rtimer_clock_t)coarse);
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_drift(struct phase *e, rtimer_clock_t cycle_time, rtimer_clock_t time)
+{
+  uint32_t elapsed;
+  uint32_t cycles;
+  int32_t error;
+  int32_t sample;
+  int32_t max_drift;
+  int32_t weight;
+
+  if((clock_time_t)(clock_time() - e->clock) > PHASE_DRIFT_MAX_AGE) {
+    return;
+  }
+
+  /* The receiver wakes up every cycle: any offset from a whole number
+     of cycles since the last encounter is drift. */
+  elapsed = elapsed_since(e, time);
+  cycles = (elapsed + cycle_time / 2) / cycle_time;
+  if(cycles == 0) {
+    return;
+  }
+  error = (int32_t)(elapsed - cycles * cycle_time);
+  sample = (error << DRIFT_SHIFT) / (int32_t)cycles;
+
+  max_drift = ((uint32_t)cycle_time * PHASE_DRIFT_MAX_PPM << DRIFT_SHIFT) /
+    1000000;
+  if(max_drift == 0) {
+    max_drift = 1;
+  }
+  if(sample > max_drift || sample < -max_drift) {
+    PRINTF("phase: discarding drift sample %ld\n", (long)sample);
+    return;
+  }
+
+  if(!e->has_drift) {
+    e->drift = sample;
+    e->has_drift = 1;
+  } else {
+    weight = MIN(cycles, DRIFT_FULL_WEIGHT_CYCLES);
+    e->drift += (sample - e->drift) * weight / (4 * DRIFT_FULL_WEIGHT_CYCLES);
+  }
+}
+#endif /* PHASE_DRIFT_CORRECT */
+/*---------------------------------------------------------------------------*/
 void
-phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
-             int mac_status)
+phase_update(const linkaddr_t *neighbor, rtimer_clock_t cycle_time,
+             rtimer_clock_t time, int mac_status)
 {
   struct phase *e;
 
@@ -98,7 +191,8 @@ phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
   if(e != NULL) {
     if(mac_status == MAC_TX_OK) {
 #if PHASE_DRIFT_CORRECT
-      e->drift = time-e->time;
+      update_drift(e, cycle_time, time);
+      e->clock = clock_time();
 #endif
       e->time = time;
     }
@@ -126,9 +220,11 @@ phase_update(const linkaddr_t *neighbor, rtimer_clock_t time,
       if(e) {
         e->time = time;
 #if PHASE_DRIFT_CORRECT
-      e->drift = 0;
+        e->clock = clock_time();
+        e->drift = 0;
+        e->has_drift = 0;
 #endif
-      e->noacks = 0;
+        e->noacks = 0;
       }
     }
   }
@@ -186,13 +282,11 @@ phase_wait(const linkaddr_t *neighbor, rtimer_clock_t cycle_time,
     sync = (e == NULL) ? now : e->time;
 
 #if PHASE_DRIFT_CORRECT
-    {
-      int32_t s;
-      if(e->drift > cycle_time) {
-        s = e->drift % cycle_time / (e->drift / cycle_time);  /* drift per cycle */
-        s = s * (now - sync) / cycle_time;                    /* estimated drift to now */
-        sync += s;                                            /* add it in */
-      }
+    if(e->has_drift &&
+       (clock_time_t)(clock_time() - e->clock) <= PHASE_DRIFT_MAX_AGE) {
+      /* Shift the recorded phase by the drift accumulated since then */
+      uint32_t cycles = elapsed_since(e, now) / cycle_time;
+      sync += (e->drift * (int32_t)cycles) >> DRIFT_SHIFT;
     }
 #endif
 
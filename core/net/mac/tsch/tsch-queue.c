@@ -68,6 +68,12 @@
 #error TSCH_QUEUE_NUM_PER_NEIGHBOR must be power of two
 #endif
 
+/* TSCH reads queuebufs from interrupt context, while managed memory
+   moves them around whenever a block is freed or resized */
+#if QUEUEBUF_WITH_MMEM
+#error "TSCH cannot be used with QUEUEBUF_CONF_WITH_MMEM"
+#endif
+
 /* We have as many packets are there are queuebuf in the system */
 MEMB(packet_memb, struct tsch_packet, QUEUEBUF_NUM);
 MEMB(neighbor_memb, struct tsch_neighbor, TSCH_QUEUE_MAX_NEIGHBOR_QUEUES);
@@ -97,6 +103,9 @@ tsch_queue_add_nbr(const linkaddr_t *addr)
         n->is_broadcast = linkaddr_cmp(addr, &tsch_eb_address)
           || linkaddr_cmp(addr, &tsch_broadcast_address);
         tsch_queue_backoff_reset(n);
+#if TSCH_QUEUE_WITH_CODEL
+        codel_init(&n->codel);
+#endif
         /* Add neighbor to the list */
         list_add(neighbor_list, n);
       }
@@ -227,6 +236,40 @@ tsch_queue_remove_nbr(struct tsch_neighbor *n)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if TSCH_QUEUE_WITH_CODEL
+/* Drop stale packets from the head of a unicast neighbor queue. Takes the
+ * TSCH lock, so that no packet is dropped while being transmitted. Dropped
+ * packets go to dequeued_ringbuf, so that their packet_sent callback is
+ * called later from the TSCH process, as for packets dropped after Tx. */
+static void
+tsch_queue_codel_drop(struct tsch_neighbor *n)
+{
+  int dropped = 0;
+  if(tsch_get_lock()) {
+    int16_t get_index;
+    int16_t dequeued_index;
+    while((get_index = ringbufindex_peek_get(&n->tx_ringbuf)) != -1
+          && (dequeued_index = ringbufindex_peek_put(&dequeued_ringbuf)) != -1) {
+      struct tsch_packet *p = n->tx_array[get_index];
+      if(!codel_drop(&n->codel, clock_time() - p->enqueued,
+                     ringbufindex_elements(&n->tx_ringbuf))) {
+        break;
+      }
+      PRINTF("TSCH-queue:! codel drop packet=%p\n", p);
+      ringbufindex_get(&n->tx_ringbuf);
+      p->ret = MAC_TX_ERR;
+      dequeued_array[dequeued_index] = p;
+      ringbufindex_put(&dequeued_ringbuf);
+      dropped = 1;
+    }
+    tsch_release_lock();
+  }
+  if(dropped) {
+    process_poll(&tsch_pending_events_process);
+  }
+}
+#endif /* TSCH_QUEUE_WITH_CODEL */
+/*---------------------------------------------------------------------------*/
 /* Add packet to neighbor queue. Use same lockfree implementation as ringbuf.c (put is atomic) */
 struct tsch_packet *
 tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
@@ -237,6 +280,11 @@ tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
   if(!tsch_is_locked()) {
     n = tsch_queue_add_nbr(addr);
     if(n != NULL) {
+#if TSCH_QUEUE_WITH_CODEL
+      if(!n->is_broadcast) {
+        tsch_queue_codel_drop(n);
+      }
+#endif
       put_index = ringbufindex_peek_put(&n->tx_ringbuf);
       if(put_index != -1) {
         p = memb_alloc(&packet_memb);
@@ -251,6 +299,9 @@ tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
             p->ptr = ptr;
             p->ret = MAC_TX_DEFERRED;
             p->transmissions = 0;
+#if TSCH_QUEUE_WITH_CODEL
+            p->enqueued = clock_time();
+#endif
             /* Add to ringbuf (actual add committed through atomic operation) */
             n->tx_array[put_index] = p;
             ringbufindex_put(&n->tx_ringbuf);
@@ -40,6 +40,7 @@
 #include "net/linkaddr.h"
 #include "net/mac/tsch/tsch-schedule.h"
 #include "net/mac/mac.h"
+#include "net/mac/codel.h"
 
 /******** Configuration *******/
 
@@ -97,6 +98,15 @@
 #define TSCH_MAC_MAX_FRAME_RETRIES 8
 #endif
 
+/* Drop unicast packets that have been queued for too long, using CoDel.
+ * The check is done in process context, when a packet is added to the
+ * queue of a neighbor. */
+#ifdef TSCH_QUEUE_CONF_WITH_CODEL
+#define TSCH_QUEUE_WITH_CODEL TSCH_QUEUE_CONF_WITH_CODEL
+#else
+#define TSCH_QUEUE_WITH_CODEL 0
+#endif
+
 /*********** Callbacks *********/
 
 /* Called by TSCH when switching time source */
@@ -121,6 +131,9 @@ struct tsch_packet {
   uint8_t ret; /* status -- MAC return code */
   uint8_t header_len; /* length of header and header IEs (needed for link-layer security) */
   uint8_t tsch_sync_ie_offset; /* Offset within the frame used for quick update of EB ASN and join priority */
+#if TSCH_QUEUE_WITH_CODEL
+  clock_time_t enqueued; /* time at which the packet was queued */
+#endif
 };
 
 /* TSCH neighbor information */
@@ -140,6 +153,9 @@ struct tsch_neighbor {
   struct tsch_packet *tx_array[TSCH_QUEUE_NUM_PER_NEIGHBOR];
   /* Circular buffer of pointers to packet. */
   struct ringbufindex tx_ringbuf;
+#if TSCH_QUEUE_WITH_CODEL
+  struct codel codel; /* Active queue management state */
+#endif
 };
 
 /***** External Variables *****/
@@ -47,6 +47,15 @@
 #if WITH_SWAP
 #include "cfs/cfs.h"
 #endif
+#if QUEUEBUF_WITH_MMEM
+#include "lib/mmem.h"
+#if WITH_SWAP
+#error "QUEUEBUF_CONF_WITH_MMEM cannot be combined with swapping"
+#endif /* WITH_SWAP */
+#ifndef MMEM_CONF_ALIGNMENT
+#error "QUEUEBUF_CONF_WITH_MMEM needs MMEM_CONF_ALIGNMENT"
+#endif /* MMEM_CONF_ALIGNMENT */
+#endif /* QUEUEBUF_WITH_MMEM */
 
 #include <string.h> /* for memcpy() */
 
@@ -59,6 +68,9 @@ struct queuebuf {
   int line;
   clock_time_t time;
 #endif /* QUEUEBUF_DEBUG */
+#if QUEUEBUF_WITH_MMEM
+  struct mmem mem;
+#else /* QUEUEBUF_WITH_MMEM */
 #if WITH_SWAP
   enum {IN_RAM, IN_CFS} location;
   union {
@@ -68,6 +80,7 @@ struct queuebuf {
     int swap_id;
   };
 #endif
+#endif /* QUEUEBUF_WITH_MMEM */
 };
 
 /* The actual queuebuf data */
@@ -79,7 +92,23 @@ struct queuebuf_data {
 };
 
 MEMB(bufmem, struct queuebuf, QUEUEBUF_NUM);
+#if !QUEUEBUF_WITH_MMEM
 MEMB(buframmem, struct queuebuf_data, QUEUEBUFRAM_NUM);
+#endif /* !QUEUEBUF_WITH_MMEM */
+
+#if QUEUEBUF_WITH_MMEM
+/* The header of a queuebuf stored in managed memory. It is followed
+   by num_attrs attribute values, the num_attrs types of these
+   attributes, and len bytes of frame data. Attributes that are not
+   stored are zero. */
+struct queuebuf_mdata {
+  uint16_t len;
+  uint8_t num_attrs;
+  struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+};
+
+#define MDATA(b) ((struct queuebuf_mdata *)(b)->mem.ptr)
+#endif /* QUEUEBUF_WITH_MMEM */
 
 #if WITH_SWAP
 
@@ -267,7 +296,128 @@ queuebuf_load_to_ram(struct queuebuf *b)
     }
   }
 }
-#else /* WITH_SWAP */
+#elif QUEUEBUF_WITH_MMEM
+/*---------------------------------------------------------------------------*/
+static unsigned int
+mdata_size(uint8_t num_attrs, uint16_t len)
+{
+  return sizeof(struct queuebuf_mdata)
+      + num_attrs * (sizeof(packetbuf_attr_t) + 1) + len;
+}
+/*---------------------------------------------------------------------------*/
+static packetbuf_attr_t *
+mdata_vals(struct queuebuf_mdata *d)
+{
+  return (packetbuf_attr_t *)(d + 1);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+mdata_types(struct queuebuf_mdata *d)
+{
+  return (uint8_t *)(mdata_vals(d) + d->num_attrs);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+mdata_data(struct queuebuf_mdata *d)
+{
+  return mdata_types(d) + d->num_attrs;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+packetbuf_num_attrs(void)
+{
+  uint8_t type;
+  uint8_t num_attrs;
+
+  num_attrs = 0;
+  for(type = 0; type < PACKETBUF_NUM_ATTRS; type++) {
+    if(packetbuf_attr(type) != 0) {
+      num_attrs++;
+    }
+  }
+  return num_attrs;
+}
+/*---------------------------------------------------------------------------*/
+/* Resizes the memory block of b to hold num_attrs attributes and len
+   bytes of data. Existing attributes and data are kept, as far as
+   they fit. */
+static int
+mdata_resize(struct queuebuf *b, uint8_t num_attrs, uint16_t len)
+{
+  struct queuebuf_mdata *d;
+  uint8_t old_num_attrs;
+  uint8_t *old_types;
+  uint8_t *old_data;
+  uint16_t data_len;
+  unsigned int old_size;
+  unsigned int new_size;
+
+  old_size = mdata_size(MDATA(b)->num_attrs, MDATA(b)->len);
+  new_size = mdata_size(num_attrs, len);
+  if(new_size > old_size && !mmem_realloc(&b->mem, new_size)) {
+    return 0;
+  }
+
+  d = MDATA(b);
+  old_num_attrs = d->num_attrs;
+  old_types = mdata_types(d);
+  old_data = mdata_data(d);
+  data_len = MIN(d->len, len);
+  d->num_attrs = num_attrs;
+  d->len = len;
+  if(num_attrs > old_num_attrs) {
+    /* the types and the data move up: start with the data */
+    memmove(mdata_data(d), old_data, data_len);
+    memmove(mdata_types(d), old_types, old_num_attrs);
+  } else if(num_attrs < old_num_attrs) {
+    memmove(mdata_types(d), old_types, num_attrs);
+    memmove(mdata_data(d), old_data, data_len);
+  }
+
+  if(new_size < old_size) {
+    mmem_realloc(&b->mem, new_size);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+mdata_attr_from_packetbuf(struct queuebuf_mdata *d)
+{
+  packetbuf_attr_t *vals;
+  uint8_t *types;
+  uint8_t type;
+  uint8_t i;
+
+  vals = mdata_vals(d);
+  types = mdata_types(d);
+  i = 0;
+  for(type = 0; type < PACKETBUF_NUM_ATTRS && i < d->num_attrs; type++) {
+    if(packetbuf_attr(type) != 0) {
+      vals[i] = packetbuf_attr(type);
+      types[i] = type;
+      i++;
+    }
+  }
+  for(i = 0; i < PACKETBUF_NUM_ADDRS; i++) {
+    linkaddr_copy(&d->addrs[i].addr, packetbuf_addr(PACKETBUF_ADDR_FIRST + i));
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+mdata_find_attr(struct queuebuf_mdata *d, uint8_t type)
+{
+  uint8_t *types;
+  uint8_t i;
+
+  types = mdata_types(d);
+  for(i = 0; i < d->num_attrs; i++) {
+    if(types[i] == type) {
+      return i;
+    }
+  }
+  return -1;
+}
+#else /* QUEUEBUF_WITH_MMEM */
 /*---------------------------------------------------------------------------*/
 static struct queuebuf_data *
 queuebuf_load_to_ram(struct queuebuf *b)
@@ -286,7 +436,11 @@ queuebuf_init(void)
     qbuf_renew_file(i);
   }
 #endif
+#if QUEUEBUF_WITH_MMEM
+  mmem_init();
+#else /* QUEUEBUF_WITH_MMEM */
   memb_init(&buframmem);
+#endif /* QUEUEBUF_WITH_MMEM */
   memb_init(&bufmem);
 #if QUEUEBUF_STATS
   queuebuf_max_len = 0;
@@ -309,15 +463,34 @@ queuebuf_new_from_packetbuf(void)
 {
   struct queuebuf *buf;
 
+#if QUEUEBUF_WITH_MMEM
+  uint8_t num_attrs;
+  uint16_t len;
+#else /* QUEUEBUF_WITH_MMEM */
   struct queuebuf_data *buframptr;
+#endif /* QUEUEBUF_WITH_MMEM */
   buf = memb_alloc(&bufmem);
   if(buf != NULL) {
+#if QUEUEBUF_WITH_MMEM
+    num_attrs = packetbuf_num_attrs();
+    len = packetbuf_totlen();
+    if(!mmem_alloc(&buf->mem, mdata_size(num_attrs, len))) {
+      PRINTF("queuebuf_new_from_packetbuf: could not allocate %u bytes\n",
+             mdata_size(num_attrs, len));
+      memb_free(&bufmem, buf);
+      return NULL;
+    }
+    MDATA(buf)->num_attrs = num_attrs;
+    MDATA(buf)->len = packetbuf_copyto(mdata_data(MDATA(buf)));
+    mdata_attr_from_packetbuf(MDATA(buf));
+#endif /* QUEUEBUF_WITH_MMEM */
 #if QUEUEBUF_DEBUG
     list_add(queuebuf_list, buf);
     buf->file = file;
     buf->line = line;
     buf->time = clock_time();
 #endif /* QUEUEBUF_DEBUG */
+#if !QUEUEBUF_WITH_MMEM
     buf->ram_ptr = memb_alloc(&buframmem);
 #if WITH_SWAP
     /* If the allocation failed, store the qbuf in swap files */
@@ -351,6 +524,7 @@ queuebuf_new_from_packetbuf(void)
       }
     }
 #endif
+#endif /* !QUEUEBUF_WITH_MMEM */
 
 #if QUEUEBUF_STATS
     ++queuebuf_len;
@@ -366,9 +540,16 @@ queuebuf_new_from_packetbuf(void)
   return buf;
 }
 /*---------------------------------------------------------------------------*/
-void
+int
 queuebuf_update_attr_from_packetbuf(struct queuebuf *buf)
 {
+#if QUEUEBUF_WITH_MMEM
+  if(!mdata_resize(buf, packetbuf_num_attrs(), MDATA(buf)->len)) {
+    PRINTF("queuebuf_update_attr_from_packetbuf: could not resize\n");
+    return 0;
+  }
+  mdata_attr_from_packetbuf(MDATA(buf));
+#else /* QUEUEBUF_WITH_MMEM */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
   packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
 #if WITH_SWAP
@@ -376,11 +557,21 @@ queuebuf_update_attr_from_packetbuf(struct queuebuf *buf)
     queuebuf_flush_tmpdata();
   }
 #endif
+#endif /* QUEUEBUF_WITH_MMEM */
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
-void
+int
 queuebuf_update_from_packetbuf(struct queuebuf *buf)
 {
+#if QUEUEBUF_WITH_MMEM
+  if(!mdata_resize(buf, packetbuf_num_attrs(), packetbuf_totlen())) {
+    PRINTF("queuebuf_update_from_packetbuf: could not resize\n");
+    return 0;
+  }
+  mdata_attr_from_packetbuf(MDATA(buf));
+  packetbuf_copyto(mdata_data(MDATA(buf)));
+#else /* QUEUEBUF_WITH_MMEM */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
   packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
   buframptr->len = packetbuf_copyto(buframptr->data);
@@ -389,13 +580,17 @@ queuebuf_update_from_packetbuf(struct queuebuf *buf)
     queuebuf_flush_tmpdata();
   }
 #endif
+#endif /* QUEUEBUF_WITH_MMEM */
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
 void
 queuebuf_free(struct queuebuf *buf)
 {
   if(memb_inmemb(&bufmem, buf)) {
-#if WITH_SWAP
+#if QUEUEBUF_WITH_MMEM
+    mmem_free(&buf->mem);
+#elif WITH_SWAP
     if(buf->location == IN_RAM) {
       memb_free(&buframmem, buf->ram_ptr);
     } else {
@@ -419,9 +614,27 @@ void
 queuebuf_to_packetbuf(struct queuebuf *b)
 {
   if(memb_inmemb(&bufmem, b)) {
+#if QUEUEBUF_WITH_MMEM
+    struct queuebuf_mdata *d = MDATA(b);
+    packetbuf_attr_t *vals;
+    uint8_t *types;
+    uint8_t i;
+
+    /* packetbuf_copyfrom() clears all attributes */
+    packetbuf_copyfrom(mdata_data(d), d->len);
+    vals = mdata_vals(d);
+    types = mdata_types(d);
+    for(i = 0; i < d->num_attrs; i++) {
+      packetbuf_set_attr(types[i], vals[i]);
+    }
+    for(i = 0; i < PACKETBUF_NUM_ADDRS; i++) {
+      packetbuf_set_addr(PACKETBUF_ADDR_FIRST + i, &d->addrs[i].addr);
+    }
+#else /* QUEUEBUF_WITH_MMEM */
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
     packetbuf_copyfrom(buframptr->data, buframptr->len);
     packetbuf_attr_copyfrom(buframptr->attrs, buframptr->addrs);
+#endif /* QUEUEBUF_WITH_MMEM */
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -429,12 +642,38 @@ void *
 queuebuf_dataptr(struct queuebuf *b)
 {
   if(memb_inmemb(&bufmem, b)) {
+#if QUEUEBUF_WITH_MMEM
+    return mdata_data(MDATA(b));
+#else /* QUEUEBUF_WITH_MMEM */
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
     return buframptr->data;
+#endif /* QUEUEBUF_WITH_MMEM */
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+#if QUEUEBUF_WITH_MMEM
+int
+queuebuf_datalen(struct queuebuf *b)
+{
+  return MDATA(b)->len;
+}
+/*---------------------------------------------------------------------------*/
+linkaddr_t *
+queuebuf_addr(struct queuebuf *b, uint8_t type)
+{
+  return &MDATA(b)->addrs[type - PACKETBUF_ADDR_FIRST].addr;
+}
+/*---------------------------------------------------------------------------*/
+packetbuf_attr_t
+queuebuf_attr(struct queuebuf *b, uint8_t type)
+{
+  int i;
+
+  i = mdata_find_attr(MDATA(b), type);
+  return i < 0 ? 0 : mdata_vals(MDATA(b))[i];
+}
+#else /* QUEUEBUF_WITH_MMEM */
 int
 queuebuf_datalen(struct queuebuf *b)
 {
@@ -455,6 +694,7 @@ queuebuf_attr(struct queuebuf *b, uint8_t type)
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
   return buframptr->attrs[type].val;
 }
+#endif /* QUEUEBUF_WITH_MMEM */
 /*---------------------------------------------------------------------------*/
 void
 queuebuf_debug_print(void)
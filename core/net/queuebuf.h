@@ -85,6 +85,22 @@
 #define QUEUEBUF_DEBUG 0
 #endif /* QUEUEBUF_CONF_DEBUG */
 
+/* If QUEUEBUF_CONF_WITH_MMEM is set, the frames are stored in the
+   managed memory heap (see MMEM_CONF_SIZE) in blocks sized to the
+   actual frame length, and only the attributes that are set are
+   stored. QUEUEBUF_NUM then limits the number of queuebufs, but not
+   the memory they use. Since mmem moves blocks when others are freed,
+   pointers returned by queuebuf_dataptr() and queuebuf_addr() are
+   only valid until the next queuebuf is freed or changed. This rules
+   out MAC layers that access queuebufs from interrupt context, such
+   as TSCH. The blocks hold 16-bit fields, so MMEM_CONF_ALIGNMENT must
+   be set as well, to 2 or more. */
+#ifdef QUEUEBUF_CONF_WITH_MMEM
+#define QUEUEBUF_WITH_MMEM QUEUEBUF_CONF_WITH_MMEM
+#else /* QUEUEBUF_CONF_WITH_MMEM */
+#define QUEUEBUF_WITH_MMEM 0
+#endif /* QUEUEBUF_CONF_WITH_MMEM */
+
 struct queuebuf;
 
 void queuebuf_init(void);
@@ -95,8 +111,11 @@ struct queuebuf *queuebuf_new_from_packetbuf_debug(const char *file, int line);
 #else /* QUEUEBUF_DEBUG */
 struct queuebuf *queuebuf_new_from_packetbuf(void);
 #endif /* QUEUEBUF_DEBUG */
-void queuebuf_update_attr_from_packetbuf(struct queuebuf *b);
-void queuebuf_update_from_packetbuf(struct queuebuf *b);
+/* The update functions return 0 if the queuebuf could not be resized
+   to hold the new contents of the packetbuf, which can only happen
+   with QUEUEBUF_CONF_WITH_MMEM. The queuebuf is then left as it was. */
+int queuebuf_update_attr_from_packetbuf(struct queuebuf *b);
+int queuebuf_update_from_packetbuf(struct queuebuf *b);
 
 void queuebuf_to_packetbuf(struct queuebuf *b);
 void queuebuf_free(struct queuebuf *b);
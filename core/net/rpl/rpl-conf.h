@@ -84,6 +84,19 @@
 #define RPL_WITH_MC 0
 #endif /* RPL_CONF_WITH_MC */
 
+/*
+ * Cache the link metric of each parent in its rpl_parent_t. Parent
+ * selection evaluates the metric of every candidate several times,
+ * and each evaluation otherwise costs a link-stats table lookup. The
+ * cached value is dropped whenever the link statistics of the parent
+ * are updated.
+ */
+#ifdef RPL_CONF_WITH_PARENT_METRIC_CACHE
+#define RPL_WITH_PARENT_METRIC_CACHE RPL_CONF_WITH_PARENT_METRIC_CACHE
+#else /* RPL_CONF_WITH_PARENT_METRIC_CACHE */
+#define RPL_WITH_PARENT_METRIC_CACHE 1
+#endif /* RPL_CONF_WITH_PARENT_METRIC_CACHE */
+
 /* The MC advertised in DIOs and propagating from the root */
 #ifdef RPL_CONF_DAG_MC
 #define RPL_DAG_MC RPL_CONF_DAG_MC
@@ -245,6 +258,29 @@
 #define RPL_WITH_DAO_ACK 0
 #endif /* RPL_CONF_WITH_DAO_ACK */
 
+/*
+ * RPL DAO aggregation. When enabled, a storing mode router does not
+ * forward each DAO it receives on its own, but collects their targets
+ * for RPL_DAO_AGGREGATION_DELAY and sends them to its preferred parent
+ * in a single DAO. Parents must be able to handle DAOs with multiple
+ * targets, which this implementation always does.
+ * */
+#ifdef RPL_CONF_WITH_DAO_AGGREGATION
+#define RPL_WITH_DAO_AGGREGATION RPL_CONF_WITH_DAO_AGGREGATION
+#else
+#define RPL_WITH_DAO_AGGREGATION 0
+#endif /* RPL_CONF_WITH_DAO_AGGREGATION */
+
+/*
+ * Maximum number of targets in an aggregated DAO. Fewer are sent if
+ * the DAO would not fit in the uIP buffer.
+ * */
+#ifdef RPL_CONF_DAO_AGGREGATION_MAX_TARGETS
+#define RPL_DAO_AGGREGATION_MAX_TARGETS RPL_CONF_DAO_AGGREGATION_MAX_TARGETS
+#else
+#define RPL_DAO_AGGREGATION_MAX_TARGETS 8
+#endif /* RPL_CONF_DAO_AGGREGATION_MAX_TARGETS */
+
 /*
  * RPL REPAIR ON DAO NACK. When enabled, DAO NACK will trigger a local
  * repair in order to quickly find a new parent to send DAO's to.
@@ -93,13 +93,9 @@ rpl_print_neighbor_list(void)
 {
   if(default_instance != NULL && default_instance->current_dag != NULL &&
       default_instance->of != NULL) {
-    int curr_dio_interval = default_instance->dio_intcurrent;
-    int curr_rank = default_instance->current_dag->rank;
     rpl_parent_t *p = nbr_table_head(rpl_parents);
     clock_time_t clock_now = clock_time();
 
-    /*printf("RPL: MOP %u OCP %u rank %u dioint %u, nbr count %u\n",
-        default_instance->mop, default_instance->of->ocp, curr_rank, curr_dio_interval, uip_ds6_nbr_num());*/
     printf("Neighbors count: %u\n",uip_ds6_nbr_num());
     while(p != NULL) {
       const struct link_stats *stats = rpl_get_parent_link_stats(p);
@@ -171,7 +167,23 @@ rpl_get_parent_link_metric(rpl_parent_t *p)
   if(p != NULL && p->dag != NULL) {
     rpl_instance_t *instance = p->dag->instance;
     if(instance != NULL && instance->of != NULL && instance->of->parent_link_metric != NULL) {
+#if RPL_WITH_PARENT_METRIC_CACHE
+      if(p->flags & RPL_PARENT_FLAG_LINK_METRIC_VALID) {
+        RPL_STAT(rpl_stats.metric_cache_hits++);
+        return p->link_metric;
+      }
+      RPL_STAT(rpl_stats.metric_cache_misses++);
+      p->link_metric = instance->of->parent_link_metric(p);
+      /* A neighbor without link statistics yet has the worst metric.
+         Its statistics may be created without notifying RPL, so only
+         a metric computed from actual statistics is kept. */
+      if(p->link_metric != 0xffff) {
+        p->flags |= RPL_PARENT_FLAG_LINK_METRIC_VALID;
+      }
+      return p->link_metric;
+#else /* RPL_WITH_PARENT_METRIC_CACHE */
       return instance->of->parent_link_metric(p);
+#endif /* RPL_WITH_PARENT_METRIC_CACHE */
     }
   }
   return 0xffff;
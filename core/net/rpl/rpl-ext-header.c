@@ -322,6 +322,95 @@ count_matching_bytes(const void *p1, const void *p2, size_t n)
   return n;
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_NS_ROUTE_CACHE_SIZE
+/* The source routes to the most recent destinations, valid as long as
+   the topology version is unchanged. An entry holds the addresses
+   field of the SRH and the first hop, so that a packet to a cached
+   destination needs no walk up the parent chain. */
+struct route_cache_entry {
+  rpl_ns_node_t *dest_node;
+  rpl_ns_node_t *root_node;
+  uint32_t topology_version;
+  uint8_t path_len;
+  uint8_t cmpri;
+  uip_ipaddr_t next_hop;
+  uint8_t addresses[RPL_NS_ROUTE_CACHE_ADDR_LEN];
+};
+static struct route_cache_entry route_cache[RPL_NS_ROUTE_CACHE_SIZE];
+static uint8_t route_cache_next;
+/*---------------------------------------------------------------------------*/
+static struct route_cache_entry *
+route_cache_lookup(rpl_ns_node_t *dest_node, rpl_ns_node_t *root_node)
+{
+  int i;
+
+  for(i = 0; i < RPL_NS_ROUTE_CACHE_SIZE; i++) {
+    if(route_cache[i].dest_node == dest_node
+       && route_cache[i].root_node == root_node
+       && route_cache[i].topology_version == rpl_ns_topology_version()) {
+      return &route_cache[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+route_cache_add(rpl_ns_node_t *dest_node, rpl_ns_node_t *root_node,
+                uint8_t path_len, uint8_t cmpri,
+                const uint8_t *addresses, const uip_ipaddr_t *next_hop)
+{
+  struct route_cache_entry *e;
+  uint16_t addr_len;
+
+  addr_len = path_len * (16 - cmpri);
+  if(addr_len > RPL_NS_ROUTE_CACHE_ADDR_LEN) {
+    /* Too long to cache, the route is walked for every packet */
+    return;
+  }
+
+  e = &route_cache[route_cache_next];
+  route_cache_next = (route_cache_next + 1) % RPL_NS_ROUTE_CACHE_SIZE;
+  e->dest_node = dest_node;
+  e->root_node = root_node;
+  e->topology_version = rpl_ns_topology_version();
+  e->path_len = path_len;
+  e->cmpri = cmpri;
+  uip_ipaddr_copy(&e->next_hop, next_hop);
+  memcpy(e->addresses, addresses, addr_len);
+}
+#endif /* RPL_NS_ROUTE_CACHE_SIZE */
+/*---------------------------------------------------------------------------*/
+/* Computes the number of hops between the root and the destination and
+   the number of prefix bytes they share with the destination. Returns 0
+   if the destination is not reachable. */
+static int
+get_route(rpl_dag_t *dag, rpl_ns_node_t *dest_node, rpl_ns_node_t *root_node,
+          uint8_t *path_len, uint8_t *cmpri)
+{
+  rpl_ns_node_t *node;
+  uip_ipaddr_t node_addr;
+
+  if(!rpl_ns_is_node_reachable(dag, &UIP_IP_BUF->destipaddr)) {
+    return 0;
+  }
+
+  *path_len = 0;
+  *cmpri = 15;
+  for(node = dest_node->parent; node != NULL && node != root_node;
+      node = node->parent) {
+    rpl_ns_get_node_global_addr(&node_addr, node);
+
+    /* How many bytes in common between all nodes in the path? */
+    *cmpri = MIN(*cmpri, count_matching_bytes(&node_addr, &UIP_IP_BUF->destipaddr, 16));
+
+    PRINTF("RPL: SRH Hop ");
+    PRINT6ADDR(&node_addr);
+    PRINTF("\n");
+    (*path_len)++;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static int
 insert_srh_header(void)
 {
@@ -337,6 +426,9 @@ insert_srh_header(void)
   rpl_ns_node_t *node;
   rpl_dag_t *dag;
   uip_ipaddr_t node_addr;
+#if RPL_NS_ROUTE_CACHE_SIZE
+  struct route_cache_entry *cached;
+#endif /* RPL_NS_ROUTE_CACHE_SIZE */
 
   PRINTF("RPL: SRH creating source routing header with destination ");
   PRINT6ADDR(&UIP_IP_BUF->destipaddr);
@@ -364,37 +456,26 @@ insert_srh_header(void)
     return 0;
   }
 
-  if(!rpl_ns_is_node_reachable(dag, &UIP_IP_BUF->destipaddr)) {
-    PRINTF("RPL: SRH no path found to destination\n");
-    return 0;
-  }
-
-  /* Compute path length and compression factors (we use cmpri == cmpre) */
-  path_len = 0;
-  node = dest_node->parent;
-  /* For simplicity, we use cmpri = cmpre */
-  cmpri = 15;
-  cmpre = 15;
-
-  if(node == root_node) {
+  if(dest_node->parent == root_node) {
     PRINTF("RPL: SRH no need to insert SRH\n");
     return 1;
   }
 
-  while(node != NULL && node != root_node) {
-
-    rpl_ns_get_node_global_addr(&node_addr, node);
-
-    /* How many bytes in common between all nodes in the path? */
-    cmpri = MIN(cmpri, count_matching_bytes(&node_addr, &UIP_IP_BUF->destipaddr, 16));
-    cmpre = cmpri;
-
-    PRINTF("RPL: SRH Hop ");
-    PRINT6ADDR(&node_addr);
-    PRINTF("\n");
-    node = node->parent;
-    path_len++;
+#if RPL_NS_ROUTE_CACHE_SIZE
+  /* A cached route was reachable when computed and the topology has
+     not changed since */
+  cached = route_cache_lookup(dest_node, root_node);
+  if(cached != NULL) {
+    path_len = cached->path_len;
+    cmpri = cached->cmpri;
+  } else
+#endif /* RPL_NS_ROUTE_CACHE_SIZE */
+  if(!get_route(dag, dest_node, root_node, &path_len, &cmpri)) {
+    PRINTF("RPL: SRH no path found to destination\n");
+    return 0;
   }
+  /* For simplicity, we use cmpri = cmpre */
+  cmpre = cmpri;
 
   /* Extension header length: fixed headers + (n-1) * (16-ComprI) + (16-ComprE)*/
   ext_len = RPL_RH_LEN + RPL_SRH_LEN
@@ -431,24 +512,37 @@ insert_srh_header(void)
   UIP_RPL_SRH_BUF->cmpr = (cmpri << 4) + cmpre;
   UIP_RPL_SRH_BUF->pad = padding << 4;
 
-  /* Initialize addresses field (the actual source route).
-   * From last to first. */
-  node = dest_node;
   hop_ptr = ((uint8_t *)UIP_RH_BUF) + ext_len - padding; /* Pointer where to write the next hop compressed address */
 
-  while(node != NULL && node->parent != root_node) {
-    rpl_ns_get_node_global_addr(&node_addr, node);
+#if RPL_NS_ROUTE_CACHE_SIZE
+  if(cached != NULL) {
+    hop_ptr -= path_len * (16 - cmpri);
+    memcpy(hop_ptr, cached->addresses, path_len * (16 - cmpri));
+    uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &cached->next_hop);
+  } else
+#endif /* RPL_NS_ROUTE_CACHE_SIZE */
+  {
+    /* Initialize addresses field (the actual source route).
+     * From last to first. */
+    node = dest_node;
+    while(node != NULL && node->parent != root_node) {
+      rpl_ns_get_node_global_addr(&node_addr, node);
+
+      hop_ptr -= (16 - cmpri);
+      memcpy(hop_ptr, ((uint8_t*)&node_addr) + cmpri, 16 - cmpri);
+
+      node = node->parent;
+    }
 
-    hop_ptr -= (16 - cmpri);
-    memcpy(hop_ptr, ((uint8_t*)&node_addr) + cmpri, 16 - cmpri);
+    /* The next hop (i.e. node whose parent is the root) is placed as the current IPv6 destination */
+    rpl_ns_get_node_global_addr(&node_addr, node);
+    uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &node_addr);
 
-    node = node->parent;
+#if RPL_NS_ROUTE_CACHE_SIZE
+    route_cache_add(dest_node, root_node, path_len, cmpri, hop_ptr, &node_addr);
+#endif /* RPL_NS_ROUTE_CACHE_SIZE */
   }
 
-  /* The next hop (i.e. node whose parent is the root) is placed as the current IPv6 destination */
-  rpl_ns_get_node_global_addr(&node_addr, node);
-  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &node_addr);
-
   /* In-place update of IPv6 length field */
   temp_len = UIP_IP_BUF->len[1];
   UIP_IP_BUF->len[1] += ext_len;
@@ -104,20 +104,14 @@ UIP_ICMP6_HANDLER(dao_ack_handler, ICMP6_RPL, RPL_CODE_DAO_ACK, dao_ack_input);
 /*---------------------------------------------------------------------------*/
 
 #if RPL_WITH_DAO_ACK
-static uip_ds6_route_t *
-find_route_entry_by_dao_ack(uint8_t seq)
-{
-  uip_ds6_route_t *re;
-  re = uip_ds6_route_head();
-  while(re != NULL) {
-    if(re->state.dao_seqno_out == seq && RPL_ROUTE_IS_DAO_PENDING(re)) {
-      /* found it! */
-      return re;
-    }
-    re = uip_ds6_route_next(re);
-  }
-  return NULL;
-}
+/* Children a DAO ACK is forwarded to: an aggregated DAO carries the
+   targets of several child DAOs, a forwarded one those of a single
+   child DAO */
+#if RPL_WITH_STORING && RPL_WITH_DAO_AGGREGATION
+#define DAO_ACK_MAX_FWD RPL_DAO_AGGREGATION_MAX_TARGETS
+#else /* RPL_WITH_STORING && RPL_WITH_DAO_AGGREGATION */
+#define DAO_ACK_MAX_FWD 1
+#endif /* RPL_WITH_STORING && RPL_WITH_DAO_AGGREGATION */
 #endif /* RPL_WITH_DAO_ACK */
 
 #if RPL_WITH_STORING
@@ -135,6 +129,157 @@ prepare_for_dao_fwd(uint8_t sequence, uip_ds6_route_t *rep)
   return dao_sequence;
 }
 #endif /* RPL_WITH_STORING */
+
+#if RPL_WITH_STORING && RPL_WITH_DAO_AGGREGATION
+/* Targets of received DAOs waiting to be forwarded in one DAO */
+struct dao_batch_target {
+  uip_ipaddr_t prefix;
+  uint8_t prefixlen;
+  uint8_t lifetime;
+};
+static struct dao_batch_target dao_batch[RPL_DAO_AGGREGATION_MAX_TARGETS];
+static uint8_t dao_batch_len;
+static uint8_t dao_batch_flags;
+static uint8_t dao_batch_seqno;
+static rpl_instance_t *dao_batch_instance;
+static struct ctimer dao_batch_timer;
+
+/* DAO header, and a target option with a full address followed by a
+   transit option of a storing mode DAO */
+#define DAO_BATCH_HDR_LEN     (4 + (RPL_DAO_SPECIFY_DAG ? 16 : 0))
+#define DAO_BATCH_TARGET_LEN  (4 + 16 + 6)
+#define DAO_BATCH_MAX_LEN     (UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPH_LEN - UIP_ICMPH_LEN)
+/*---------------------------------------------------------------------------*/
+static void
+dao_batch_flush(void *ptr)
+{
+  rpl_dag_t *dag;
+  uip_ds6_route_t *re;
+  uip_ipaddr_t *parent_ipaddr;
+  unsigned char *buffer;
+  uint8_t prefixlen;
+  int pos;
+  int i;
+
+  if(dao_batch_len == 0) {
+    return;
+  }
+
+  ctimer_stop(&dao_batch_timer);
+
+  dag = dao_batch_instance->current_dag;
+  if(dag == NULL || dag->preferred_parent == NULL ||
+     (parent_ipaddr = rpl_get_parent_ipaddr(dag->preferred_parent)) == NULL) {
+    PRINTF("RPL: No parent to forward %u DAO targets to\n", dao_batch_len);
+    /* No DAO ACK will come for these routes. The children retransmit
+       their DAOs, which are then forwarded to the next parent. */
+    for(re = uip_ds6_route_head(); re != NULL; re = uip_ds6_route_next(re)) {
+      if(RPL_ROUTE_IS_DAO_PENDING(re) &&
+         re->state.dao_seqno_out == dao_batch_seqno) {
+        RPL_ROUTE_CLEAR_DAO_PENDING(re);
+      }
+    }
+    dao_batch_len = 0;
+    return;
+  }
+
+  buffer = UIP_ICMP_PAYLOAD;
+  pos = 0;
+
+  buffer[pos++] = dao_batch_instance->instance_id;
+  buffer[pos] = dao_batch_flags;
+#if RPL_DAO_SPECIFY_DAG
+  buffer[pos] |= RPL_DAO_D_FLAG;
+#endif /* RPL_DAO_SPECIFY_DAG */
+  ++pos;
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = dao_batch_seqno;
+#if RPL_DAO_SPECIFY_DAG
+  memcpy(buffer + pos, &dag->dag_id, sizeof(dag->dag_id));
+  pos += sizeof(dag->dag_id);
+#endif /* RPL_DAO_SPECIFY_DAG */
+
+  for(i = 0; i < dao_batch_len; i++) {
+    /* create target subopt */
+    prefixlen = dao_batch[i].prefixlen;
+    buffer[pos++] = RPL_OPTION_TARGET;
+    buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
+    buffer[pos++] = 0; /* reserved */
+    buffer[pos++] = prefixlen;
+    memcpy(buffer + pos, &dao_batch[i].prefix, (prefixlen + 7) / CHAR_BIT);
+    pos += ((prefixlen + 7) / CHAR_BIT);
+
+    /* Targets with the same lifetime share a transit information
+       sub-option */
+    if(i + 1 == dao_batch_len ||
+       dao_batch[i + 1].lifetime != dao_batch[i].lifetime) {
+      buffer[pos++] = RPL_OPTION_TRANSIT;
+      buffer[pos++] = 4;
+      buffer[pos++] = 0; /* flags - ignored */
+      buffer[pos++] = 0; /* path control - ignored */
+      buffer[pos++] = 0; /* path seq - ignored */
+      buffer[pos++] = dao_batch[i].lifetime;
+    }
+  }
+
+  PRINTF("RPL: Forwarding %u DAO targets with sequence number %u to ",
+         dao_batch_len, dao_batch_seqno);
+  PRINT6ADDR(parent_ipaddr);
+  PRINTF("\n");
+
+  dao_batch_len = 0;
+  uip_icmp6_send(parent_ipaddr, ICMP6_RPL, RPL_CODE_DAO, pos);
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_batch_has_room(rpl_instance_t *instance, int targets)
+{
+  if(dao_batch_len > 0 && dao_batch_instance != instance) {
+    return 0;
+  }
+  return dao_batch_len + targets <= RPL_DAO_AGGREGATION_MAX_TARGETS &&
+    DAO_BATCH_HDR_LEN + (dao_batch_len + targets) * DAO_BATCH_TARGET_LEN <=
+    DAO_BATCH_MAX_LEN;
+}
+/*---------------------------------------------------------------------------*/
+static void
+dao_batch_add(rpl_instance_t *instance, uint8_t flags,
+              const uip_ipaddr_t *prefix, uint8_t prefixlen, uint8_t lifetime)
+{
+  int i;
+
+  if(dao_batch_len == 0) {
+    /* The sequence number is chosen now, so that the routes of the
+       targets can be marked as pending right away */
+    RPL_LOLLIPOP_INCREMENT(dao_sequence);
+    dao_batch_seqno = dao_sequence;
+    dao_batch_instance = instance;
+    dao_batch_flags = 0;
+    ctimer_set(&dao_batch_timer, RPL_DAO_AGGREGATION_DELAY,
+               dao_batch_flush, NULL);
+  }
+  dao_batch_flags |= flags & RPL_DAO_K_FLAG;
+
+  /* A newer DAO for the same target replaces the previous one */
+  for(i = 0; i < dao_batch_len; i++) {
+    if(dao_batch[i].prefixlen == prefixlen &&
+       uip_ipaddr_cmp(&dao_batch[i].prefix, prefix)) {
+      dao_batch[i].lifetime = lifetime;
+      return;
+    }
+  }
+
+  uip_ipaddr_copy(&dao_batch[dao_batch_len].prefix, prefix);
+  dao_batch[dao_batch_len].prefixlen = prefixlen;
+  dao_batch[dao_batch_len].lifetime = lifetime;
+  dao_batch_len++;
+
+  if(!dao_batch_has_room(instance, 1)) {
+    /* Send as soon as the current DAO has been processed */
+    ctimer_set(&dao_batch_timer, 0, dao_batch_flush, NULL);
+  }
+}
+#endif /* RPL_WITH_STORING && RPL_WITH_DAO_AGGREGATION */
 /*---------------------------------------------------------------------------*/
 static int
 get_global_addr(uip_ipaddr_t *addr)
@@ -279,7 +424,7 @@ static void
 dio_input(void)
 {
   unsigned char *buffer;
-  uint8_t buffer_length;
+  uint16_t buffer_length;
   rpl_dio_t dio;
   uint8_t subopt_type;
   int i;
@@ -621,140 +766,104 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
 #endif /* RPL_LEAF_ONLY */
 }
 /*---------------------------------------------------------------------------*/
-static void
-dao_input_storing(void)
-{
 #if RPL_WITH_STORING
-  uip_ipaddr_t dao_sender_addr;
-  rpl_dag_t *dag;
+/* A DAO being processed by a storing mode router */
+struct dao_input {
   rpl_instance_t *instance;
-  unsigned char *buffer;
-  uint16_t sequence;
-  uint8_t instance_id;
-  uint8_t lifetime;
-  uint8_t prefixlen;
+  rpl_dag_t *dag;
+  uip_ipaddr_t sender;
+  uint8_t sequence;
   uint8_t flags;
-  uint8_t subopt_type;
-  /*
-    uint8_t pathcontrol;
-    uint8_t pathsequence;
-  */
-  uip_ipaddr_t prefix;
-  uip_ds6_route_t *rep;
-  uint8_t buffer_length;
-  int pos;
+  uint8_t learned_from;
+  uint8_t is_root;
+  /* The targets are forwarded in an aggregated DAO */
+  uint8_t aggregate;
+  /* The DAO is forwarded as received, with out_seq as sequence number */
+  uint8_t forward;
+  uint8_t out_seq;
+  uint8_t out_seq_set;
+  /* All targets are known to be registered, the DAO can be acked now */
+  uint8_t ack_now;
+  uint8_t ack_status;
+};
+/*---------------------------------------------------------------------------*/
+#if RPL_WITH_DAO_AGGREGATION
+static int
+dao_count_targets(const unsigned char *buffer, int pos, int buffer_length)
+{
+  int count;
   int len;
-  int i;
-  int learned_from;
-  rpl_parent_t *parent;
-  uip_ds6_nbr_t *nbr;
-  int is_root;
-
-  prefixlen = 0;
-  parent = NULL;
-  memset(&prefix, 0, sizeof(prefix));
-
-  uip_ipaddr_copy(&dao_sender_addr, &UIP_IP_BUF->srcipaddr);
-
-  buffer = UIP_ICMP_PAYLOAD;
-  buffer_length = uip_len - uip_l3_icmp_hdr_len;
-
-  pos = 0;
-  instance_id = buffer[pos++];
-
-  instance = rpl_get_instance(instance_id);
-
-  lifetime = instance->default_lifetime;
-
-  flags = buffer[pos++];
-  /* reserved */
-  pos++;
-  sequence = buffer[pos++];
-
-  dag = instance->current_dag;
-  is_root = (dag->rank == ROOT_RANK(instance));
 
-  /* Is the DAG ID present? */
-  if(flags & RPL_DAO_D_FLAG) {
-    if(memcmp(&dag->dag_id, &buffer[pos], sizeof(dag->dag_id))) {
-      PRINTF("RPL: Ignoring a DAO for a DAG different from ours\n");
-      return;
+  count = 0;
+  for(; pos < buffer_length; pos += len) {
+    if(buffer[pos] == RPL_OPTION_PAD1) {
+      len = 1;
+    } else {
+      len = 2 + buffer[pos + 1];
+      if(buffer[pos] == RPL_OPTION_TARGET) {
+        count++;
+      }
     }
-    pos += 16;
   }
-
-  learned_from = uip_is_addr_mcast(&dao_sender_addr) ?
-    RPL_ROUTE_FROM_MULTICAST_DAO : RPL_ROUTE_FROM_UNICAST_DAO;
-
-  /* Destination Advertisement Object */
-  PRINTF("RPL: Received a (%s) DAO with sequence number %u from ",
-         learned_from == RPL_ROUTE_FROM_UNICAST_DAO? "unicast": "multicast", sequence);
-  PRINT6ADDR(&dao_sender_addr);
-  PRINTF("\n");
-
-  if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
-    /* Check whether this is a DAO forwarding loop. */
-    parent = rpl_find_parent(dag, &dao_sender_addr);
-    /* check if this is a new DAO registration with an "illegal" rank */
-    /* if we already route to this node it is likely */
-    if(parent != NULL &&
-       DAG_RANK(parent->rank, instance) < DAG_RANK(dag->rank, instance)) {
-      PRINTF("RPL: Loop detected when receiving a unicast DAO from a node with a lower rank! (%u < %u)\n",
-             DAG_RANK(parent->rank, instance), DAG_RANK(dag->rank, instance));
-      parent->rank = INFINITE_RANK;
-      parent->flags |= RPL_PARENT_FLAG_UPDATED;
-      return;
-    }
-
-    /* If we get the DAO from our parent, we also have a loop. */
-    if(parent != NULL && parent == dag->preferred_parent) {
-      PRINTF("RPL: Loop detected when receiving a unicast DAO from our parent\n");
-      parent->rank = INFINITE_RANK;
-      parent->flags |= RPL_PARENT_FLAG_UPDATED;
-      return;
+  return count;
+}
+#endif /* RPL_WITH_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
+static void
+dao_fwd_target(struct dao_input *d, uip_ds6_route_t *rep,
+               const uip_ipaddr_t *prefix, uint8_t prefixlen, uint8_t lifetime)
+{
+#if RPL_WITH_DAO_AGGREGATION
+  if(d->aggregate) {
+    dao_batch_add(d->instance, d->flags, prefix, prefixlen, lifetime);
+    if(rep != NULL) {
+      rep->state.dao_seqno_in = d->sequence;
+      rep->state.dao_seqno_out = dao_batch_seqno;
+      RPL_ROUTE_SET_DAO_PENDING(rep);
     }
+    return;
   }
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
-  /* Check if there are any RPL options present. */
-  for(i = pos; i < buffer_length; i += len) {
-    subopt_type = buffer[i];
-    if(subopt_type == RPL_OPTION_PAD1) {
-      len = 1;
+  d->forward = 1;
+  if(rep != NULL) {
+    if(!d->out_seq_set) {
+      d->out_seq = prepare_for_dao_fwd(d->sequence, rep);
+      d->out_seq_set = 1;
     } else {
-      /* The option consists of a two-byte header and a payload. */
-      len = 2 + buffer[i + 1];
-    }
-
-    switch(subopt_type) {
-      case RPL_OPTION_TARGET:
-        /* Handle the target option. */
-        prefixlen = buffer[i + 3];
-        memset(&prefix, 0, sizeof(prefix));
-        memcpy(&prefix, buffer + i + 4, (prefixlen + 7) / CHAR_BIT);
-        break;
-      case RPL_OPTION_TRANSIT:
-        /* The path sequence and control are ignored. */
-        /*      pathcontrol = buffer[i + 3];
-                pathsequence = buffer[i + 4];*/
-        lifetime = buffer[i + 5];
-        /* The parent address is also ignored. */
-        break;
+      /* All targets of a forwarded DAO share its sequence number */
+      rep->state.dao_seqno_in = d->sequence;
+      rep->state.dao_seqno_out = d->out_seq;
+      RPL_ROUTE_SET_DAO_PENDING(rep);
     }
   }
+}
+/*---------------------------------------------------------------------------*/
+static void
+dao_target_input(struct dao_input *d, uip_ipaddr_t *prefix,
+                 uint8_t prefixlen, uint8_t lifetime)
+{
+  rpl_instance_t *instance;
+  rpl_dag_t *dag;
+  uip_ds6_route_t *rep;
+  uip_ds6_nbr_t *nbr;
+
+  instance = d->instance;
+  dag = d->dag;
 
   PRINTF("RPL: DAO lifetime: %u, prefix length: %u prefix: ",
          (unsigned)lifetime, (unsigned)prefixlen);
-  PRINT6ADDR(&prefix);
+  PRINT6ADDR(prefix);
   PRINTF("\n");
 
 #if RPL_WITH_MULTICAST
-  if(uip_is_addr_mcast_global(&prefix)) {
+  if(uip_is_addr_mcast_global(prefix)) {
     /*
      * "rep" is used for a unicast route which we don't need now; so set NULL so
      * that operations on "rep" will be skipped.
      */
     rep = NULL;
-    mcast_group = uip_mcast6_route_add(&prefix);
+    mcast_group = uip_mcast6_route_add(prefix);
     if(mcast_group) {
       mcast_group->dag = dag;
       mcast_group->lifetime = RPL_LIFETIME(instance, lifetime);
@@ -763,7 +872,7 @@ dao_input_storing(void)
   }
 #endif
 
-  rep = uip_ds6_route_lookup(&prefix);
+  rep = uip_ds6_route_lookup(prefix);
 
   if(lifetime == RPL_ZERO_LIFETIME) {
     PRINTF("RPL: No-Path DAO received\n");
@@ -772,9 +881,9 @@ dao_input_storing(void)
        !RPL_ROUTE_IS_NOPATH_RECEIVED(rep) &&
        rep->length == prefixlen &&
        uip_ds6_route_nexthop(rep) != NULL &&
-       uip_ipaddr_cmp(uip_ds6_route_nexthop(rep), &dao_sender_addr)) {
+       uip_ipaddr_cmp(uip_ds6_route_nexthop(rep), &d->sender)) {
       PRINTF("RPL: Setting expiration timer for prefix ");
-      PRINT6ADDR(&prefix);
+      PRINT6ADDR(prefix);
       PRINTF("\n");
       RPL_ROUTE_SET_NOPATH_RECEIVED(rep);
       rep->state.lifetime = RPL_NOPATH_REMOVAL_DELAY;
@@ -783,58 +892,35 @@ dao_input_storing(void)
          one. */
       if(dag->preferred_parent != NULL &&
          rpl_get_parent_ipaddr(dag->preferred_parent) != NULL) {
-        uint8_t out_seq;
-        out_seq = prepare_for_dao_fwd(sequence, rep);
-
-        PRINTF("RPL: Forwarding No-path DAO to parent - out_seq:%d",
-               out_seq);
-        PRINT6ADDR(rpl_get_parent_ipaddr(dag->preferred_parent));
-        PRINTF("\n");
-
-        buffer = UIP_ICMP_PAYLOAD;
-        buffer[3] = out_seq; /* add an outgoing seq no before fwd */
-        uip_icmp6_send(rpl_get_parent_ipaddr(dag->preferred_parent),
-                       ICMP6_RPL, RPL_CODE_DAO, buffer_length);
+        dao_fwd_target(d, rep, prefix, prefixlen, lifetime);
       }
     }
     /* independent if we remove or not - ACK the request */
-    if(flags & RPL_DAO_K_FLAG) {
-      /* indicate that we accepted the no-path DAO */
-      uip_clear_buf();
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-                     RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
-    }
     return;
   }
 
   PRINTF("RPL: Adding DAO route\n");
 
   /* Update and add neighbor - if no room - fail. */
-  if((nbr = rpl_icmp6_update_nbr_table(&dao_sender_addr, NBR_TABLE_REASON_RPL_DAO, instance)) == NULL) {
+  if((nbr = rpl_icmp6_update_nbr_table(&d->sender, NBR_TABLE_REASON_RPL_DAO, instance)) == NULL) {
     PRINTF("RPL: Out of Memory, dropping DAO from ");
-    PRINT6ADDR(&dao_sender_addr);
+    PRINT6ADDR(&d->sender);
     PRINTF(", ");
     PRINTLLADDR((uip_lladdr_t *)packetbuf_addr(PACKETBUF_ADDR_SENDER));
     PRINTF("\n");
-    if(flags & RPL_DAO_K_FLAG) {
-      /* signal the failure to add the node */
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-                     is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
-                     RPL_DAO_ACK_UNABLE_TO_ACCEPT);
-    }
+    /* signal the failure to add the node */
+    d->ack_status = d->is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
+      RPL_DAO_ACK_UNABLE_TO_ACCEPT;
     return;
   }
 
-  rep = rpl_add_route(dag, &prefix, prefixlen, &dao_sender_addr);
+  rep = rpl_add_route(dag, prefix, prefixlen, &d->sender);
   if(rep == NULL) {
     RPL_STAT(rpl_stats.mem_overflows++);
     PRINTF("RPL: Could not add a route after receiving a DAO\n");
-    if(flags & RPL_DAO_K_FLAG) {
-      /* signal the failure to add the node */
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-                     is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
-                     RPL_DAO_ACK_UNABLE_TO_ACCEPT);
-    }
+    /* signal the failure to add the node */
+    d->ack_status = d->is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
+      RPL_DAO_ACK_UNABLE_TO_ACCEPT;
     return;
   }
 
@@ -846,53 +932,199 @@ dao_input_storing(void)
 fwd_dao:
 #endif
 
-  if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
-    int should_ack = 0;
-
-    if(flags & RPL_DAO_K_FLAG) {
-      if(rep != NULL) {
-        /*
-         * check if this route is already installed and we can ack now!
-         * not pending - and same seq-no means that we can ack.
-         * (e.g. the route is installed already so it will not take any
-         * more room that it already takes - so should be ok!)
-         */
-        if((!RPL_ROUTE_IS_DAO_PENDING(rep) &&
-            rep->state.dao_seqno_in == sequence) ||
-           dag->rank == ROOT_RANK(instance)) {
-          should_ack = 1;
-        }
-      }
+  if(d->learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
+    /*
+     * check if this route is already installed and we can ack now!
+     * not pending - and same seq-no means that we can ack.
+     * (e.g. the route is installed already so it will not take any
+     * more room that it already takes - so should be ok!)
+     */
+    if(rep == NULL ||
+       !((!RPL_ROUTE_IS_DAO_PENDING(rep) &&
+          rep->state.dao_seqno_in == d->sequence) || d->is_root)) {
+      d->ack_now = 0;
     }
 
     if(dag->preferred_parent != NULL &&
        rpl_get_parent_ipaddr(dag->preferred_parent) != NULL) {
-      uint8_t out_seq = 0;
-      if(rep != NULL) {
-        /* if this is pending and we get the same seq no it is a retrans */
-        if(RPL_ROUTE_IS_DAO_PENDING(rep) &&
-           rep->state.dao_seqno_in == sequence) {
-          /* keep the same seq-no as before for parent also */
-          out_seq = rep->state.dao_seqno_out;
-        } else {
-          out_seq = prepare_for_dao_fwd(sequence, rep);
+      /* if this is pending and we get the same seq no it is a retrans */
+      if(!d->aggregate && rep != NULL &&
+         RPL_ROUTE_IS_DAO_PENDING(rep) &&
+         rep->state.dao_seqno_in == d->sequence) {
+        /* keep the same seq-no as before for parent also */
+        if(!d->out_seq_set) {
+          d->out_seq = rep->state.dao_seqno_out;
+          d->out_seq_set = 1;
         }
+        d->forward = 1;
+      } else {
+        dao_fwd_target(d, rep, prefix, prefixlen, lifetime);
       }
+    }
+  } else {
+    d->ack_now = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+dao_targets_input(struct dao_input *d, const unsigned char *buffer,
+                  int pos, int end, uint8_t lifetime)
+{
+  uip_ipaddr_t prefix;
+  uint8_t prefixlen;
+  int len;
+
+  for(; pos < end; pos += len) {
+    if(buffer[pos] == RPL_OPTION_PAD1) {
+      len = 1;
+      continue;
+    }
+    /* The option consists of a two-byte header and a payload. */
+    len = 2 + buffer[pos + 1];
+    if(buffer[pos] == RPL_OPTION_TARGET) {
+      /* Handle the target option. */
+      prefixlen = buffer[pos + 3];
+      if(prefixlen > sizeof(prefix) * CHAR_BIT) {
+        continue;
+      }
+      memset(&prefix, 0, sizeof(prefix));
+      memcpy(&prefix, buffer + pos + 4, (prefixlen + 7) / CHAR_BIT);
+      dao_target_input(d, &prefix, prefixlen, lifetime);
+    }
+  }
+}
+#endif /* RPL_WITH_STORING */
+/*---------------------------------------------------------------------------*/
+static void
+dao_input_storing(void)
+{
+#if RPL_WITH_STORING
+  struct dao_input d;
+  unsigned char *buffer;
+  uint8_t instance_id;
+  uint8_t lifetime;
+  uint16_t buffer_length;
+  int pos;
+  int len;
+  int i;
+  int group;
+  rpl_parent_t *parent;
+
+  memset(&d, 0, sizeof(d));
+  uip_ipaddr_copy(&d.sender, &UIP_IP_BUF->srcipaddr);
+
+  buffer = UIP_ICMP_PAYLOAD;
+  buffer_length = uip_len - uip_l3_icmp_hdr_len;
+
+  pos = 0;
+  instance_id = buffer[pos++];
+
+  d.instance = rpl_get_instance(instance_id);
+
+  d.flags = buffer[pos++];
+  /* reserved */
+  pos++;
+  d.sequence = buffer[pos++];
+
+  d.dag = d.instance->current_dag;
+  d.is_root = (d.dag->rank == ROOT_RANK(d.instance));
+
+  /* Is the DAG ID present? */
+  if(d.flags & RPL_DAO_D_FLAG) {
+    if(memcmp(&d.dag->dag_id, &buffer[pos], sizeof(d.dag->dag_id))) {
+      PRINTF("RPL: Ignoring a DAO for a DAG different from ours\n");
+      return;
+    }
+    pos += 16;
+  }
+
+  d.learned_from = uip_is_addr_mcast(&d.sender) ?
+    RPL_ROUTE_FROM_MULTICAST_DAO : RPL_ROUTE_FROM_UNICAST_DAO;
+
+  /* Destination Advertisement Object */
+  PRINTF("RPL: Received a (%s) DAO with sequence number %u from ",
+         d.learned_from == RPL_ROUTE_FROM_UNICAST_DAO? "unicast": "multicast", d.sequence);
+  PRINT6ADDR(&d.sender);
+  PRINTF("\n");
+
+  if(d.learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
+    /* Check whether this is a DAO forwarding loop. */
+    parent = rpl_find_parent(d.dag, &d.sender);
+    /* check if this is a new DAO registration with an "illegal" rank */
+    /* if we already route to this node it is likely */
+    if(parent != NULL &&
+       DAG_RANK(parent->rank, d.instance) < DAG_RANK(d.dag->rank, d.instance)) {
+      PRINTF("RPL: Loop detected when receiving a unicast DAO from a node with a lower rank! (%u < %u)\n",
+             DAG_RANK(parent->rank, d.instance), DAG_RANK(d.dag->rank, d.instance));
+      parent->rank = INFINITE_RANK;
+      parent->flags |= RPL_PARENT_FLAG_UPDATED;
+      return;
+    }
 
-      PRINTF("RPL: Forwarding DAO to parent ");
-      PRINT6ADDR(rpl_get_parent_ipaddr(dag->preferred_parent));
-      PRINTF(" in seq: %d out seq: %d\n", sequence, out_seq);
+    /* If we get the DAO from our parent, we also have a loop. */
+    if(parent != NULL && parent == d.dag->preferred_parent) {
+      PRINTF("RPL: Loop detected when receiving a unicast DAO from our parent\n");
+      parent->rank = INFINITE_RANK;
+      parent->flags |= RPL_PARENT_FLAG_UPDATED;
+      return;
+    }
+  }
 
-      buffer = UIP_ICMP_PAYLOAD;
-      buffer[3] = out_seq; /* add an outgoing seq no before fwd */
-      uip_icmp6_send(rpl_get_parent_ipaddr(dag->preferred_parent),
-                     ICMP6_RPL, RPL_CODE_DAO, buffer_length);
+#if RPL_WITH_DAO_AGGREGATION
+  /* DAOs that do not fit in the pending aggregated DAO are forwarded
+     as received. The pending one cannot grow any further then, so it
+     is sent right after this DAO instead of at the end of the delay. */
+  if(!d.is_root) {
+    d.aggregate = dao_batch_has_room(d.instance,
+                                     dao_count_targets(buffer, pos, buffer_length));
+    if(!d.aggregate && dao_batch_len > 0) {
+      ctimer_set(&dao_batch_timer, 0, dao_batch_flush, NULL);
     }
-    if(should_ack) {
+  }
+#endif /* RPL_WITH_DAO_AGGREGATION */
+  d.ack_now = 1;
+  d.ack_status = RPL_DAO_ACK_UNCONDITIONAL_ACCEPT;
+
+  /* Check if there are any RPL options present. Each set of target
+     options is followed by the transit option that applies to it. */
+  lifetime = d.instance->default_lifetime;
+  group = pos;
+  for(i = pos; i < buffer_length; i += len) {
+    if(buffer[i] == RPL_OPTION_PAD1) {
+      len = 1;
+    } else {
+      /* The option consists of a two-byte header and a payload. */
+      len = 2 + buffer[i + 1];
+    }
+
+    if(buffer[i] == RPL_OPTION_TRANSIT) {
+      /* The path sequence and control are ignored. */
+      /*      pathcontrol = buffer[i + 3];
+              pathsequence = buffer[i + 4];*/
+      /* The parent address is also ignored. */
+      dao_targets_input(&d, buffer, group, i, buffer[i + 5]);
+      group = i + len;
+    }
+  }
+  /* Targets without transit option */
+  dao_targets_input(&d, buffer, group, buffer_length, lifetime);
+
+  if(d.forward) {
+    PRINTF("RPL: Forwarding DAO to parent ");
+    PRINT6ADDR(rpl_get_parent_ipaddr(d.dag->preferred_parent));
+    PRINTF(" in seq: %d out seq: %d\n", d.sequence, d.out_seq);
+
+    buffer = UIP_ICMP_PAYLOAD;
+    buffer[3] = d.out_seq; /* add an outgoing seq no before fwd */
+    uip_icmp6_send(rpl_get_parent_ipaddr(d.dag->preferred_parent),
+                   ICMP6_RPL, RPL_CODE_DAO, buffer_length);
+  }
+
+  if(d.flags & RPL_DAO_K_FLAG) {
+    if(d.ack_status != RPL_DAO_ACK_UNCONDITIONAL_ACCEPT || d.ack_now) {
       PRINTF("RPL: Sending DAO ACK\n");
       uip_clear_buf();
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-                     RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
+      dao_ack_output(d.instance, &d.sender, d.sequence, d.ack_status);
     }
   }
 #endif /* RPL_WITH_STORING */
@@ -914,7 +1146,7 @@ dao_input_nonstoring(void)
   uint8_t flags;
   uint8_t subopt_type;
   uip_ipaddr_t prefix;
-  uint8_t buffer_length;
+  uint16_t buffer_length;
   int pos;
   int len;
   int i;
@@ -1310,10 +1542,27 @@ dao_ack_input(void)
 #endif
 
   } else if(RPL_IS_STORING(instance)) {
-    /* this DAO ACK should be forwarded to another recently registered route */
+    /* this DAO ACK should be forwarded to the recently registered routes
+       of that DAO - several of them if the DAO had multiple targets, from
+       several children if it was aggregated. The routes are visited
+       once, and each child gets one DAO ACK per DAO it sent. */
     uip_ds6_route_t *re;
+    uip_ds6_route_t *next;
     uip_ipaddr_t *nexthop;
-    if((re = find_route_entry_by_dao_ack(sequence)) != NULL) {
+    struct {
+      uip_ipaddr_t nexthop;
+      uint8_t seqno;
+    } acked[DAO_ACK_MAX_FWD];
+    uint8_t num_acked;
+    uint8_t i;
+
+    num_acked = 0;
+    for(re = uip_ds6_route_head(); re != NULL; re = next) {
+      next = uip_ds6_route_next(re);
+      if(re->state.dao_seqno_out != sequence || !RPL_ROUTE_IS_DAO_PENDING(re)) {
+        continue;
+      }
+
       /* pick the recorded seq no from that node and forward DAO ACK - and
          clear the pending flag*/
       RPL_ROUTE_CLEAR_DAO_PENDING(re);
@@ -1322,18 +1571,33 @@ dao_ack_input(void)
       if(nexthop == NULL) {
         PRINTF("RPL: No next hop to fwd DAO ACK to\n");
       } else {
-        PRINTF("RPL: Fwd DAO ACK to:");
-        PRINT6ADDR(nexthop);
-        PRINTF("\n");
-        buffer[2] = re->state.dao_seqno_in;
-        uip_icmp6_send(nexthop, ICMP6_RPL, RPL_CODE_DAO_ACK, 4);
+        for(i = 0; i < num_acked; i++) {
+          if(acked[i].seqno == re->state.dao_seqno_in &&
+             uip_ipaddr_cmp(&acked[i].nexthop, nexthop)) {
+            break;
+          }
+        }
+        if(i == num_acked) {
+          PRINTF("RPL: Fwd DAO ACK to:");
+          PRINT6ADDR(nexthop);
+          PRINTF("\n");
+          dao_ack_output(instance, nexthop, re->state.dao_seqno_in, status);
+          /* If the list is full, a child may get a second DAO ACK,
+             which it ignores */
+          if(num_acked < DAO_ACK_MAX_FWD) {
+            uip_ipaddr_copy(&acked[num_acked].nexthop, nexthop);
+            acked[num_acked].seqno = re->state.dao_seqno_in;
+            num_acked++;
+          }
+        }
       }
 
       if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
         /* this node did not get in to the routing tables above... - remove */
         uip_ds6_route_rm(re);
       }
-    } else {
+    }
+    if(num_acked == 0) {
       PRINTF("RPL: No route entry found to forward DAO ACK (seqno %u)\n", sequence);
     }
   }
@@ -107,9 +107,11 @@ dao_ack_callback(rpl_parent_t *p, int status)
   if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
     /* punish the ETX as if this was 10 packets lost */
     link_stats_packet_sent(rpl_get_parent_lladdr(p), MAC_TX_OK, 10);
+    p->flags &= ~RPL_PARENT_FLAG_LINK_METRIC_VALID;
   } else if(status == RPL_DAO_ACK_TIMEOUT) { /* timeout = no ack */
     /* punish the total lack of ACK with a similar punishment */
     link_stats_packet_sent(rpl_get_parent_lladdr(p), MAC_TX_OK, 10);
+    p->flags &= ~RPL_PARENT_FLAG_LINK_METRIC_VALID;
   }
 }
 #endif /* RPL_WITH_DAO_ACK */
@@ -156,7 +158,7 @@ parent_path_cost(rpl_parent_t *p)
 #endif /* RPL_WITH_MC */
 
   /* path cost upper bound: 0xffff */
-  return MIN((uint32_t)base + parent_link_metric(p), 0xffff);
+  return MIN((uint32_t)base + rpl_get_parent_link_metric(p), 0xffff);
 }
 /*---------------------------------------------------------------------------*/
 static rpl_rank_t
@@ -179,7 +181,7 @@ rank_via_parent(rpl_parent_t *p)
 static int
 parent_is_acceptable(rpl_parent_t *p)
 {
-  uint16_t link_metric = parent_link_metric(p);
+  uint16_t link_metric = rpl_get_parent_link_metric(p);
   uint16_t path_cost = parent_path_cost(p);
   /* Exclude links with too high link metrics or path cost (RFC6719, 3.2.2) */
   return link_metric <= MAX_LINK_METRIC && path_cost <= MAX_PATH_COST;
@@ -188,7 +190,7 @@ parent_is_acceptable(rpl_parent_t *p)
 static int
 parent_has_usable_link(rpl_parent_t *p)
 {
-  uint16_t link_metric = parent_link_metric(p);
+  uint16_t link_metric = rpl_get_parent_link_metric(p);
   /* Exclude links with too high link metrics  */
   return link_metric <= MAX_LINK_METRIC;
 }
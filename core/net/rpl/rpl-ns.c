@@ -59,10 +59,17 @@
 /* Total number of nodes */
 static int num_nodes;
 
+/* Incremented whenever a parent link changes or a node is removed, so
+   that users caching source routes can tell when to recompute them */
+static uint32_t topology_version;
+
 /* Every known node in the network */
 LIST(nodelist);
 MEMB(nodememb, rpl_ns_node_t, RPL_NS_LINK_NUM);
 
+/* Every known node, indexed by link identifier */
+static rpl_ns_node_t *node_table[RPL_NS_HASH_SIZE];
+
 /*---------------------------------------------------------------------------*/
 int
 rpl_ns_num_nodes(void)
@@ -70,6 +77,43 @@ rpl_ns_num_nodes(void)
   return num_nodes;
 }
 /*---------------------------------------------------------------------------*/
+uint32_t
+rpl_ns_topology_version(void)
+{
+  return topology_version;
+}
+/*---------------------------------------------------------------------------*/
+/* Multiplicative hash over the four 16-bit words of the link
+   identifier. Folding the bytes with XOR maps identifiers that repeat
+   a byte, as Cooja's 02:n:00:n:00:n:00:n do, to the same bucket. */
+static unsigned
+link_identifier_hash(const unsigned char *link_identifier)
+{
+  uint16_t h;
+  int i;
+
+  h = 0;
+  for(i = 0; i < 8; i += 2) {
+    h = (h + ((uint16_t)link_identifier[i] << 8) + link_identifier[i + 1])
+        * 0x9e37;
+  }
+  return (h ^ (h >> 8)) % RPL_NS_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_remove(rpl_ns_node_t *node)
+{
+  rpl_ns_node_t **p;
+
+  for(p = &node_table[link_identifier_hash(node->link_identifier)];
+      *p != NULL; p = &(*p)->hash_next) {
+    if(*p == node) {
+      *p = node->hash_next;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 static int
 node_matches_address(const rpl_dag_t *dag, const rpl_ns_node_t *node, const uip_ipaddr_t *addr)
 {
@@ -85,9 +129,17 @@ rpl_ns_node_t *
 rpl_ns_get_node(const rpl_dag_t *dag, const uip_ipaddr_t *addr)
 {
   rpl_ns_node_t *l;
-  for(l = list_head(nodelist); l != NULL; l = list_item_next(l)) {
-    /* Compare prefix and node identifier */
-    if(node_matches_address(dag, l, addr)) {
+  const unsigned char *link_identifier;
+
+  /* All nodes of a DAG share the prefix of its DAG ID */
+  if(addr == NULL || dag == NULL || memcmp(addr, &dag->dag_id, 8)) {
+    return NULL;
+  }
+
+  link_identifier = ((const unsigned char *)addr) + 8;
+  for(l = node_table[link_identifier_hash(link_identifier)];
+      l != NULL; l = l->hash_next) {
+    if(l->dag == dag && !memcmp(link_identifier, l->link_identifier, 8)) {
       return l;
     }
   }
@@ -123,6 +175,7 @@ rpl_ns_update_node(rpl_dag_t *dag, const uip_ipaddr_t *child, const uip_ipaddr_t
   rpl_ns_node_t *child_node = rpl_ns_get_node(dag, child);
   rpl_ns_node_t *parent_node = rpl_ns_get_node(dag, parent);
   rpl_ns_node_t *old_parent_node;
+  unsigned h;
 
   if(parent != NULL) {
     /* No node for the parent, add one with infinite lifetime */
@@ -142,18 +195,21 @@ rpl_ns_update_node(rpl_dag_t *dag, const uip_ipaddr_t *child, const uip_ipaddr_t
       return NULL;
     }
     child_node->parent = NULL;
+    child_node->dag = dag;
+    memcpy(child_node->link_identifier, ((const unsigned char *)child) + 8, 8);
     list_add(nodelist, child_node);
+    h = link_identifier_hash(child_node->link_identifier);
+    child_node->hash_next = node_table[h];
+    node_table[h] = child_node;
     num_nodes++;
   }
 
   /* Initialize node */
-  child_node->dag = dag;
   child_node->lifetime = lifetime;
-  memcpy(child_node->link_identifier, ((const unsigned char *)child) + 8, 8);
+  old_parent_node = child_node->parent;
 
   /* Is the node reachable before the update? */
   if(rpl_ns_is_node_reachable(dag, child)) {
-    old_parent_node = child_node->parent;
     /* Update node */
     child_node->parent = parent_node;
     /* Has the node become unreachable? May happen if we create a loop. */
@@ -167,6 +223,10 @@ rpl_ns_update_node(rpl_dag_t *dag, const uip_ipaddr_t *child, const uip_ipaddr_t
     child_node->parent = parent_node;
   }
 
+  if(child_node->parent != old_parent_node) {
+    topology_version++;
+  }
+
   return child_node;
 }
 /*---------------------------------------------------------------------------*/
@@ -176,6 +236,8 @@ rpl_ns_init(void)
   num_nodes = 0;
   memb_init(&nodememb);
   list_init(nodelist);
+  memset(node_table, 0, sizeof(node_table));
+  topology_version++;
 }
 /*---------------------------------------------------------------------------*/
 rpl_ns_node_t *
@@ -203,6 +265,7 @@ void
 rpl_ns_periodic(void)
 {
   rpl_ns_node_t *l;
+  rpl_ns_node_t *next;
   /* First pass, decrement lifetime for all nodes with non-infinite lifetime */
   for(l = list_head(nodelist); l != NULL; l = list_item_next(l)) {
     /* Don't touch infinite lifetime nodes */
@@ -211,7 +274,8 @@ rpl_ns_periodic(void)
     }
   }
   /* Second pass, for all expire nodes, deallocate them iff no child points to them */
-  for(l = list_head(nodelist); l != NULL; l = list_item_next(l)) {
+  for(l = list_head(nodelist); l != NULL; l = next) {
+    next = list_item_next(l);
     if(l->lifetime == 0) {
       rpl_ns_node_t *l2;
       for(l2 = list_head(nodelist); l2 != NULL; l2 = list_item_next(l2)) {
@@ -219,10 +283,14 @@ rpl_ns_periodic(void)
           break;
         }
       }
-      /* No child found, deallocate node */
-      list_remove(nodelist, l);
-      memb_free(&nodememb, l);
-      num_nodes--;
+      if(l2 == NULL) {
+        /* No child found, deallocate node */
+        list_remove(nodelist, l);
+        hash_remove(l);
+        memb_free(&nodememb, l);
+        num_nodes--;
+        topology_version++;
+      }
     }
   }
 }
@@ -49,8 +49,32 @@
 #define RPL_NS_LINK_NUM 32
 #endif /* RPL_NS_CONF_LINK_NUM */
 
+/* Number of buckets of the hash table indexing nodes by link identifier */
+#ifdef RPL_NS_CONF_HASH_SIZE
+#define RPL_NS_HASH_SIZE RPL_NS_CONF_HASH_SIZE
+#else /* RPL_NS_CONF_HASH_SIZE */
+#define RPL_NS_HASH_SIZE 16
+#endif /* RPL_NS_CONF_HASH_SIZE */
+
+/* Number of source routes cached by the root when inserting SRHs,
+   0 to disable the cache */
+#ifdef RPL_NS_CONF_ROUTE_CACHE_SIZE
+#define RPL_NS_ROUTE_CACHE_SIZE RPL_NS_CONF_ROUTE_CACHE_SIZE
+#else /* RPL_NS_CONF_ROUTE_CACHE_SIZE */
+#define RPL_NS_ROUTE_CACHE_SIZE 4
+#endif /* RPL_NS_CONF_ROUTE_CACHE_SIZE */
+
+/* Bytes of compressed SRH addresses a cached route holds. Longer routes
+   are not cached. */
+#ifdef RPL_NS_CONF_ROUTE_CACHE_ADDR_LEN
+#define RPL_NS_ROUTE_CACHE_ADDR_LEN RPL_NS_CONF_ROUTE_CACHE_ADDR_LEN
+#else /* RPL_NS_CONF_ROUTE_CACHE_ADDR_LEN */
+#define RPL_NS_ROUTE_CACHE_ADDR_LEN 64
+#endif /* RPL_NS_CONF_ROUTE_CACHE_ADDR_LEN */
+
 typedef struct rpl_ns_node {
   struct rpl_ns_node *next;
+  struct rpl_ns_node *hash_next;
   uint32_t lifetime;
   rpl_dag_t *dag;
   /* Store only IPv6 link identifiers as all nodes in the DAG share the same prefix */
@@ -68,5 +92,6 @@ rpl_ns_node_t *rpl_ns_get_node(const rpl_dag_t *dag, const uip_ipaddr_t *addr);
 int rpl_ns_is_node_reachable(const rpl_dag_t *dag, const uip_ipaddr_t *addr);
 void rpl_ns_get_node_global_addr(uip_ipaddr_t *addr, rpl_ns_node_t *node);
 void rpl_ns_periodic(void);
+uint32_t rpl_ns_topology_version(void);
 
 #endif /* RPL_NS_H */
@@ -80,7 +80,7 @@
 #if RPL_OF0_ETX_BASED_SR
 /* Numbers suggested by P. Thubert for in the 6TiSCH WG. Anything that maps ETX to
  * a step between 1 and 9 works. */
-#define STEP_OF_RANK(p)       (((3 * parent_link_metric(p)) / LINK_STATS_ETX_DIVISOR) - 2)
+#define STEP_OF_RANK(p)       (((3 * rpl_get_parent_link_metric(p)) / LINK_STATS_ETX_DIVISOR) - 2)
 #endif /* RPL_OF0_ETX_BASED_SR */
 
 /*---------------------------------------------------------------------------*/
@@ -102,9 +102,11 @@ dao_ack_callback(rpl_parent_t *p, int status)
   if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
     /* punish the ETX as if this was 10 packets lost */
     link_stats_packet_sent(rpl_get_parent_lladdr(p), MAC_TX_OK, 10);
+    p->flags &= ~RPL_PARENT_FLAG_LINK_METRIC_VALID;
   } else if(status == RPL_DAO_ACK_TIMEOUT) { /* timeout = no ack */
     /* punish the total lack of ACK with a similar punishment */
     link_stats_packet_sent(rpl_get_parent_lladdr(p), MAC_TX_OK, 10);
+    p->flags &= ~RPL_PARENT_FLAG_LINK_METRIC_VALID;
   }
 }
 #endif /* RPL_WITH_DAO_ACK */
@@ -135,7 +137,7 @@ parent_path_cost(rpl_parent_t *p)
     return 0xffff;
   }
   /* path cost upper bound: 0xffff */
-  return MIN((uint32_t)p->rank + parent_link_metric(p), 0xffff);
+  return MIN((uint32_t)p->rank + rpl_get_parent_link_metric(p), 0xffff);
 }
 /*---------------------------------------------------------------------------*/
 static rpl_rank_t
@@ -196,7 +198,7 @@ best_parent(rpl_parent_t *p1, rpl_parent_t *p2)
     }
     /* None of the nodes is the current preferred parent,
      * choose parent with best link metric */
-    return parent_link_metric(p1) < parent_link_metric(p2) ? p1 : p2;
+    return rpl_get_parent_link_metric(p1) < rpl_get_parent_link_metric(p2) ? p1 : p2;
   }
 }
 /*---------------------------------------------------------------------------*/
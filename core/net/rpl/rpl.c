@@ -252,22 +252,17 @@ rpl_add_route(rpl_dag_t *dag, uip_ipaddr_t *prefix, int prefix_len,
 void
 rpl_link_neighbor_callback(const linkaddr_t *addr, int status, int numtx)
 {
-  uip_ipaddr_t ipaddr;
   rpl_parent_t *parent;
-  rpl_instance_t *instance;
-  rpl_instance_t *end;
 
-  uip_ip6addr(&ipaddr, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
-  uip_ds6_set_addr_iid(&ipaddr, (uip_lladdr_t *)addr);
-
-  for(instance = &instance_table[0], end = instance + RPL_MAX_INSTANCES; instance < end; ++instance) {
-    if(instance->used == 1 ) {
-      parent = rpl_find_parent_any_dag(instance, &ipaddr);
-      if(parent != NULL) {
-        /* Trigger DAG rank recalculation. */
-        PRINTF("RPL: rpl_link_neighbor_callback triggering update\n");
-        parent->flags |= RPL_PARENT_FLAG_UPDATED;
-      }
+  parent = nbr_table_get_from_lladdr(rpl_parents, addr);
+  if(parent != NULL) {
+    /* The link statistics of the parent were just updated */
+    parent->flags &= ~RPL_PARENT_FLAG_LINK_METRIC_VALID;
+    if(parent->dag != NULL && parent->dag->instance != NULL &&
+       parent->dag->instance->used == 1) {
+      /* Trigger DAG rank recalculation. */
+      PRINTF("RPL: rpl_link_neighbor_callback triggering update\n");
+      parent->flags |= RPL_PARENT_FLAG_UPDATED;
     }
   }
 }
@@ -117,6 +117,9 @@ struct rpl_parent {
   rpl_metric_container_t mc;
 #endif /* RPL_WITH_MC */
   rpl_rank_t rank;
+#if RPL_WITH_PARENT_METRIC_CACHE
+  uint16_t link_metric; /* Valid if RPL_PARENT_FLAG_LINK_METRIC_VALID */
+#endif /* RPL_WITH_PARENT_METRIC_CACHE */
   uint8_t dtsn;
   uint8_t flags;
 };
@@ -61,9 +61,16 @@ tapdev_output(void)
 static void
 pollhandler(void)
 {
-  uip_len = tapdev_poll();
+  int n;
+
+  for(n = 0; n < TAPDEV_BATCH; n++) {
+    uip_len = tapdev_poll();
+
+    if(uip_len == 0) {
+      /* Drained */
+      return;
+    }
 
-  if(uip_len > 0) {
 #if NETSTACK_CONF_WITH_IPV6
     if(BUF->type == uip_htons(UIP_ETHTYPE_IPV6)) {
       tcpip_input();
@@ -86,6 +93,12 @@ pollhandler(void)
       uip_clear_buf();
     }
   }
+
+#if TAPDEV_BATCH > 1
+  /* There may be more frames waiting. Come back after other processes had
+     their turn */
+  process_poll(&tapdev_process);
+#endif
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(tapdev_process, ev, data)
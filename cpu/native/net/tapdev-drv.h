@@ -35,6 +35,15 @@
 
 #include "contiki.h"
 
+/* Maximum number of frames handed to the stack each time the driver is
+   polled. With more than one, the device is drained until it is empty or
+   this many frames have been processed */
+#ifdef TAPDEV_CONF_BATCH
+#define TAPDEV_BATCH TAPDEV_CONF_BATCH
+#else
+#define TAPDEV_BATCH 1
+#endif
+
 PROCESS_NAME(tapdev_process);
 
 uint8_t tapdev_output(void);
@@ -38,6 +38,7 @@
 
 #if NETSTACK_CONF_WITH_IPV6
 
+#include <errno.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -111,29 +112,22 @@ tapdev_fd(void)
 uint16_t
 tapdev_poll(void)
 {
-  fd_set fdset;
-  struct timeval tv;
   int ret;
-  
-  tv.tv_sec = 0;
-  tv.tv_usec = 0;
-  
-  FD_ZERO(&fdset);
-  if(fd > 0) {
-    FD_SET(fd, &fdset);
-  }
 
-  ret = select(fd + 1, &fdset, NULL, NULL, &tv);
-
-  if(ret == 0) {
+  if(fd <= 0) {
     return 0;
   }
+
+  /* The device is non-blocking, so an empty queue reads as EAGAIN */
   ret = read(fd, uip_buf, UIP_BUFSIZE);
 
   PRINTF("tapdev6: read %d bytes (max %d)\n", ret, UIP_BUFSIZE);
   
   if(ret == -1) {
-    perror("tapdev_poll: read");
+    if(errno != EAGAIN && errno != EWOULDBLOCK) {
+      perror("tapdev_poll: read");
+    }
+    return 0;
   }
   return ret;
 }
@@ -314,6 +308,12 @@ tapdev_init(void)
   }
 #endif /* Linux */
 
+  /* Lets tapdev_poll() read without checking for data with select() first */
+  if(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == -1) {
+    perror("tapdev: tapdev_init: fcntl");
+    exit(1);
+  }
+
 #ifdef __APPLE__
   tapdev_init_darwin_routes();
 #endif
@@ -369,6 +369,11 @@ do_send(void)
   ret = write(fd, uip_buf, uip_len);
 
   if(ret == -1) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK) {
+      /* Device queue full. Drop the frame, as a NIC would */
+      PRINTF("tapdev_send: queue full, dropped %d bytes\n", uip_len);
+      return;
+    }
     perror("tap_dev: tapdev_send: writev");
     exit(1);
   }
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Measures how many packets per second the ip64 NAT translates
+ *         with a full address mapping table
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "ip64.h"
+#include "ip64-addr.h"
+#include "dev/watchdog.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Each measurement is repeated in batches of BATCH packets until it
+   took at least MIN_TIME, so that the result does not depend on the
+   resolution of the clock. The best of ROUNDS measurements is
+   reported, which filters out time lost to other processes when
+   running on a host */
+#ifdef BENCHMARK_CONF_MIN_TIME
+#define MIN_TIME BENCHMARK_CONF_MIN_TIME
+#else /* BENCHMARK_CONF_MIN_TIME */
+#define MIN_TIME (2 * CLOCK_SECOND)
+#endif /* BENCHMARK_CONF_MIN_TIME */
+
+#ifdef BENCHMARK_CONF_ROUNDS
+#define ROUNDS BENCHMARK_CONF_ROUNDS
+#else /* BENCHMARK_CONF_ROUNDS */
+#define ROUNDS 5
+#endif /* BENCHMARK_CONF_ROUNDS */
+
+#define BATCH 1000
+
+/* Every flow is a node talking to the same server */
+#define FLOWS IP64_ADDRMAP_CONF_ENTRIES
+#define FIRST_NODE_PORT 40000
+#define SERVER_PORT     5683
+
+#define PAYLOAD_LEN 32
+#define IPV6_PACKET_LEN (UIP_IPUDPH_LEN + PAYLOAD_LEN)
+#define IPV4_PACKET_LEN (UIP_IPUDPH_LEN - UIP_IPH_LEN + 20 + PAYLOAD_LEN)
+
+#define IPV4_SRCADDR  12
+#define IPV4_DESTADDR 16
+#define IPV4_SRCPORT  20
+#define IPV4_DESTPORT 22
+
+/* Packets from the nodes, and the replies from the server */
+static uint8_t requests[FLOWS][IPV6_PACKET_LEN];
+static uint8_t replies[FLOWS][IPV4_PACKET_LEN];
+static uint8_t result[IPV6_PACKET_LEN];
+
+static uint16_t flows;
+static uint16_t next_flow;
+static unsigned long failed;
+
+/*---------------------------------------------------------------------------*/
+static void
+print_result(const char *name, uint16_t flows, unsigned long packets,
+             clock_time_t ticks)
+{
+  printf("%s, %u flows: %lu packets in %lu ticks, %lu packets/s\n",
+      name, flows, packets, (unsigned long)ticks,
+      (unsigned long)((unsigned long long)packets * CLOCK_SECOND / ticks));
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_request(uint16_t flow)
+{
+  struct uip_ip_hdr *ip = (struct uip_ip_hdr *)requests[flow];
+  struct uip_udp_hdr *udp =
+    (struct uip_udp_hdr *)&requests[flow][UIP_IPH_LEN];
+  uip_ip4addr_t server;
+
+  memset(ip, 0, UIP_IPUDPH_LEN);
+  ip->vtc = 0x60;
+  ip->len[1] = UIP_UDPH_LEN + PAYLOAD_LEN;
+  ip->proto = UIP_PROTO_UDP;
+  ip->ttl = 64;
+  uip_ip6addr(&ip->srcipaddr, 0xfd00, 0, 0, 0, 0x0212, 0x7400,
+              flow >> 8, flow + 1);
+  uip_ipaddr(&server, 10, 0, 0, 2);
+  ip64_addr_4to6(&server, &ip->destipaddr);
+  udp->srcport = UIP_HTONS(FIRST_NODE_PORT + flow);
+  udp->destport = UIP_HTONS(SERVER_PORT);
+  udp->udplen = UIP_HTONS(UIP_UDPH_LEN + PAYLOAD_LEN);
+  memset(&requests[flow][UIP_IPUDPH_LEN], flow, PAYLOAD_LEN);
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_reply(uint16_t flow)
+{
+  uint8_t *p = replies[flow];
+  uint8_t tmp[4];
+
+  /* Translate the request once, which creates its mapping, and turn
+     it around */
+  if(ip64_6to4(requests[flow], IPV6_PACKET_LEN, p) != IPV4_PACKET_LEN) {
+    failed++;
+    return;
+  }
+  memcpy(tmp, &p[IPV4_SRCADDR], 4);
+  memcpy(&p[IPV4_SRCADDR], &p[IPV4_DESTADDR], 4);
+  memcpy(&p[IPV4_DESTADDR], tmp, 4);
+  memcpy(tmp, &p[IPV4_SRCPORT], 2);
+  memcpy(&p[IPV4_SRCPORT], &p[IPV4_DESTPORT], 2);
+  memcpy(&p[IPV4_DESTPORT], tmp, 2);
+}
+/*---------------------------------------------------------------------------*/
+static void
+outbound(void)
+{
+  uint8_t packet[IPV4_PACKET_LEN];
+
+  if(ip64_6to4(requests[next_flow], IPV6_PACKET_LEN, packet) == 0) {
+    failed++;
+  }
+  if(++next_flow == flows) {
+    next_flow = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+inbound(void)
+{
+  if(ip64_4to6(replies[next_flow], IPV4_PACKET_LEN, result) == 0) {
+    failed++;
+  }
+  if(++next_flow == flows) {
+    next_flow = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+benchmark(const char *name, void (*op)(void))
+{
+  clock_time_t start;
+  clock_time_t ticks;
+  clock_time_t best_ticks;
+  unsigned long packets;
+  unsigned long best_packets;
+  uint16_t i;
+  uint8_t round;
+
+  best_packets = 0;
+  best_ticks = 1;
+  failed = 0;
+  next_flow = 0;
+  for(round = 0; round < ROUNDS; round++) {
+    packets = 0;
+    start = clock_time();
+    do {
+      for(i = 0; i < BATCH; i++) {
+        op();
+      }
+      packets += BATCH;
+      watchdog_periodic();
+      ticks = clock_time() - start;
+    } while(ticks < MIN_TIME);
+    /* packets / ticks > best_packets / best_ticks */
+    if((unsigned long long)packets * best_ticks >
+       (unsigned long long)best_packets * ticks) {
+      best_packets = packets;
+      best_ticks = ticks;
+    }
+  }
+  print_result(name, flows, best_packets, best_ticks);
+  if(failed > 0) {
+    printf("  %lu packets were not translated\n", failed);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(ip64_benchmark_process, "ip64 benchmark process");
+AUTOSTART_PROCESSES(&ip64_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(ip64_benchmark_process, ev, data)
+{
+  static const uint16_t flow_counts[] = { 1, 16, FLOWS };
+  static uip_ip4addr_t addr, netmask;
+  static uint16_t i;
+
+  PROCESS_BEGIN();
+
+  uip_ipaddr(&addr, 10, 0, 0, 1);
+  uip_ipaddr(&netmask, 255, 255, 255, 0);
+  ip64_set_ipv4_address(&addr, &netmask);
+
+  /* Fill the mapping table */
+  failed = 0;
+  for(i = 0; i < FLOWS; i++) {
+    make_request(i);
+    make_reply(i);
+  }
+  if(failed > 0) {
+    printf("%lu of %u mappings could not be created\n", failed, FLOWS);
+  }
+
+  for(i = 0; i < sizeof(flow_counts) / sizeof(flow_counts[0]); i++) {
+    flows = flow_counts[i];
+    benchmark("6to4", outbound);
+    benchmark("4to6", inbound);
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
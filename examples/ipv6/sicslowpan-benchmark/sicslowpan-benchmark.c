@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Measures the cost of 6LoWPAN header compression and
+ *         decompression per packet
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ip/tcpip.h"
+#include "net/ip/simple-udp.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/llsec/llsec.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "dev/watchdog.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Each measurement is repeated in batches of BATCH packets until it
+   took at least MIN_TIME, so that the result does not depend on the
+   resolution of the clock. The best of ROUNDS measurements is
+   reported, which filters out time lost to other processes when
+   running on a host */
+#ifdef BENCHMARK_CONF_MIN_TIME
+#define MIN_TIME BENCHMARK_CONF_MIN_TIME
+#else /* BENCHMARK_CONF_MIN_TIME */
+#define MIN_TIME (2 * CLOCK_SECOND)
+#endif /* BENCHMARK_CONF_MIN_TIME */
+
+#ifdef BENCHMARK_CONF_ROUNDS
+#define ROUNDS BENCHMARK_CONF_ROUNDS
+#else /* BENCHMARK_CONF_ROUNDS */
+#define ROUNDS 5
+#endif /* BENCHMARK_CONF_ROUNDS */
+
+#define BATCH 1000
+
+#define UDP_PORT    61616
+#define PAYLOAD_LEN 32
+
+#define UIP_IP_BUF  ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_UDP_BUF ((struct uip_udp_hdr *)&uip_buf[UIP_LLIPH_LEN])
+
+static uint8_t packet[UIP_IPUDPH_LEN + PAYLOAD_LEN];
+static uint8_t frame[PACKETBUF_SIZE];
+static uint16_t frame_len;
+static unsigned long received;
+static uip_lladdr_t peer_lladdr;
+static struct simple_udp_connection connection;
+
+/*---------------------------------------------------------------------------*/
+static void
+benchmark_llsec_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+benchmark_llsec_send(mac_callback_t sent, void *ptr)
+{
+  /* Keep the compressed frame instead of sending it */
+  frame_len = packetbuf_datalen();
+  memcpy(frame, packetbuf_dataptr(), frame_len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+benchmark_llsec_input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+const struct llsec_driver benchmark_llsec_driver = {
+  "benchmark_llsec",
+  benchmark_llsec_init,
+  benchmark_llsec_send,
+  benchmark_llsec_input
+};
+/*---------------------------------------------------------------------------*/
+static void
+receiver(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  received++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_result(const char *name, unsigned long packets, clock_time_t ticks)
+{
+  printf("%s: %lu packets in %lu ticks, %lu packets/s\n",
+      name, packets, (unsigned long)ticks,
+      (unsigned long)((unsigned long long)packets * CLOCK_SECOND / ticks));
+}
+/*---------------------------------------------------------------------------*/
+static void
+make_packet(const uip_ipaddr_t *src, const uip_ipaddr_t *dest)
+{
+  uint8_t i;
+
+  memset(UIP_IP_BUF, 0, UIP_IPUDPH_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->len[1] = UIP_UDPH_LEN + PAYLOAD_LEN;
+  UIP_IP_BUF->proto = UIP_PROTO_UDP;
+  UIP_IP_BUF->ttl = 64;
+  uip_ipaddr_copy(&UIP_IP_BUF->srcipaddr, src);
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, dest);
+  UIP_UDP_BUF->srcport = UIP_HTONS(UDP_PORT);
+  UIP_UDP_BUF->destport = UIP_HTONS(UDP_PORT);
+  UIP_UDP_BUF->udplen = UIP_HTONS(UIP_UDPH_LEN + PAYLOAD_LEN);
+  for(i = 0; i < PAYLOAD_LEN; i++) {
+    uip_buf[UIP_LLIPH_LEN + UIP_UDPH_LEN + i] = i;
+  }
+  uip_len = sizeof(packet);
+  UIP_UDP_BUF->udpchksum = ~(uip_udpchksum());
+  if(UIP_UDP_BUF->udpchksum == 0) {
+    UIP_UDP_BUF->udpchksum = 0xffff;
+  }
+  memcpy(packet, UIP_IP_BUF, sizeof(packet));
+}
+/*---------------------------------------------------------------------------*/
+static void
+compress(void)
+{
+  memcpy(UIP_IP_BUF, packet, sizeof(packet));
+  uip_len = sizeof(packet);
+  tcpip_output(&peer_lladdr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+uncompress(void)
+{
+  packetbuf_clear();
+  packetbuf_copyfrom(frame, frame_len);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, (linkaddr_t *)&peer_lladdr);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &linkaddr_node_addr);
+  NETSTACK_NETWORK.input();
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+benchmark(const char *name, void (*op)(void))
+{
+  clock_time_t start;
+  clock_time_t ticks;
+  clock_time_t best_ticks;
+  unsigned long packets;
+  unsigned long best_packets;
+  unsigned long total;
+  uint16_t i;
+  uint8_t round;
+
+  best_packets = 0;
+  best_ticks = 1;
+  total = 0;
+  for(round = 0; round < ROUNDS; round++) {
+    packets = 0;
+    start = clock_time();
+    do {
+      for(i = 0; i < BATCH; i++) {
+        op();
+      }
+      packets += BATCH;
+      watchdog_periodic();
+      ticks = clock_time() - start;
+    } while(ticks < MIN_TIME);
+    total += packets;
+    /* packets / ticks > best_packets / best_ticks */
+    if((unsigned long long)packets * best_ticks >
+       (unsigned long long)best_packets * ticks) {
+      best_packets = packets;
+      best_ticks = ticks;
+    }
+  }
+  print_result(name, best_packets, best_ticks);
+  return total;
+}
+/*---------------------------------------------------------------------------*/
+static void
+benchmark_compress(const char *name, const uip_ipaddr_t *src,
+                   const uip_ipaddr_t *dest)
+{
+  make_packet(src, dest);
+  benchmark(name, compress);
+  printf("  %u bytes compressed to %u\n", (unsigned)sizeof(packet), frame_len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+benchmark_uncompress(const char *name, const uip_ipaddr_t *src,
+                     const uip_ipaddr_t *dest)
+{
+  unsigned long packets;
+
+  /* The frame is what the peer would have sent us */
+  make_packet(src, dest);
+  tcpip_output(&uip_lladdr);
+
+  received = 0;
+  packets = benchmark(name, uncompress);
+  if(received != packets) {
+    printf("  only %lu of %lu packets received\n", received, packets);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(sicslowpan_benchmark_process, "6LoWPAN benchmark process");
+AUTOSTART_PROCESSES(&sicslowpan_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(sicslowpan_benchmark_process, ev, data)
+{
+  static uip_ipaddr_t own_ll, peer_ll, own_ctx, peer_ctx, own_glob, peer_glob;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&connection, UDP_PORT, NULL, UDP_PORT, receiver);
+
+  memcpy(&peer_lladdr, &uip_lladdr, sizeof(peer_lladdr));
+  peer_lladdr.addr[sizeof(peer_lladdr.addr) - 1] ^= 0x01;
+
+  /* Link-local, compressed from the MAC addresses */
+  uip_ip6addr(&own_ll, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&own_ll, &uip_lladdr);
+  uip_ip6addr(&peer_ll, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&peer_ll, &peer_lladdr);
+
+  /* Prefix of address context 0 */
+  uip_ip6addr(&own_ctx, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&own_ctx, &uip_lladdr);
+  uip_ds6_addr_add(&own_ctx, 0, ADDR_MANUAL);
+  uip_ip6addr(&peer_ctx, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&peer_ctx, &peer_lladdr);
+
+  /* No context, sent inline */
+  uip_ip6addr(&own_glob, 0x2001, 0xdb8, 0, 0, 0, 0, 0, 1);
+  uip_ds6_addr_add(&own_glob, 0, ADDR_MANUAL);
+  uip_ip6addr(&peer_glob, 0x2001, 0xdb8, 0, 0, 0, 0, 0, 2);
+
+  benchmark_compress("compress link-local", &own_ll, &peer_ll);
+  benchmark_compress("compress context", &own_ctx, &peer_ctx);
+  benchmark_compress("compress inline", &own_glob, &peer_glob);
+
+  benchmark_uncompress("uncompress link-local", &peer_ll, &own_ll);
+  benchmark_uncompress("uncompress context", &peer_ctx, &own_ctx);
+  benchmark_uncompress("uncompress inline", &peer_glob, &own_glob);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
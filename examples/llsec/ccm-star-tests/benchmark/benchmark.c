@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Measures the throughput of AES_128 and CCM_STAR
+ */
+
+#include "contiki.h"
+#include "lib/aes-128.h"
+#include "lib/ccm-star.h"
+#include "dev/watchdog.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Each measurement is repeated in batches of BATCH operations until
+   it took at least MIN_TIME, so that the result does not depend on
+   the resolution of the clock */
+#ifdef BENCHMARK_CONF_MIN_TIME
+#define MIN_TIME BENCHMARK_CONF_MIN_TIME
+#else /* BENCHMARK_CONF_MIN_TIME */
+#define MIN_TIME (2 * CLOCK_SECOND)
+#endif /* BENCHMARK_CONF_MIN_TIME */
+#define BATCH 100
+
+#define HDR_LEN     23
+#define PAYLOAD_LEN 96
+#define MIC_LEN     8
+
+static const uint8_t key[AES_128_KEY_LENGTH] = {
+  0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7,
+  0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF };
+
+static uint8_t frame[HDR_LEN + PAYLOAD_LEN + MIC_LEN];
+static uint8_t block[AES_128_BLOCK_SIZE];
+
+/*---------------------------------------------------------------------------*/
+static void
+print_result(const char *name, unsigned long bytes, clock_time_t ticks)
+{
+  printf("%s: %lu bytes in %lu ticks, %lu bytes/s\n",
+      name, bytes, (unsigned long)ticks,
+      (unsigned long)((unsigned long long)bytes * CLOCK_SECOND / ticks));
+}
+/*---------------------------------------------------------------------------*/
+static void
+aes_encrypt(void)
+{
+  AES_128.encrypt(block);
+}
+/*---------------------------------------------------------------------------*/
+static void
+ccm_star_aead(void)
+{
+  static uint8_t nonce[CCM_STAR_NONCE_LENGTH];
+
+  CCM_STAR.aead(nonce,
+      frame + HDR_LEN, PAYLOAD_LEN,
+      frame, HDR_LEN,
+      frame + HDR_LEN + PAYLOAD_LEN, MIC_LEN,
+      1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+benchmark(const char *name, void (*op)(void), uint16_t bytes_per_op)
+{
+  clock_time_t start;
+  clock_time_t ticks;
+  unsigned long ops;
+  uint8_t i;
+
+  ops = 0;
+  start = clock_time();
+  do {
+    for(i = 0; i < BATCH; i++) {
+      op();
+    }
+    ops += BATCH;
+    watchdog_periodic();
+    ticks = clock_time() - start;
+  } while(ticks < MIN_TIME);
+  print_result(name, ops * bytes_per_op, ticks);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(ccm_star_benchmark_process, "CCM* benchmark process");
+AUTOSTART_PROCESSES(&ccm_star_benchmark_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(ccm_star_benchmark_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  AES_128.set_key(key);
+  benchmark("AES_128.encrypt", aes_encrypt, AES_128_BLOCK_SIZE);
+  CCM_STAR.set_key(key);
+  benchmark("CCM_STAR.aead", ccm_star_aead, HDR_LEN + PAYLOAD_LEN);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Receives the UDP datagrams of udp-flood through the tap device
+ *         of minimal-net, and prints every second how many arrived, how
+ *         many were dropped before reaching the stack, and the CPU time
+ *         the node spent per datagram.
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ip/simple-udp.h"
+#include "net/tapdev-drv.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+
+#define UDP_PORT 5678
+
+static struct simple_udp_connection conn;
+static uint32_t received;
+static uint32_t lost;
+static uint32_t next_seqno;
+static uint8_t synced;
+
+PROCESS(tapdev_sink_process, "tapdev benchmark sink");
+AUTOSTART_PROCESSES(&tapdev_sink_process);
+/*---------------------------------------------------------------------------*/
+static void
+receiver(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  uint32_t seqno;
+
+  if(datalen < 4) {
+    return;
+  }
+  seqno = (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 |
+    (uint32_t)data[2] << 8 | data[3];
+  if(!synced || seqno < next_seqno) {
+    /* A new run of udp-flood */
+    synced = 1;
+  } else {
+    /* Datagrams the tap queue dropped because the node fell behind */
+    lost += seqno - next_seqno;
+  }
+  next_seqno = seqno + 1;
+  received++;
+}
+/*---------------------------------------------------------------------------*/
+/* CPU time used by the node so far, in microseconds */
+static unsigned long long
+cpu_time(void)
+{
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+  return (unsigned long long)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+    1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(tapdev_sink_process, ev, data)
+{
+  static struct etimer et;
+  static unsigned long long cpu;
+  unsigned long long used;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&conn, UDP_PORT, NULL, 0, receiver);
+  printf("tapdev benchmark: listening on port %u, TAPDEV_BATCH %u\n",
+         UDP_PORT, TAPDEV_BATCH);
+
+  cpu = cpu_time();
+  etimer_set(&et, CLOCK_SECOND);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+
+    used = cpu_time() - cpu;
+    cpu += used;
+    if(received > 0) {
+      printf("%lu datagrams/s, %lu lost, %llu.%02llu us CPU per datagram\n",
+             (unsigned long)received, (unsigned long)lost,
+             used / received, used * 100 / received % 100);
+      received = 0;
+      lost = 0;
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
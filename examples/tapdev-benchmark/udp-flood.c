@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Host side of the tapdev benchmark: sends numbered UDP datagrams
+ *         to tapdev-sink as fast as the host stack takes them, or at a
+ *         fixed rate, and prints how many were sent per second.
+ *
+ *         Usage: udp-flood <address>[%interface] [seconds] [datagrams/s]
+ */
+
+#include <errno.h>
+#include <netdb.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define UDP_PORT "5678"
+#define PAYLOAD_LEN 64
+
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  struct addrinfo hints;
+  struct addrinfo *dest;
+  uint8_t payload[PAYLOAD_LEN];
+  unsigned long sent;
+  unsigned long refused;
+  uint32_t seqno;
+  double seconds;
+  double rate;
+  double start;
+  double elapsed;
+  int err;
+  int s;
+
+  if(argc < 2) {
+    fprintf(stderr, "usage: %s <address>[%%interface] [seconds] [datagrams/s]\n",
+            argv[0]);
+    return 1;
+  }
+  seconds = argc > 2 ? atof(argv[2]) : 10;
+  rate = argc > 3 ? atof(argv[3]) : 0;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET6;
+  hints.ai_socktype = SOCK_DGRAM;
+  err = getaddrinfo(argv[1], UDP_PORT, &hints, &dest);
+  if(err != 0) {
+    fprintf(stderr, "%s: %s\n", argv[1], gai_strerror(err));
+    return 1;
+  }
+  s = socket(dest->ai_family, dest->ai_socktype, dest->ai_protocol);
+  if(s < 0 || connect(s, dest->ai_addr, dest->ai_addrlen) < 0) {
+    perror("udp-flood");
+    return 1;
+  }
+
+  /* Let neighbor discovery complete before the clock starts. The sink
+     ignores empty datagrams */
+  send(s, payload, 0, 0);
+  sleep(1);
+
+  memset(payload, 0, sizeof(payload));
+  sent = 0;
+  refused = 0;
+  seqno = 0;
+  start = now();
+  while((elapsed = now() - start) < seconds) {
+    if(rate > 0 && sent >= rate * elapsed) {
+      continue;
+    }
+    payload[0] = seqno >> 24;
+    payload[1] = seqno >> 16;
+    payload[2] = seqno >> 8;
+    payload[3] = seqno;
+    if(send(s, payload, sizeof(payload), 0) < 0) {
+      if(errno != ENOBUFS && errno != EAGAIN) {
+        perror("udp-flood");
+        return 1;
+      }
+      refused++;
+      continue;
+    }
+    seqno++;
+    sent++;
+  }
+  printf("%lu datagrams in %.1f s: %.0f datagrams/s, %lu refused by the host\n",
+         sent, elapsed, sent / elapsed, refused);
+
+  freeaddrinfo(dest);
+  close(s);
+  return 0;
+}
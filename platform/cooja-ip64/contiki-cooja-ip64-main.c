@@ -347,11 +347,13 @@ Java_org_contikios_cooja_corecomm_CLASSNAME_getMemory(JNIEnv *env, jobject obj,
 JNIEXPORT void JNICALL
 Java_org_contikios_cooja_corecomm_CLASSNAME_setMemory(JNIEnv *env, jobject obj, jint rel_addr, jint length, jbyteArray mem_arr)
 {
-  jbyte *mem = (*env)->GetByteArrayElements(env, mem_arr, 0);
-  memcpy((char *)(((long)rel_addr) + referenceVar),
-         mem,
-         length);
-  (*env)->ReleaseByteArrayElements(env, mem_arr, mem, 0);
+  (*env)->GetByteArrayRegion(
+      env,
+      mem_arr,
+      0,
+      (size_t) length,
+      (jbyte *) (((long)rel_addr) + referenceVar)
+  );
 }
 /*---------------------------------------------------------------------------*/
 /**
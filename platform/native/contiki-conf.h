@@ -158,6 +158,11 @@ typedef unsigned short uip_stats_t;
 
 #endif /* NETSTACK_CONF_WITH_IPV6 */
 
+/* Use the table-driven AES-128 implementation */
+#ifndef AES_128_CONF
+#define AES_128_CONF             aes_128_ttable_driver
+#endif /* AES_128_CONF */
+
 #include <ctype.h>
 #define ctk_arch_isprint isprint
 
@@ -46,6 +46,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/select.h>
+#include <signal.h>
 #include <errno.h>
 
 #ifdef __CYGWIN__
@@ -78,8 +79,20 @@
 #define SELECT_MAX 8
 #endif
 
+/*
+ * Upper bound (in clock ticks) on how long the main loop sleeps in select()
+ * when no process has work pending. 0 means sleep until the next etimer
+ * expires or a file descriptor becomes ready, however long that takes
+ */
+#ifdef SELECT_CONF_TIMEOUT_MAX
+#define SELECT_TIMEOUT_MAX SELECT_CONF_TIMEOUT_MAX
+#else
+#define SELECT_TIMEOUT_MAX 0
+#endif
+
 static const struct select_callback *select_callback[SELECT_MAX];
 static int select_max = 0;
+static sigset_t select_sigmask;
 
 SENSORS(&pir_sensor, &vib_sensor, &button_sensor);
 
@@ -140,6 +153,42 @@ const static struct select_callback stdin_fd = {
   stdin_set_fd, stdin_handle_fd
 };
 /*---------------------------------------------------------------------------*/
+/*
+ * Work out how long select() may block. Don't block at all if processes
+ * still have events or polls pending, otherwise sleep until the next etimer
+ * expiration. Returns NULL if there is nothing to wait for but I/O.
+ */
+static struct timespec *
+select_timeout(struct timespec *ts, int pending)
+{
+  clock_time_t now;
+  clock_time_t delay;
+
+  delay = 0;
+  if(!pending) {
+    if(etimer_pending()) {
+      now = clock_time();
+      delay = etimer_next_expiration_time() - now;
+      if((long)delay < 0) {
+        delay = 0;
+      }
+    } else if(SELECT_TIMEOUT_MAX == 0) {
+      return NULL;
+    } else {
+      delay = SELECT_TIMEOUT_MAX;
+    }
+#if SELECT_TIMEOUT_MAX
+    if(delay > SELECT_TIMEOUT_MAX) {
+      delay = SELECT_TIMEOUT_MAX;
+    }
+#endif
+  }
+
+  ts->tv_sec = delay / CLOCK_SECOND;
+  ts->tv_nsec = (delay % CLOCK_SECOND) * (1000000000L / CLOCK_SECOND);
+  return ts;
+}
+/*---------------------------------------------------------------------------*/
 static void
 set_rime_addr(void)
 {
@@ -250,19 +299,30 @@ main(int argc, char **argv)
   setvbuf(stdout, (char *)NULL, _IONBF, 0);
 
   select_set_callback(STDIN_FILENO, &stdin_fd);
+
+  /*
+   * rtimers are driven by SIGALRM. Keep it blocked except while we are
+   * sleeping in pselect(), so that a poll requested from the signal handler
+   * cannot slip in between process_run() and going to sleep
+   */
+  {
+    sigset_t alrm;
+
+    sigemptyset(&alrm);
+    sigaddset(&alrm, SIGALRM);
+    sigprocmask(SIG_BLOCK, &alrm, &select_sigmask);
+  }
+
   while(1) {
     fd_set fdr;
     fd_set fdw;
     int maxfd;
     int i;
     int retval;
-    struct timeval tv;
+    struct timespec ts;
 
     retval = process_run();
 
-    tv.tv_sec = 0;
-    tv.tv_usec = retval ? 1 : 1000;
-
     FD_ZERO(&fdr);
     FD_ZERO(&fdw);
     maxfd = 0;
@@ -272,7 +332,8 @@ main(int argc, char **argv)
       }
     }
 
-    retval = select(maxfd + 1, &fdr, &fdw, NULL, &tv);
+    retval = pselect(maxfd + 1, &fdr, &fdw, NULL,
+                     select_timeout(&ts, retval), &select_sigmask);
     if(retval < 0) {
       if(errno != EINTR) {
         perror("select");
@@ -286,7 +347,11 @@ main(int argc, char **argv)
       }
     }
 
-    etimer_request_poll();
+    /* Only wake up the etimer process if something is due */
+    if(etimer_pending() &&
+       (long)(clock_time() - etimer_next_expiration_time()) >= 0) {
+      etimer_request_poll();
+    }
 
 #if WITH_GUI
     if(console_resize()) {
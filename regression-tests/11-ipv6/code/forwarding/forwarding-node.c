@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Three nodes in a line: node 1 sends fragmented datagrams to
+ *         node 3 through node 2, which forwards the fragments.
+ *
+ *         Node 2 has the prefix on-link and does not know node 3 when
+ *         the first datagram arrives, so its first fragment cannot be
+ *         forwarded until the neighbor is resolved.
+ */
+
+#include "contiki.h"
+#include "contiki-lib.h"
+#include "contiki-net.h"
+#include "sys/node-id.h"
+
+#include <stdio.h>
+
+#define UDP_PORT 61618
+
+#define SEND_INTERVAL		(4 * CLOCK_SECOND)
+
+#define SENDER     1
+#define FORWARDER  2
+#define RECEIVER   3
+
+#ifndef SIZE
+#define SIZE 400
+#endif
+
+static struct simple_udp_connection connection;
+
+/*---------------------------------------------------------------------------*/
+PROCESS(forwarding_process, "Fragment forwarding process");
+AUTOSTART_PROCESSES(&forwarding_process);
+/*---------------------------------------------------------------------------*/
+static void
+receiver(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  static int msg;
+
+  msg++;
+  printf("Data %d received length %d\n", msg, datalen);
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_node_addr(uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr,
+              uint16_t prefix, uint16_t id)
+{
+  int i;
+
+  /* As set up by the Cooja platform */
+  for(i = 0; i < sizeof(lladdr->addr); i += 2) {
+    lladdr->addr[i + 1] = id & 0xff;
+    lladdr->addr[i + 0] = id >> 8;
+  }
+  uip_ip6addr(ipaddr, prefix, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(ipaddr, lladdr);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(forwarding_process, ev, data)
+{
+  static struct etimer periodic_timer;
+  static uint8_t buf[SIZE];
+  uip_ipaddr_t addr;
+  uip_ipaddr_t nexthop;
+  uip_lladdr_t lladdr;
+
+  PROCESS_BEGIN();
+
+  set_node_addr(&addr, &lladdr, UIP_DS6_DEFAULT_PREFIX, node_id);
+  uip_ds6_addr_add(&addr, 0, ADDR_AUTOCONF);
+
+  if(node_id == SENDER) {
+    /* Node 3 is reached through node 2. A route needs a neighbor
+       entry for its next hop. */
+    set_node_addr(&nexthop, &lladdr, 0xfe80, FORWARDER);
+    uip_ds6_nbr_add(&nexthop, &lladdr, 1, NBR_REACHABLE,
+                    NBR_TABLE_REASON_ROUTE, NULL);
+    set_node_addr(&addr, &lladdr, UIP_DS6_DEFAULT_PREFIX, RECEIVER);
+    if(uip_ds6_route_add(&addr, 128, &nexthop) == NULL) {
+      printf("Could not add a route\n");
+    }
+  } else {
+    /* Node 2 and 3 are on the same link */
+    uip_ip6addr(&addr, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+    uip_ds6_prefix_add(&addr, 64, 0, 0, 0, 0);
+  }
+
+  simple_udp_register(&connection, UDP_PORT,
+                      NULL, UDP_PORT,
+                      receiver);
+
+  if(node_id != SENDER) {
+    PROCESS_WAIT_EVENT_UNTIL(0);
+  }
+
+  etimer_set(&periodic_timer, 20 * CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+  etimer_set(&periodic_timer, SEND_INTERVAL);
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+    etimer_reset(&periodic_timer);
+
+    printf("Sending unicast\n");
+    set_node_addr(&addr, &lladdr, UIP_DS6_DEFAULT_PREFIX, RECEIVER);
+    simple_udp_sendto(&connection, buf, sizeof(buf), &addr);
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
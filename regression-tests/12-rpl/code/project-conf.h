@@ -28,3 +28,9 @@
  */
 #define TCPIP_CONF_ANNOTATE_TRANSMISSIONS 1
 
+
+/* Run OF0 instead of MRHOF */
+#ifdef WITH_OF0
+#define RPL_CONF_OF_OCP RPL_OCP_OF0
+#define RPL_CONF_SUPPORTED_OFS {&rpl_of0}
+#endif /* WITH_OF0 */
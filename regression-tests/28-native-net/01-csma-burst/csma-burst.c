@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Checks that CSMA hands all fragments of a datagram to the RDC
+ *         as one burst, and measures the goodput of a fragmented
+ *         transfer with and without bursts
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ip/simple-udp.h"
+#include "net/queuebuf.h"
+#include "test-rdc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define UDP_PORT 1234
+
+#define DATAGRAMS 20
+#define DATAGRAM_SIZE 300
+
+/* Half the channel check interval of ContikiMAC at 8 Hz */
+#define WAKEUP_TIME (CLOCK_SECOND / 16)
+
+static struct simple_udp_connection conn;
+static uip_ipaddr_t peer_ipaddr;
+static uint8_t payload[DATAGRAM_SIZE];
+
+PROCESS(csma_burst_process, "CSMA burst test");
+AUTOSTART_PROCESSES(&csma_burst_process);
+/*---------------------------------------------------------------------------*/
+static int
+all_sent(void)
+{
+  return queuebuf_numfree() == QUEUEBUF_NUM;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(csma_burst_process, ev, data)
+{
+  static struct etimer et;
+  static struct test_rdc_stats before;
+  static uint32_t calls[2];
+  static uint32_t frames[2];
+  static unsigned long goodput[2];
+  static clock_time_t start;
+  static int burst;
+  static int i;
+  const struct test_rdc_stats *stats;
+  uip_lladdr_t peer_lladdr = { { 0x02, 0, 0, 0, 0, 0, 0, 0x02 } };
+  int failed;
+
+  PROCESS_BEGIN();
+
+  uip_create_linklocal_prefix(&peer_ipaddr);
+  uip_ds6_set_addr_iid(&peer_ipaddr, &peer_lladdr);
+  uip_ds6_nbr_add(&peer_ipaddr, &peer_lladdr, 0, NBR_REACHABLE,
+                  NBR_TABLE_REASON_UNDEFINED, NULL);
+  simple_udp_register(&conn, UDP_PORT, NULL, UDP_PORT, NULL);
+  test_rdc_set_wakeup_time(WAKEUP_TIME);
+
+  /* Let the traffic sent at boot go out first */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  /* First with bursts, then with one frame per wake-up */
+  for(burst = 1; burst >= 0; burst--) {
+    test_rdc_set_max_burst(burst ? 0 : 1);
+    before = *test_rdc_get_stats();
+    start = clock_time();
+    for(i = 0; i < DATAGRAMS; i++) {
+      simple_udp_sendto(&conn, payload, sizeof(payload), &peer_ipaddr);
+      do {
+        etimer_set(&et, 1);
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+      } while(!all_sent());
+    }
+    stats = test_rdc_get_stats();
+    calls[burst] = stats->calls - before.calls;
+    frames[burst] = stats->frames - before.frames;
+    goodput[burst] = (unsigned long)DATAGRAMS * DATAGRAM_SIZE * CLOCK_SECOND /
+      (clock_time() - start);
+    printf("%s: %d datagrams of %d bytes, %lu frames in %lu wake-ups, "
+           "goodput %lu bytes/s\n",
+           burst ? "burst" : "single", DATAGRAMS, DATAGRAM_SIZE,
+           (unsigned long)frames[burst], (unsigned long)calls[burst],
+           goodput[burst]);
+  }
+
+  failed = 0;
+  if(calls[1] != DATAGRAMS) {
+    printf("Failure: the fragments of a datagram took %lu wake-ups\n",
+           (unsigned long)calls[1] / DATAGRAMS);
+    failed = 1;
+  }
+  if(frames[1] <= DATAGRAMS || frames[0] != frames[1]) {
+    printf("Failure: unexpected number of frames\n");
+    failed = 1;
+  }
+  if(goodput[1] <= goodput[0]) {
+    printf("Failure: bursts did not improve the goodput\n");
+    failed = 1;
+  }
+
+  printf(failed ? "TEST FAILED\n" : "TEST OK\n");
+  exit(failed);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
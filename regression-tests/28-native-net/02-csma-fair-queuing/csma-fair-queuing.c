@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Checks that RPL control traffic is not held up behind bulk
+ *         data in the CSMA queues when fair queuing is enabled
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-icmp6.h"
+#include "net/ip/simple-udp.h"
+#include "net/mac/csma.h"
+#include "net/queuebuf.h"
+#include "test-rdc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UIP_ICMP_PAYLOAD ((unsigned char *)&uip_buf[uip_l2_l3_icmp_hdr_len])
+
+#define UDP_PORT 1234
+
+#define DATAGRAM_SIZE 300
+/* Queue buffers kept free of data for the control traffic */
+#define CONTROL_HEADROOM 6
+
+#define CONTROL_INTERVAL (CLOCK_SECOND / 5)
+#define CONTROL_ROUNDS 50
+
+/* ICMPv6 codes of the RPL control messages */
+#define DIO_CODE 0x01
+#define DAO_CODE 0x02
+#define CONTROL_SIZE 40
+
+/* Frames per wake-up: one fragmented datagram, as with ContikiMAC */
+#define MAX_BURST 4
+
+/* A full frame takes 5 ticks on the air, plus one tick of clock
+   granularity */
+#define FRAME_TICKS 6
+
+/* Longest time a control packet may stay queued: the burst on the air
+   when it was queued, then the DIO and the DAO of its round, with one
+   frame of slack for the host scheduler. On average half a burst is
+   left. Without fair queuing control packets wait behind all queued
+   data, on average 26 ticks and up to 67 ticks. */
+#define CONTROL_MAX_SOJOURN ((MAX_BURST + 3) * FRAME_TICKS)
+#define CONTROL_AVERAGE_SOJOURN ((MAX_BURST / 2 + 2) * (FRAME_TICKS - 1))
+
+static struct simple_udp_connection conn;
+static uip_ipaddr_t parent_ipaddr;
+static uip_ipaddr_t neighbor_ipaddr;
+static uip_ipaddr_t rplnodes_ipaddr;
+static uint8_t payload[DATAGRAM_SIZE];
+
+PROCESS(csma_fair_queuing_process, "CSMA fair queuing test");
+AUTOSTART_PROCESSES(&csma_fair_queuing_process);
+/*---------------------------------------------------------------------------*/
+static void
+add_neighbor(uip_ipaddr_t *ipaddr, uint8_t id)
+{
+  uip_lladdr_t lladdr = { { 0x02, 0, 0, 0, 0, 0, 0, 0 } };
+
+  lladdr.addr[sizeof(lladdr.addr) - 1] = id;
+  uip_create_linklocal_prefix(ipaddr);
+  uip_ds6_set_addr_iid(ipaddr, &lladdr);
+  uip_ds6_nbr_add(ipaddr, &lladdr, 1, NBR_REACHABLE,
+                  NBR_TABLE_REASON_UNDEFINED, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_control(const uip_ipaddr_t *dest, int code)
+{
+  memset(UIP_ICMP_PAYLOAD, 0, CONTROL_SIZE);
+  uip_icmp6_send(dest, ICMP6_RPL, code, CONTROL_SIZE);
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_stats(const char *name, uint8_t traffic_class)
+{
+  const struct csma_class_stats *stats;
+
+  stats = csma_get_class_stats(traffic_class);
+  printf("%s: %lu packets, sojourn average %lu max %lu ticks, "
+         "max queued %u\n", name, (unsigned long)stats->dequeued,
+         (unsigned long)(stats->sojourn_total / stats->dequeued),
+         (unsigned long)stats->sojourn_max, stats->max_queued);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(csma_fair_queuing_process, ev, data)
+{
+  static struct etimer et;
+  static struct etimer control_timer;
+  static int rounds;
+  static int turn;
+  const struct csma_class_stats *control;
+  const struct csma_class_stats *data_stats;
+  int failed;
+
+  PROCESS_BEGIN();
+
+  add_neighbor(&parent_ipaddr, 2);
+  add_neighbor(&neighbor_ipaddr, 3);
+  uip_ip6addr(&rplnodes_ipaddr, 0xff02, 0, 0, 0, 0, 0, 0, 0x001a);
+  simple_udp_register(&conn, UDP_PORT, NULL, UDP_PORT, NULL);
+  test_rdc_set_max_burst(MAX_BURST);
+
+  /* Let the traffic sent at boot go out first */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  etimer_set(&control_timer, CONTROL_INTERVAL);
+  rounds = 0;
+  while(rounds < CONTROL_ROUNDS) {
+    /* Keep the data queues full, in turn to the parent and a neighbor */
+    while(queuebuf_numfree() > CONTROL_HEADROOM) {
+      simple_udp_sendto(&conn, payload, sizeof(payload),
+                        turn++ & 1 ? &neighbor_ipaddr : &parent_ipaddr);
+    }
+    if(etimer_expired(&control_timer)) {
+      etimer_reset(&control_timer);
+      send_control(&rplnodes_ipaddr, DIO_CODE);
+      send_control(&parent_ipaddr, DAO_CODE);
+      rounds++;
+    }
+    etimer_set(&et, 1);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  }
+
+  /* Let the queues drain */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  print_stats("control", CSMA_CLASS_CONTROL);
+  print_stats("data", CSMA_CLASS_DATA);
+
+  failed = 0;
+  control = csma_get_class_stats(CSMA_CLASS_CONTROL);
+  data_stats = csma_get_class_stats(CSMA_CLASS_DATA);
+  if(control->dequeued < 2 * CONTROL_ROUNDS) {
+    printf("Failure: control packets were lost\n");
+    failed = 1;
+  }
+  if(data_stats->max_queued < 2 * CONTROL_HEADROOM) {
+    printf("Failure: the data queues were not loaded\n");
+    failed = 1;
+  }
+  if(control->sojourn_total > CONTROL_AVERAGE_SOJOURN * control->dequeued) {
+    printf("Failure: control packets were queued for %lu ticks on average\n",
+           (unsigned long)(control->sojourn_total / control->dequeued));
+    failed = 1;
+  }
+  if(control->sojourn_max > CONTROL_MAX_SOJOURN) {
+    printf("Failure: control packets were queued for up to %lu ticks\n",
+           (unsigned long)control->sojourn_max);
+    failed = 1;
+  }
+
+  printf(failed ? "TEST FAILED\n" : "TEST OK\n");
+  exit(failed);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
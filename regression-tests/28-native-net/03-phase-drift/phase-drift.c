@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Measures the ContikiMAC strobes per unicast to phase-locked
+ *         receivers whose clocks run fast and slow, to check the drift
+ *         correction of the phase module
+ */
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+#include "net/packetbuf.h"
+#include "net/mac/mac.h"
+#include "net/mac/phase.h"
+#include "sys/etimer.h"
+#include "test-rdc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* ContikiMAC timing with 32 kHz rtimers, as in contikimac.c */
+#define CYCLE_TIME (RTIMER_ARCH_SECOND / 8)
+#define CCA_TIME (RTIMER_ARCH_SECOND / 8192 + RTIMER_ARCH_SECOND / 2000)
+#define CHECK_TIME (2 * CCA_TIME)
+#define CHECK_TIME_TX (6 * CCA_TIME)
+#define GUARD_TIME (10 * CHECK_TIME + CHECK_TIME_TX)
+#define STROBE_TIME (CYCLE_TIME + 2 * CHECK_TIME)
+#define INTER_PACKET_INTERVAL (RTIMER_ARCH_SECOND / 2500)
+
+/* A strobe: a frame with its PHY header at 250 kbit/s, then the wait
+   for the acknowledgement */
+#define FRAME_SIZE 60
+#define STROBE_PERIOD ((FRAME_SIZE + 6) * RTIMER_ARCH_SECOND / 31250 + \
+                       INTER_PACKET_INTERVAL)
+
+/* Strobe time to a receiver with a known phase. ContikiMAC gives up
+   after RTIMER_ARCH_SECOND / 60, which is barely more than the guard
+   time: here only a phase estimate that is off by more than the guard
+   time is counted as a miss. */
+#define MAX_PHASE_STROBE_TIME (2 * GUARD_TIME)
+
+/* Transmissions of a frame by CSMA */
+#define MAX_TRANSMISSIONS 8
+
+/* Receivers run this much fast and slow */
+#define SKEW_PPM 100
+
+/* The time between unicasts to a receiver doubles from the first one
+   up to the last one, as when the traffic of a node that just joined
+   settles down */
+#define FIRST_INTERVAL (10 * CLOCK_SECOND)
+#define LAST_INTERVAL (5 * 60 * CLOCK_SECOND)
+#define UNICASTS 40
+
+/* Strobes per unicast to a receiver woken up within the guard time */
+#define MAX_AVERAGE_STROBES (GUARD_TIME / STROBE_PERIOD + 2)
+
+struct receiver {
+  linkaddr_t addr;
+  long ppm;                  /* skew of the receiver's clock */
+  clock_time_t first_wakeup;
+  uint32_t unicasts;
+  uint32_t strobes;
+  uint32_t misses;           /* transmissions that were not acknowledged */
+  uint32_t lost;             /* unicasts that ran out of transmissions */
+};
+
+#define NUM_RECEIVERS 2
+static struct receiver receivers[NUM_RECEIVERS];
+
+/* The virtual clock, which advances by a tick whenever it is read */
+static clock_time_t now;
+
+static clock_time_t sent_at;
+static int sent;
+
+PROCESS(phase_drift_process, "Phase drift test");
+AUTOSTART_PROCESSES(&phase_drift_process);
+/*---------------------------------------------------------------------------*/
+clock_time_t
+clock_time(void)
+{
+  return now++;
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+clock_seconds(void)
+{
+  return now / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+void
+clock_delay(unsigned int d)
+{
+}
+/*---------------------------------------------------------------------------*/
+static void
+advance_to(clock_time_t t)
+{
+  if((long)(t - now) > 0) {
+    now = t;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+deferred_send(void)
+{
+  sent_at = clock_time();
+  sent = 1;
+  return MAC_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+/* The first wake-up of r at or after t. The receiver wakes up every
+   CYCLE_TIME of its own clock. */
+static clock_time_t
+next_wakeup(const struct receiver *r, clock_time_t t)
+{
+  uint64_t cycle;
+  uint64_t k;
+
+  if((long)(t - r->first_wakeup) <= 0) {
+    return r->first_wakeup;
+  }
+  /* One cycle of the receiver, in millionths of a tick */
+  cycle = (uint64_t)CYCLE_TIME * (1000000 + r->ppm);
+  k = ((uint64_t)(t - r->first_wakeup) * 1000000 + cycle - 1) / cycle;
+  return r->first_wakeup + (clock_time_t)(k * cycle / 1000000);
+}
+/*---------------------------------------------------------------------------*/
+/* Strobes a frame from time start, as ContikiMAC does, until the
+   receiver wakes up and acknowledges it or the strobe time runs out.
+   The receiver detects the strobes when it wakes up and acknowledges
+   the next one. */
+static int
+strobe(struct receiver *r, clock_time_t start, int known_phase)
+{
+  clock_time_t limit;
+  clock_time_t encounter;
+  uint32_t strobes;
+
+  limit = known_phase ? MAX_PHASE_STROBE_TIME : STROBE_TIME;
+  strobes = (next_wakeup(r, start) - start + STROBE_PERIOD - 1) /
+    STROBE_PERIOD;
+  if(strobes * STROBE_PERIOD >= limit) {
+    r->strobes += (limit + STROBE_PERIOD - 1) / STROBE_PERIOD;
+    r->misses++;
+    advance_to(start + limit);
+    phase_update(&r->addr, CYCLE_TIME, 0, MAC_TX_NOACK);
+    return MAC_TX_NOACK;
+  }
+  r->strobes += strobes + 1;
+  encounter = start + strobes * STROBE_PERIOD;
+  advance_to(encounter + STROBE_PERIOD);
+  phase_update(&r->addr, CYCLE_TIME, (rtimer_clock_t)encounter, MAC_TX_OK);
+  return MAC_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(phase_drift_process, ev, data)
+{
+  static struct receiver *r;
+  static clock_time_t interval;
+  static clock_time_t start;
+  static phase_status_t status;
+  static int i;
+  static int tx;
+  int failed;
+
+  PROCESS_BEGIN();
+
+  phase_init();
+  test_rdc_set_hook(deferred_send);
+  for(i = 0; i < NUM_RECEIVERS; i++) {
+    r = &receivers[i];
+    r->addr.u8[0] = i + 2;
+    r->ppm = i & 1 ? -SKEW_PPM : SKEW_PPM;
+    r->first_wakeup = now + 1000 + i * 1234;
+  }
+
+  interval = FIRST_INTERVAL;
+  for(i = 0; i < UNICASTS * NUM_RECEIVERS; i++) {
+    r = &receivers[i % NUM_RECEIVERS];
+    if(i % NUM_RECEIVERS == 0 && i > 0 && interval < LAST_INTERVAL) {
+      interval = MIN(2 * interval, LAST_INTERVAL);
+    }
+    /* Unicasts are not aligned to the cycle */
+    advance_to(now + interval / NUM_RECEIVERS + i * 37);
+    r->unicasts++;
+
+    for(tx = 0; tx < MAX_TRANSMISSIONS; tx++) {
+      packetbuf_clear();
+      packetbuf_set_datalen(FRAME_SIZE);
+      packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &r->addr);
+      status = phase_wait(&r->addr, CYCLE_TIME, GUARD_TIME, NULL, NULL, NULL);
+      if(status == PHASE_DEFERRED) {
+        /* Run the ctimer that sends the frame before the wake-up. The
+           clock jumps to the next timer once all events are handled. */
+        sent = 0;
+        while(!sent) {
+          if(process_nevents() == 0) {
+            advance_to(etimer_next_expiration_time());
+            etimer_request_poll();
+          }
+          PROCESS_PAUSE();
+        }
+        start = sent_at;
+      } else {
+        start = clock_time();
+      }
+      if(strobe(r, start, status != PHASE_UNKNOWN) == MAC_TX_OK) {
+        break;
+      }
+      /* Back off for a cycle before the retransmission */
+      advance_to(now + CYCLE_TIME);
+    }
+    if(tx == MAX_TRANSMISSIONS) {
+      r->lost++;
+    }
+  }
+
+  failed = 0;
+  for(i = 0; i < NUM_RECEIVERS; i++) {
+    r = &receivers[i];
+    printf("receiver %+ld ppm: %lu unicasts, %lu.%lu strobes per unicast, "
+           "%lu misses, %lu lost\n", r->ppm, (unsigned long)r->unicasts,
+           (unsigned long)(r->strobes / r->unicasts),
+           (unsigned long)(r->strobes * 10 / r->unicasts % 10),
+           (unsigned long)r->misses, (unsigned long)r->lost);
+    if(r->misses > 0) {
+      printf("Failure: the sender missed the receiver's wake-up\n");
+      failed = 1;
+    }
+    if(r->strobes > MAX_AVERAGE_STROBES * r->unicasts) {
+      printf("Failure: more than %u strobes per unicast\n",
+             MAX_AVERAGE_STROBES);
+      failed = 1;
+    }
+  }
+
+  printf(failed ? "TEST FAILED\n" : "TEST OK\n");
+  exit(failed);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
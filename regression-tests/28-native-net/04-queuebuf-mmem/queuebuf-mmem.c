@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Measures how many frames queuebufs in managed memory hold in
+ *         the RAM of statically allocated queuebufs, and checks that a
+ *         failed update leaves a queuebuf unchanged
+ */
+
+#include "contiki.h"
+#include "lib/mmem.h"
+#include "net/packetbuf.h"
+#include "net/queuebuf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Frame lengths: an acknowledged RPL control message, a small UDP
+   datagram and a full 6LoWPAN fragment */
+static const uint16_t frame_lens[] = { 40, 80, PACKETBUF_SIZE };
+#define NUM_FRAME_LENS (sizeof(frame_lens) / sizeof(frame_lens[0]))
+
+/* A statically allocated queuebuf, as laid out by queuebuf.c */
+struct static_queuebuf_data {
+  uint8_t data[PACKETBUF_SIZE];
+  uint16_t len;
+  struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
+  struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+};
+
+static struct queuebuf *bufs[QUEUEBUF_NUM];
+static struct mmem rest;
+
+PROCESS(queuebuf_mmem_process, "Queuebuf in managed memory test");
+AUTOSTART_PROCESSES(&queuebuf_mmem_process);
+/*---------------------------------------------------------------------------*/
+static void
+make_frame(uint16_t len, uint8_t seqno)
+{
+  linkaddr_t receiver;
+
+  packetbuf_clear();
+  memset(packetbuf_dataptr(), seqno, len);
+  packetbuf_set_datalen(len);
+
+  /* The attributes CSMA and the framer set on a unicast frame */
+  memset(&receiver, seqno, sizeof(receiver));
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &receiver);
+  packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, 1);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, seqno);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS, 3);
+}
+/*---------------------------------------------------------------------------*/
+static int
+fill(uint16_t len)
+{
+  int n;
+
+  for(n = 0; n < QUEUEBUF_NUM; n++) {
+    make_frame(len, n + 1);
+    bufs[n] = queuebuf_new_from_packetbuf();
+    if(bufs[n] == NULL) {
+      break;
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+empty(int n)
+{
+  while(n-- > 0) {
+    if(bufs[n] != NULL) {
+      queuebuf_free(bufs[n]);
+      bufs[n] = NULL;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_intact(struct queuebuf *b, uint16_t len, uint8_t seqno)
+{
+  uint8_t *data;
+  uint16_t i;
+
+  if(queuebuf_datalen(b) != len ||
+     queuebuf_attr(b, PACKETBUF_ATTR_MAC_SEQNO) != seqno ||
+     queuebuf_attr(b, PACKETBUF_ATTR_PENDING) != 0) {
+    return 0;
+  }
+  data = queuebuf_dataptr(b);
+  for(i = 0; i < len; i++) {
+    if(data[i] != seqno) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(queuebuf_mmem_process, ev, data)
+{
+  unsigned int size;
+  int static_frames;
+  int frames;
+  int failed;
+  int i;
+  int n;
+
+  PROCESS_BEGIN();
+
+  failed = 0;
+
+  /* The handles are left out: a struct mmem takes two pointers and an
+     int more than the pointer of a static queuebuf */
+  static_frames = MMEM_CONF_SIZE / sizeof(struct static_queuebuf_data);
+  printf("%u bytes hold %d static queuebufs of %u bytes\n",
+         MMEM_CONF_SIZE, static_frames,
+         (unsigned)sizeof(struct static_queuebuf_data));
+  printf("%u extra bytes per handle\n",
+         (unsigned)(sizeof(struct mmem) - sizeof(void *)));
+
+  for(i = 0; i < NUM_FRAME_LENS; i++) {
+    frames = fill(frame_lens[i]);
+    printf("%u byte frames: %d in managed memory, %d static\n",
+           frame_lens[i], frames, static_frames);
+    /* No frame takes more room than a static queuebuf, and frames of
+       half the size or less take half the room or less */
+    if(frames < static_frames ||
+       (frame_lens[i] <= PACKETBUF_SIZE / 2 && frames < 2 * static_frames)) {
+      failed = 1;
+    }
+    empty(frames);
+  }
+
+  /* A frame that cannot grow in a full heap is left as it was */
+  n = fill(frame_lens[0]);
+  for(size = MMEM_CONF_SIZE; size > 0; size--) {
+    if(mmem_alloc(&rest, size)) {
+      break;
+    }
+  }
+  make_frame(PACKETBUF_SIZE, 1);
+  packetbuf_set_attr(PACKETBUF_ATTR_PENDING, 1);
+  if(queuebuf_update_from_packetbuf(bufs[0]) ||
+     queuebuf_update_attr_from_packetbuf(bufs[0]) ||
+     !is_intact(bufs[0], frame_lens[0], 1)) {
+    printf("update in a full heap was not rejected cleanly\n");
+    failed = 1;
+  }
+
+  /* Once there is room, the update goes through */
+  if(size > 0) {
+    mmem_free(&rest);
+  }
+  queuebuf_free(bufs[n - 1]);
+  queuebuf_free(bufs[n - 2]);
+  queuebuf_free(bufs[n - 3]);
+  bufs[n - 1] = bufs[n - 2] = bufs[n - 3] = NULL;
+  if(!queuebuf_update_from_packetbuf(bufs[0]) ||
+     queuebuf_datalen(bufs[0]) != PACKETBUF_SIZE ||
+     queuebuf_attr(bufs[0], PACKETBUF_ATTR_PENDING) != 1 ||
+     !is_intact(bufs[1], frame_lens[0], 2)) {
+    printf("update after freeing was not applied\n");
+    failed = 1;
+  }
+  empty(n);
+
+  printf(failed ? "TEST FAILED\n" : "TEST OK\n");
+  exit(failed);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
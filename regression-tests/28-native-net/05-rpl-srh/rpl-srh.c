@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Measures the work a non-storing root does per downward packet:
+ *         the number of node addresses it builds from the node table
+ *         while inserting the source routing header. Checks every
+ *         header against the topology, also after a parent change.
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/rpl/rpl.h"
+#include "net/rpl/rpl-private.h"
+#include "net/rpl/rpl-ns.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Node 1 is the root, the parent of node n is node n / 2 */
+#define NUM_NODES 200
+
+/* Packets to the few destinations of a busy flow */
+#define HOT_ROUNDS 250
+static const int hot_nodes[] = { 128, 150, 175, 200 };
+#define NUM_HOT_NODES (sizeof(hot_nodes) / sizeof(hot_nodes[0]))
+
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_RH_BUF ((struct uip_routing_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN])
+#define UIP_SRH_BUF ((struct uip_rpl_srh_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN + RPL_RH_LEN])
+
+static int parent[NUM_NODES + 1];
+static rpl_dag_t *dag;
+static unsigned long addr_builds;
+static int failed;
+
+void __real_rpl_ns_get_node_global_addr(uip_ipaddr_t *addr, rpl_ns_node_t *node);
+
+PROCESS(rpl_srh_process, "RPL source routing header test");
+AUTOSTART_PROCESSES(&rpl_srh_process);
+/*---------------------------------------------------------------------------*/
+void
+__wrap_rpl_ns_get_node_global_addr(uip_ipaddr_t *addr, rpl_ns_node_t *node)
+{
+  addr_builds++;
+  __real_rpl_ns_get_node_global_addr(addr, node);
+}
+/*---------------------------------------------------------------------------*/
+/* Cooja style addresses, with an IID of 02:n:00:n:00:n:00:n */
+static void
+node_addr(uip_ipaddr_t *addr, int n)
+{
+  uip_ip6addr(addr, 0xfd00, 0, 0, 0, 0x0200 | n, n, n, n);
+}
+/*---------------------------------------------------------------------------*/
+static int
+depth(int n)
+{
+  int d;
+
+  for(d = 0; n != 1; n = parent[n]) {
+    d++;
+  }
+  return d;
+}
+/*---------------------------------------------------------------------------*/
+static int
+ancestor(int n, int d)
+{
+  int i;
+
+  for(i = depth(n); i > d; i--) {
+    n = parent[n];
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_parent(int n, int p)
+{
+  uip_ipaddr_t child;
+  uip_ipaddr_t parent_addr;
+
+  node_addr(&child, n);
+  node_addr(&parent_addr, p);
+  rpl_ns_update_node(dag, &child, &parent_addr, RPL_ROUTE_INFINITE_LIFETIME);
+  parent[n] = p;
+}
+/*---------------------------------------------------------------------------*/
+/* Sends a UDP header from the root to node n and checks the route */
+static void
+send_down(int n)
+{
+  uip_ipaddr_t addr;
+  uint8_t *hop;
+  uint8_t cmpri;
+  int d;
+  int i;
+
+  memset(uip_buf, 0, UIP_LLH_LEN + UIP_IPH_LEN + UIP_UDPH_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->len[1] = UIP_UDPH_LEN;
+  UIP_IP_BUF->proto = UIP_PROTO_UDP;
+  UIP_IP_BUF->ttl = 64;
+  node_addr(&UIP_IP_BUF->srcipaddr, 1);
+  node_addr(&UIP_IP_BUF->destipaddr, n);
+  uip_len = UIP_IPH_LEN + UIP_UDPH_LEN;
+  uip_ext_len = 0;
+
+  if(!rpl_update_header()) {
+    printf("node %d: no header\n", n);
+    failed = 1;
+    return;
+  }
+
+  /* The packet goes to the child of the root on the path, and then
+     through the addresses of the header, down to the destination */
+  d = depth(n);
+  node_addr(&addr, ancestor(n, 1));
+  if(!uip_ipaddr_cmp(&UIP_IP_BUF->destipaddr, &addr)) {
+    printf("node %d: wrong first hop\n", n);
+    failed = 1;
+    return;
+  }
+  if(d == 1) {
+    if(UIP_IP_BUF->proto != UIP_PROTO_UDP) {
+      printf("node %d: needless header\n", n);
+      failed = 1;
+    }
+    return;
+  }
+  if(UIP_IP_BUF->proto != UIP_PROTO_ROUTING ||
+     UIP_RH_BUF->seg_left != d - 1) {
+    printf("node %d: wrong header\n", n);
+    failed = 1;
+    return;
+  }
+  cmpri = UIP_SRH_BUF->cmpr >> 4;
+  hop = (uint8_t *)UIP_SRH_BUF + RPL_SRH_LEN;
+  for(i = 2; i <= d; i++) {
+    node_addr(&addr, ancestor(n, i));
+    if(memcmp(hop, (uint8_t *)&addr + cmpri, 16 - cmpri) != 0) {
+      printf("node %d: wrong hop %d\n", n, i);
+      failed = 1;
+      return;
+    }
+    hop += 16 - cmpri;
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rpl_srh_process, ev, data)
+{
+  uip_ipaddr_t root_addr;
+  uip_ipaddr_t prefix;
+  unsigned long builds;
+  unsigned long packets;
+  int round;
+  int i;
+  int n;
+
+  PROCESS_BEGIN();
+
+  node_addr(&root_addr, 1);
+  uip_ds6_addr_add(&root_addr, 0, ADDR_MANUAL);
+  dag = rpl_set_root(RPL_DEFAULT_INSTANCE, &root_addr);
+  uip_ip6addr(&prefix, 0xfd00, 0, 0, 0, 0, 0, 0, 0);
+  rpl_set_prefix(dag, &prefix, 64);
+
+  for(n = 2; n <= NUM_NODES; n++) {
+    set_parent(n, n / 2);
+  }
+  printf("%d nodes, depth %d\n", rpl_ns_num_nodes(), depth(NUM_NODES));
+
+  /* Every destination once: no route is cached */
+  addr_builds = 0;
+  for(n = 2; n <= NUM_NODES; n++) {
+    send_down(n);
+  }
+  packets = NUM_NODES - 1;
+  printf("all nodes: %lu addresses built per 100 packets\n",
+         addr_builds * 100 / packets);
+
+  /* A few busy destinations: only the first packet to each walks */
+  addr_builds = 0;
+  for(round = 0; round < HOT_ROUNDS; round++) {
+    builds = addr_builds;
+    for(i = 0; i < NUM_HOT_NODES; i++) {
+      send_down(hot_nodes[i]);
+    }
+    if(round > 0 && addr_builds != builds) {
+      printf("cached routes were walked\n");
+      failed = 1;
+    }
+  }
+  packets = HOT_ROUNDS * NUM_HOT_NODES;
+  printf("%d nodes: %lu addresses built per 100 packets\n",
+         (int)NUM_HOT_NODES, addr_builds * 100 / packets);
+
+  /* The routes through node 6 change */
+  set_parent(6, 5);
+  for(i = 0; i < NUM_HOT_NODES; i++) {
+    send_down(hot_nodes[i]);
+  }
+  for(n = 2; n <= NUM_NODES; n++) {
+    send_down(n);
+  }
+
+  printf(failed ? "TEST FAILED\n" : "TEST OK\n");
+  exit(failed);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Fills the IPv6 neighbor cache with neighbors that have Cooja
+ *         style link-layer addresses, and compares the speed of
+ *         uip_ds6_nbr_lookup() with a scan of the neighbor table
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-ds6-nbr.h"
+#include "dev/watchdog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Each measurement runs for at least MIN_TIME, the best of ROUNDS
+   measurements is reported */
+#define MIN_TIME (CLOCK_SECOND / 4)
+#define ROUNDS 5
+#define BATCH 1000
+
+#define NUM_NEIGHBORS NBR_TABLE_MAX_NEIGHBORS
+
+/* With 4 neighbors per bucket, a lookup is about 25 times faster than
+   a scan. Hashing the bytes of these addresses with XOR put them all in
+   one bucket, which was only 4 times faster. */
+#define MIN_SPEEDUP 8
+
+static uip_ipaddr_t addrs[NUM_NEIGHBORS];
+static int next;
+static unsigned long missing;
+
+PROCESS(ds6_nbr_lookup_process, "IPv6 neighbor lookup test");
+AUTOSTART_PROCESSES(&ds6_nbr_lookup_process);
+/*---------------------------------------------------------------------------*/
+/* A link-layer address of 00:n:00:n:00:n:00:n, as Cooja gives mote n */
+static void
+make_neighbor(int n, uip_lladdr_t *lladdr, uip_ipaddr_t *ipaddr)
+{
+  int i;
+
+  for(i = 0; i < sizeof(uip_lladdr_t); i++) {
+    lladdr->addr[i] = i & 1 ? n : 0;
+  }
+  uip_ip6addr(ipaddr, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(ipaddr, lladdr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+hashed_lookup(void)
+{
+  if(uip_ds6_nbr_lookup(&addrs[next]) == NULL) {
+    missing++;
+  }
+  next = (next + 1) % NUM_NEIGHBORS;
+}
+/*---------------------------------------------------------------------------*/
+/* How uip_ds6_nbr_lookup() found neighbors before it had an index */
+static void
+scanned_lookup(void)
+{
+  uip_ds6_nbr_t *nbr;
+
+  for(nbr = nbr_table_head(ds6_neighbors);
+      nbr != NULL;
+      nbr = nbr_table_next(ds6_neighbors, nbr)) {
+    if(uip_ipaddr_cmp(&nbr->ipaddr, &addrs[next])) {
+      break;
+    }
+  }
+  if(nbr == NULL) {
+    missing++;
+  }
+  next = (next + 1) % NUM_NEIGHBORS;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+benchmark(const char *name, void (*op)(void))
+{
+  clock_time_t start;
+  clock_time_t ticks;
+  clock_time_t best_ticks;
+  unsigned long lookups;
+  unsigned long best_lookups;
+  unsigned long rate;
+  uint16_t i;
+  uint8_t round;
+
+  best_lookups = 0;
+  best_ticks = 1;
+  for(round = 0; round < ROUNDS; round++) {
+    lookups = 0;
+    start = clock_time();
+    do {
+      for(i = 0; i < BATCH; i++) {
+        op();
+      }
+      lookups += BATCH;
+      watchdog_periodic();
+      ticks = clock_time() - start;
+    } while(ticks < MIN_TIME);
+    /* lookups / ticks > best_lookups / best_ticks */
+    if((unsigned long long)lookups * best_ticks >
+       (unsigned long long)best_lookups * ticks) {
+      best_lookups = lookups;
+      best_ticks = ticks;
+    }
+  }
+  rate = (unsigned long long)best_lookups * CLOCK_SECOND / best_ticks;
+  printf("%s: %lu lookups/s\n", name, rate);
+  return rate;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(ds6_nbr_lookup_process, ev, data)
+{
+  uip_lladdr_t lladdr;
+  unsigned long hashed;
+  unsigned long scanned;
+  int failed;
+  int n;
+
+  PROCESS_BEGIN();
+
+  failed = 0;
+
+  for(n = 0; n < NUM_NEIGHBORS; n++) {
+    make_neighbor(n + 1, &lladdr, &addrs[n]);
+    if(uip_ds6_nbr_add(&addrs[n], &lladdr, 0, NBR_REACHABLE,
+                       NBR_TABLE_REASON_UNDEFINED, NULL) == NULL) {
+      printf("could not add neighbor %d\n", n + 1);
+      failed = 1;
+    }
+  }
+  printf("%d neighbors, %d buckets\n", uip_ds6_nbr_num(),
+         UIP_DS6_NBR_HASH_SIZE);
+
+  scanned = benchmark("table scan", scanned_lookup);
+  hashed = benchmark("uip_ds6_nbr_lookup", hashed_lookup);
+  if(missing > 0) {
+    printf("%lu neighbors were not found\n", missing);
+    failed = 1;
+  }
+  if(hashed < MIN_SPEEDUP * scanned) {
+    printf("lookups are less than %dx faster than a scan\n", MIN_SPEEDUP);
+    failed = 1;
+  }
+
+  printf(failed ? "TEST FAILED\n" : "TEST OK\n");
+  exit(failed);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
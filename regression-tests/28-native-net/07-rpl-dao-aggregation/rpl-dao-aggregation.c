@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Feeds the DAOs of many children to a storing mode router that
+ *         aggregates them, counts the DAOs it forwards to its parent and
+ *         checks that the DAO ACKs of the parent reach every child once.
+ *         Also checks that a batch is sent as soon as a DAO does not fit
+ *         in it, and that losing the parent leaves no route pending.
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-icmp6.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/link-stats.h"
+#include "net/packetbuf.h"
+#include "net/rpl/rpl.h"
+#include "net/rpl/rpl-private.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Node 1 is the parent of the router. Children send their DAOs one
+   clock tick apart. */
+#define PARENT 1
+#define FIRST_CHILD 2
+#define NUM_CHILDREN 36
+/* Children that fill part of a batch, and one with NUM_DESCENDANTS
+   below it that does not fit in the rest */
+#define PARTIAL_CHILD (FIRST_CHILD + NUM_CHILDREN)
+#define NUM_PARTIAL 3
+#define BIG_CHILD (PARTIAL_CHILD + NUM_PARTIAL)
+#define NUM_DESCENDANTS (RPL_DAO_AGGREGATION_MAX_TARGETS - 1)
+#define FIRST_DESCENDANT 128
+/* Children whose batch is pending when the parent is lost */
+#define ORPHAN_CHILD (BIG_CHILD + 1)
+#define NUM_ORPHANS 2
+#define NUM_NODES (FIRST_DESCENDANT + NUM_DESCENDANTS)
+
+#define MAX_DAOS 16
+
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_ICMP_BUF ((struct uip_icmp_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN])
+#define UIP_ICMP_PAYLOAD ((uint8_t *)&uip_buf[uip_l2_l3_icmp_hdr_len])
+
+/* Per node: sequence number of its last DAO, times its targets were
+   forwarded, DAO ACKs forwarded to it and the last one's number */
+static uint8_t dao_seqno[NUM_NODES];
+static uint8_t forwarded[NUM_NODES];
+static uint8_t acks[NUM_NODES];
+static uint8_t ack_seqno[NUM_NODES];
+
+/* DAOs forwarded to the parent */
+static uint8_t fwd_seqno[MAX_DAOS];
+static int num_daos;
+static int max_dao_len;
+static int wrong_dest;
+
+static struct etimer et;
+static int failed;
+
+#define WAIT(t) do {                                   \
+    etimer_set(&et, (t));                              \
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));     \
+  } while(0)
+
+PROCESS(rpl_dao_aggregation_process, "RPL DAO aggregation test");
+AUTOSTART_PROCESSES(&rpl_dao_aggregation_process);
+/*---------------------------------------------------------------------------*/
+/* A link-layer address of 00:n:00:n:00:n:00:n, as Cooja gives mote n */
+static void
+node_lladdr(int n, uip_lladdr_t *lladdr)
+{
+  int i;
+
+  for(i = 0; i < sizeof(uip_lladdr_t); i++) {
+    lladdr->addr[i] = i & 1 ? n : 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_linklocal(int n, uip_ipaddr_t *addr)
+{
+  uip_lladdr_t lladdr;
+
+  node_lladdr(n, &lladdr);
+  uip_ip6addr(addr, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(addr, &lladdr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_global(int n, uip_ipaddr_t *addr)
+{
+  node_linklocal(n, addr);
+  addr->u16[0] = UIP_HTONS(0xfd00);
+}
+/*---------------------------------------------------------------------------*/
+static int
+find_node(const uip_ipaddr_t *addr)
+{
+  uip_ipaddr_t node_addr;
+  int n;
+
+  for(n = 1; n < NUM_NODES; n++) {
+    if(uip_is_addr_linklocal(addr)) {
+      node_linklocal(n, &node_addr);
+    } else {
+      node_global(n, &node_addr);
+    }
+    if(uip_ipaddr_cmp(addr, &node_addr)) {
+      return n;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+__wrap_uip_icmp6_send(const uip_ipaddr_t *dest, int type, int code,
+                      int payload_len)
+{
+  uint8_t *buffer;
+  uip_ipaddr_t target;
+  int pos;
+  int n;
+
+  if(type != ICMP6_RPL) {
+    return;
+  }
+  buffer = UIP_ICMP_PAYLOAD;
+
+  if(code == RPL_CODE_DAO) {
+    n = find_node(dest);
+    pos = 4 + (buffer[1] & RPL_DAO_D_FLAG ? 16 : 0);
+    if(n != PARENT || pos >= payload_len) {
+      /* The router's own DAOs have no targets: it has no global
+         address */
+      wrong_dest += n != PARENT;
+      return;
+    }
+    if(num_daos < MAX_DAOS) {
+      fwd_seqno[num_daos] = buffer[3];
+    }
+    num_daos++;
+    if(payload_len > max_dao_len) {
+      max_dao_len = payload_len;
+    }
+    for(; pos < payload_len; pos += 2 + buffer[pos + 1]) {
+      if(buffer[pos] == RPL_OPTION_TARGET && buffer[pos + 3] == 128) {
+        memcpy(&target, &buffer[pos + 4], sizeof(target));
+        forwarded[find_node(&target)]++;
+      }
+    }
+  } else if(code == RPL_CODE_DAO_ACK) {
+    n = find_node(dest);
+    acks[n]++;
+    ack_seqno[n] = buffer[2];
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Passes the RPL message in the payload of uip_buf to RPL, as if node
+   n had sent it */
+static void
+receive(int n, uint8_t code, int payload_len)
+{
+  uip_lladdr_t lladdr;
+
+  memset(uip_buf, 0, UIP_LLH_LEN + UIP_IPH_LEN + UIP_ICMPH_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->len[1] = UIP_ICMPH_LEN + payload_len;
+  UIP_IP_BUF->len[0] = (UIP_ICMPH_LEN + payload_len) >> 8;
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = 64;
+  node_linklocal(n, &UIP_IP_BUF->srcipaddr);
+  uip_ds6_select_src(&UIP_IP_BUF->destipaddr, &UIP_IP_BUF->srcipaddr);
+  UIP_ICMP_BUF->type = ICMP6_RPL;
+  UIP_ICMP_BUF->icode = code;
+  uip_len = UIP_IPH_LEN + UIP_ICMPH_LEN + payload_len;
+
+  node_lladdr(n, &lladdr);
+  packetbuf_clear();
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, (linkaddr_t *)&lladdr);
+  link_stats_input_callback((linkaddr_t *)&lladdr);
+  uip_icmp6_input(ICMP6_RPL, code);
+}
+/*---------------------------------------------------------------------------*/
+static void
+receive_dio(int n)
+{
+  uint8_t *buffer;
+  uip_ipaddr_t dag_id;
+
+  uip_ext_len = 0;
+  buffer = UIP_ICMP_PAYLOAD;
+  buffer[0] = RPL_DEFAULT_INSTANCE;
+  buffer[1] = RPL_LOLLIPOP_INIT;
+  buffer[2] = RPL_MIN_HOPRANKINC >> 8;
+  buffer[3] = RPL_MIN_HOPRANKINC & 0xff;
+  buffer[4] = 0x80 | RPL_MOP_STORING_NO_MULTICAST << 3; /* grounded */
+  buffer[5] = 0; /* DTSN */
+  buffer[6] = buffer[7] = 0;
+  node_global(n, &dag_id);
+  memcpy(&buffer[8], &dag_id, sizeof(dag_id));
+  receive(n, RPL_CODE_DIO, 24);
+}
+/*---------------------------------------------------------------------------*/
+/* A DAO from child n for itself and the num_descendants nodes from
+   first_descendant on, which asks for a DAO ACK */
+static void
+receive_dao(int n, int first_descendant, int num_descendants)
+{
+  uint8_t *buffer;
+  uip_ipaddr_t target;
+  int pos;
+  int i;
+
+  dao_seqno[n] = n;
+
+  uip_ext_len = 0;
+  buffer = UIP_ICMP_PAYLOAD;
+  pos = 0;
+  buffer[pos++] = RPL_DEFAULT_INSTANCE;
+  buffer[pos++] = RPL_DAO_K_FLAG;
+  buffer[pos++] = 0;
+  buffer[pos++] = dao_seqno[n];
+  for(i = -1; i < num_descendants; i++) {
+    node_global(i < 0 ? n : first_descendant + i, &target);
+    buffer[pos++] = RPL_OPTION_TARGET;
+    buffer[pos++] = 2 + sizeof(target);
+    buffer[pos++] = 0;
+    buffer[pos++] = 128;
+    memcpy(&buffer[pos], &target, sizeof(target));
+    pos += sizeof(target);
+  }
+  buffer[pos++] = RPL_OPTION_TRANSIT;
+  buffer[pos++] = 4;
+  buffer[pos++] = 0;
+  buffer[pos++] = 0;
+  buffer[pos++] = 0;
+  buffer[pos++] = RPL_DEFAULT_LIFETIME;
+  receive(n, RPL_CODE_DAO, pos);
+}
+/*---------------------------------------------------------------------------*/
+/* The parent acknowledges the forwarded DAOs from the first on */
+static void
+ack_daos(int first)
+{
+  uint8_t *buffer;
+  int i;
+
+  for(i = first; i < num_daos && i < MAX_DAOS; i++) {
+    uip_ext_len = 0;
+    buffer = UIP_ICMP_PAYLOAD;
+    buffer[0] = RPL_DEFAULT_INSTANCE;
+    buffer[1] = 0;
+    buffer[2] = fwd_seqno[i];
+    buffer[3] = RPL_DAO_ACK_UNCONDITIONAL_ACCEPT;
+    receive(PARENT, RPL_CODE_DAO_ACK, 4);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that the targets of nodes first to first + num - 1 were
+   forwarded once, and that each child got the DAO ACK of its DAO */
+static void
+check_nodes(const char *phase, int first, int num, int acked)
+{
+  int n;
+
+  for(n = first; n < first + num; n++) {
+    if(forwarded[n] != 1) {
+      printf("%s: target of node %d forwarded %u times\n",
+             phase, n, forwarded[n]);
+      failed = 1;
+    }
+    if(acked && n < FIRST_DESCENDANT &&
+       (acks[n] != 1 || ack_seqno[n] != dao_seqno[n])) {
+      printf("%s: node %d got %u DAO ACKs\n", phase, n, acks[n]);
+      failed = 1;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+pending_routes(void)
+{
+  uip_ds6_route_t *r;
+  int pending;
+
+  pending = 0;
+  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
+    if(RPL_ROUTE_IS_DAO_PENDING(r)) {
+      pending++;
+    }
+  }
+  return pending;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rpl_dao_aggregation_process, ev, data)
+{
+  static int n;
+  static int first_dao;
+  static clock_time_t start;
+  uip_ipaddr_t parent_addr;
+  rpl_dag_t *dag;
+
+  PROCESS_BEGIN();
+
+  receive_dio(PARENT);
+  dag = rpl_get_any_dag();
+  if(dag == NULL || dag->preferred_parent == NULL) {
+    printf("the router did not join the DAG\n");
+    printf("TEST FAILED\n");
+    exit(1);
+  }
+
+  /* Every child sends a DAO. A full batch is forwarded right away. */
+  start = clock_time();
+  for(n = FIRST_CHILD; n < FIRST_CHILD + NUM_CHILDREN; n++) {
+    receive_dao(n, 0, 0);
+    WAIT(1);
+  }
+  WAIT(1);
+  printf("%d child DAOs: %d DAOs forwarded in %lu ticks, up to %d bytes\n",
+         NUM_CHILDREN, num_daos, (unsigned long)(clock_time() - start),
+         max_dao_len);
+  if(num_daos > (NUM_CHILDREN + RPL_DAO_AGGREGATION_MAX_TARGETS - 1) /
+     RPL_DAO_AGGREGATION_MAX_TARGETS) {
+    printf("children: DAOs were not aggregated\n");
+    failed = 1;
+  }
+  ack_daos(0);
+  check_nodes("children", FIRST_CHILD, NUM_CHILDREN, 1);
+
+  /* A DAO that does not fit is forwarded as it is, and the batch
+     right after it */
+  first_dao = num_daos;
+  for(n = PARTIAL_CHILD; n < PARTIAL_CHILD + NUM_PARTIAL; n++) {
+    receive_dao(n, 0, 0);
+    WAIT(1);
+  }
+  receive_dao(BIG_CHILD, FIRST_DESCENDANT, NUM_DESCENDANTS);
+  WAIT(2);
+  if(num_daos - first_dao != 2) {
+    printf("partial batch: %d DAOs forwarded instead of 2\n",
+           num_daos - first_dao);
+    failed = 1;
+  }
+  ack_daos(first_dao);
+  check_nodes("partial batch", PARTIAL_CHILD, NUM_PARTIAL + 1, 1);
+  check_nodes("partial batch", FIRST_DESCENDANT, NUM_DESCENDANTS, 0);
+
+  if(pending_routes() > 0) {
+    printf("%d routes pending after all DAO ACKs\n", pending_routes());
+    failed = 1;
+  }
+
+  /* The parent is lost while a batch waits */
+  first_dao = num_daos;
+  for(n = ORPHAN_CHILD; n < ORPHAN_CHILD + NUM_ORPHANS; n++) {
+    receive_dao(n, 0, 0);
+  }
+  node_linklocal(PARENT, &parent_addr);
+  dag = rpl_get_any_dag();
+  rpl_remove_parent(rpl_find_parent(dag, &parent_addr));
+  WAIT(RPL_DAO_AGGREGATION_DELAY + 1);
+  if(num_daos != first_dao || pending_routes() > 0) {
+    printf("no parent: %d DAOs forwarded, %d routes pending\n",
+           num_daos - first_dao, pending_routes());
+    failed = 1;
+  }
+
+  if(wrong_dest > 0) {
+    printf("%d DAOs were not sent to the parent\n", wrong_dest);
+    failed = 1;
+  }
+
+  printf(failed ? "TEST FAILED\n" : "TEST OK\n");
+  exit(failed);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Sends datagrams as recoverable 6LoWPAN fragments over a lossy
+ *         link that loops them back to the node itself, which
+ *         reassembles and acknowledges them. Measures the goodput and
+ *         the retransmissions of fragment recovery, and compares them
+ *         with RFC 4944 fragments, which lose the whole datagram with
+ *         any of its fragments. Also checks that a datagram that the
+ *         MAC can not send is given up at once.
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ip/tcpip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/sicslowpan.h"
+#include "net/mac/mac.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "test-rdc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* UDP payload of the datagrams, which take several fragments */
+#define PAYLOAD_LEN 350
+
+/* 802.15.4 header, FCS and PHY header of a frame, as in test-rdc.c */
+#define FRAME_OVERHEAD 29
+
+/* Time after which the sender has given up a datagram */
+#define GIVE_UP_TIME (SICSLOWPAN_CONF_FRAG_RECOVERY_ACK_TIMEOUT * \
+                      (SICSLOWPAN_CONF_FRAG_RECOVERY_MAX_RETRIES + 2))
+
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_UDP_BUF ((struct uip_udp_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN])
+#define UIP_UDP_PAYLOAD (&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN + UIP_UDPH_LEN])
+
+struct phase {
+  const char *name;
+  uint8_t loss_percent;
+  /* Non-zero if the MAC can never send the second fragment of the
+     first datagram */
+  uint8_t fatal;
+  uint16_t datagrams;
+
+  uint16_t delivered;
+  uint16_t broken;        /* duplicate or corrupted datagrams */
+  uint16_t intact;        /* datagrams that lost no fragment when first sent */
+  uint16_t fragments;     /* fragments sent for the first time */
+  uint16_t resent;        /* fragments sent again */
+  uint16_t acks;
+  uint16_t lost;          /* frames lost on the link */
+  uint16_t rfc4944;       /* RFC 4944 fragments */
+  uint32_t first_bytes;   /* bytes on the air of the first transmissions */
+  uint32_t bytes;         /* bytes on the air */
+};
+
+static struct phase phases[] = {
+  { "no loss", 0, 0, 20 },
+  { "10% loss", 10, 0, 100 },
+  { "30% loss", 30, 0, 100 },
+  { "MAC error", 0, 1, 2 },
+};
+#define NUM_PHASES (sizeof(phases) / sizeof(phases[0]))
+
+/* Frames on their way back to the node */
+#define LOOP_LEN 32
+static struct {
+  linkaddr_t from;
+  uint16_t len;
+  uint8_t data[PACKETBUF_SIZE];
+} loop[LOOP_LEN];
+static uint8_t loop_head;
+static uint8_t loop_tail;
+
+static struct phase *phase;
+static linkaddr_t peer;
+static uint16_t datagram_id;
+static int datagram_tag;
+static uint32_t datagram_seen;
+static uint8_t datagram_lost;
+static uint8_t datagram_fatal;
+static uint8_t acked;
+static uint8_t delivered[256];
+static uint32_t seed = 1;
+
+static struct etimer et;
+
+#define WAIT(t) do {                                   \
+    etimer_set(&et, (t));                              \
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));     \
+  } while(0)
+
+PROCESS(frag_recovery_process, "6LoWPAN fragment recovery test");
+AUTOSTART_PROCESSES(&frag_recovery_process);
+/*---------------------------------------------------------------------------*/
+/* A pseudo-random number from 0 to 99, the same on every run */
+static int
+percentile(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 16) % 100;
+}
+/*---------------------------------------------------------------------------*/
+/* Counts the datagram that was sent last, if any */
+static void
+end_datagram(void)
+{
+  if(datagram_tag >= 0 && !datagram_lost) {
+    phase->intact++;
+  }
+  datagram_tag = -1;
+}
+/*---------------------------------------------------------------------------*/
+/* The test RDC calls this for every frame it sends */
+static int
+link_hook(void)
+{
+  uint8_t *hdr;
+  uint16_t len;
+  uint8_t tag;
+  uint8_t seq;
+  int first;
+  int lost;
+
+  hdr = packetbuf_dataptr();
+  len = packetbuf_totlen() + FRAME_OVERHEAD;
+  lost = 0;
+  if((hdr[0] & 0xfe) == SICSLOWPAN_DISPATCH_RFRAG) {
+    tag = hdr[1];
+    seq = (hdr[2] >> 2) & 0x1f;
+    if(tag != datagram_tag) {
+      /* The first fragment of the next datagram */
+      end_datagram();
+      datagram_tag = tag;
+      datagram_seen = 0;
+      datagram_lost = 0;
+    }
+    first = (datagram_seen & (1UL << seq)) == 0;
+    datagram_seen |= 1UL << seq;
+    if(first) {
+      phase->fragments++;
+      phase->first_bytes += len;
+    } else {
+      phase->resent++;
+    }
+    phase->bytes += len;
+    if(datagram_fatal && seq == 1) {
+      datagram_lost = 1;
+      return MAC_TX_ERR_FATAL;
+    }
+    lost = percentile() < phase->loss_percent;
+    if(first && lost) {
+      datagram_lost = 1;
+    }
+  } else if((hdr[0] & 0xfe) == SICSLOWPAN_DISPATCH_RFRAG_ACK) {
+    phase->acks++;
+    phase->bytes += len;
+    lost = percentile() < phase->loss_percent;
+  } else if((hdr[0] & 0xf8) == SICSLOWPAN_DISPATCH_FRAG1 ||
+            (hdr[0] & 0xf8) == SICSLOWPAN_DISPATCH_FRAGN) {
+    phase->rfc4944++;
+    phase->bytes += len;
+  } else {
+    /* Neighbor discovery */
+    return MAC_TX_OK;
+  }
+
+  if(lost) {
+    phase->lost++;
+    return MAC_TX_NOACK;
+  }
+  if((loop_head + 1) % LOOP_LEN == loop_tail) {
+    printf("loop overflow\n");
+    return MAC_TX_NOACK;
+  }
+  linkaddr_copy(&loop[loop_head].from, packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+  loop[loop_head].len = packetbuf_totlen();
+  memcpy(loop[loop_head].data, hdr, packetbuf_totlen());
+  loop_head = (loop_head + 1) % LOOP_LEN;
+  return MAC_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+/* Passes the frames that got through to 6LoWPAN, as if the node they
+   were sent to had sent them */
+static void
+deliver(void)
+{
+  uint8_t *data;
+
+  while(loop_tail != loop_head) {
+    data = loop[loop_tail].data;
+    if((data[0] & 0xfe) == SICSLOWPAN_DISPATCH_RFRAG_ACK &&
+       data[1] == datagram_tag &&
+       (data[2] & data[3] & data[4] & data[5]) == 0xff) {
+      /* The sender is done with the datagram */
+      acked = 1;
+    }
+    packetbuf_clear();
+    memcpy(packetbuf_dataptr(), data, loop[loop_tail].len);
+    packetbuf_set_datalen(loop[loop_tail].len);
+    packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &loop[loop_tail].from);
+    packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &linkaddr_node_addr);
+    loop_tail = (loop_tail + 1) % LOOP_LEN;
+    NETSTACK_NETWORK.input();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* 6LoWPAN delivers the reassembled datagrams here */
+void
+__wrap_tcpip_input(void)
+{
+  uint16_t id;
+  int i;
+
+  id = UIP_UDP_PAYLOAD[0] << 8 | UIP_UDP_PAYLOAD[1];
+  if(uip_len != UIP_IPH_LEN + UIP_UDPH_LEN + PAYLOAD_LEN ||
+     UIP_IP_BUF->proto != UIP_PROTO_UDP ||
+     id >= sizeof(delivered) || delivered[id]) {
+    phase->broken++;
+    uip_clear_buf();
+    return;
+  }
+  for(i = 2; i < PAYLOAD_LEN; i++) {
+    if(UIP_UDP_PAYLOAD[i] != ((id + i) & 0xff)) {
+      phase->broken++;
+      uip_clear_buf();
+      return;
+    }
+  }
+  delivered[id] = 1;
+  phase->delivered++;
+  uip_clear_buf();
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_datagram(uint16_t id)
+{
+  int i;
+
+  memset(uip_buf, 0, UIP_LLH_LEN + UIP_IPH_LEN + UIP_UDPH_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->len[0] = (UIP_UDPH_LEN + PAYLOAD_LEN) >> 8;
+  UIP_IP_BUF->len[1] = (UIP_UDPH_LEN + PAYLOAD_LEN) & 0xff;
+  UIP_IP_BUF->proto = UIP_PROTO_UDP;
+  UIP_IP_BUF->ttl = 64;
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&UIP_IP_BUF->srcipaddr, &uip_lladdr);
+  uip_ip6addr(&UIP_IP_BUF->destipaddr, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&UIP_IP_BUF->destipaddr, (uip_lladdr_t *)&peer);
+  UIP_UDP_BUF->srcport = UIP_HTONS(5678);
+  UIP_UDP_BUF->destport = UIP_HTONS(8765);
+  UIP_UDP_BUF->udplen = UIP_HTONS(UIP_UDPH_LEN + PAYLOAD_LEN);
+  UIP_UDP_PAYLOAD[0] = id >> 8;
+  UIP_UDP_PAYLOAD[1] = id & 0xff;
+  for(i = 2; i < PAYLOAD_LEN; i++) {
+    UIP_UDP_PAYLOAD[i] = id + i;
+  }
+  uip_len = UIP_IPH_LEN + UIP_UDPH_LEN + PAYLOAD_LEN;
+  uip_ext_len = 0;
+  tcpip_output((uip_lladdr_t *)&peer);
+  uip_clear_buf();
+}
+/*---------------------------------------------------------------------------*/
+/* Payload bytes delivered per 100 bytes on the air */
+static unsigned
+goodput(unsigned datagrams, uint32_t bytes)
+{
+  return bytes == 0 ? 0 : (unsigned)((uint32_t)datagrams * PAYLOAD_LEN * 100 / bytes);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(frag_recovery_process, ev, data)
+{
+  static clock_time_t start;
+  static int i;
+  int failed;
+
+  PROCESS_BEGIN();
+
+  test_rdc_set_hook(link_hook);
+  memset(&peer, 0x02, sizeof(peer));
+  datagram_tag = -1;
+
+  for(phase = phases; phase < phases + NUM_PHASES; phase++) {
+    for(i = 0; i < phase->datagrams; i++) {
+      datagram_fatal = phase->fatal && i == 0;
+      acked = 0;
+      send_datagram(datagram_id++);
+      start = clock_time();
+      while(!acked && clock_time() - start < GIVE_UP_TIME) {
+        WAIT(1);
+        deliver();
+      }
+    }
+    end_datagram();
+  }
+
+  failed = 0;
+  for(phase = phases; phase < phases + NUM_PHASES; phase++) {
+    printf("%s: %u/%u datagrams delivered, %u without recovery, "
+           "%u fragments, %u sent again, %u RFRAG-ACKs, %u frames lost\n",
+           phase->name, phase->delivered, phase->datagrams, phase->intact,
+           phase->fragments, phase->resent, phase->acks, phase->lost);
+    printf("%s: goodput %u%% with recovery, %u%% with RFC 4944 fragments\n",
+           phase->name, goodput(phase->delivered, phase->bytes),
+           goodput(phase->intact, phase->first_bytes));
+    if(phase->broken > 0 || phase->rfc4944 > 0) {
+      printf("%s: %u duplicate or corrupted datagrams, %u RFC 4944 fragments\n",
+             phase->name, phase->broken, phase->rfc4944);
+      failed = 1;
+    }
+    if(phase->fatal) {
+      /* The datagram is given up at once, the next one is recoverable */
+      if(phase->resent > 0 || phase->delivered != phase->datagrams - 1) {
+        printf("%s: failed fragment was not given up\n", phase->name);
+        failed = 1;
+      }
+    } else if(phase->loss_percent == 0) {
+      if(phase->delivered != phase->datagrams || phase->resent > 0 ||
+         phase->acks != phase->datagrams) {
+        printf("%s: needless recovery\n", phase->name);
+        failed = 1;
+      }
+    } else {
+      /* Only lost frames are sent again, and they are enough to
+         deliver more than RFC 4944 fragments would */
+      if(phase->resent > phase->lost ||
+         phase->delivered <= phase->intact ||
+         goodput(phase->delivered, phase->bytes) <=
+         goodput(phase->intact, phase->first_bytes) ||
+         (phase->loss_percent <= 10 && phase->delivered != phase->datagrams)) {
+        printf("%s: poor recovery\n", phase->name);
+        failed = 1;
+      }
+    }
+  }
+
+  printf(failed ? "TEST FAILED\n" : "TEST OK\n");
+  exit(failed);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         A radio duty cycling driver for native tests
+ */
+
+#include "contiki.h"
+#include "net/mac/mac.h"
+#include "net/packetbuf.h"
+#include "net/queuebuf.h"
+#include "lib/list.h"
+#include "test-rdc.h"
+
+/* 802.15.4 MAC header with long addresses, FCS and PHY header */
+#define FRAME_OVERHEAD 29
+
+/* 250 kbit/s */
+#define BYTES_PER_SECOND 31250
+
+static struct test_rdc_stats stats;
+static clock_time_t wakeup_time;
+static int max_burst;
+static test_rdc_hook_t hook;
+
+/*---------------------------------------------------------------------------*/
+static clock_time_t
+airtime(int len)
+{
+  return 1 + (clock_time_t)(len + FRAME_OVERHEAD) * CLOCK_SECOND /
+    BYTES_PER_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+static int
+report(mac_callback_t sent, void *ptr)
+{
+  int status;
+
+  status = hook != NULL ? hook() : MAC_TX_OK;
+  stats.frames++;
+  stats.bytes += packetbuf_totlen() + FRAME_OVERHEAD;
+  mac_call_sent_callback(sent, ptr, status, 1);
+  return status;
+}
+/*---------------------------------------------------------------------------*/
+static void
+occupy(clock_time_t duration)
+{
+  clock_time_t end;
+
+  /* Sends are synchronous, as with nullrdc and ContikiMAC */
+  end = clock_time() + duration;
+  while((long)(clock_time() - end) < 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *list)
+{
+  struct rdc_buf_list *next;
+  int frames;
+
+  if(list == NULL) {
+    return;
+  }
+
+  stats.calls++;
+  occupy(wakeup_time);
+  for(frames = 0; list != NULL; list = next) {
+    /* The callback frees list */
+    next = list_item_next(list);
+    queuebuf_to_packetbuf(list->buf);
+    occupy(airtime(packetbuf_totlen()));
+    if(report(sent, ptr) != MAC_TX_OK) {
+      /* A failed frame ends the burst */
+      break;
+    }
+    if(++frames == max_burst) {
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+send(mac_callback_t sent, void *ptr)
+{
+  stats.calls++;
+  report(sent, ptr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+input(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+static int
+on(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(int keep_radio_on)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
+channel_check_interval(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+void
+test_rdc_set_wakeup_time(clock_time_t t)
+{
+  wakeup_time = t;
+}
+/*---------------------------------------------------------------------------*/
+void
+test_rdc_set_max_burst(int frames)
+{
+  max_burst = frames;
+}
+/*---------------------------------------------------------------------------*/
+void
+test_rdc_set_hook(test_rdc_hook_t h)
+{
+  hook = h;
+}
+/*---------------------------------------------------------------------------*/
+const struct test_rdc_stats *
+test_rdc_get_stats(void)
+{
+  return &stats;
+}
+/*---------------------------------------------------------------------------*/
+const struct rdc_driver test_rdc_driver = {
+  "test-rdc",
+  init,
+  send,
+  send_list,
+  input,
+  on,
+  off,
+  channel_check_interval,
+};
+/*---------------------------------------------------------------------------*/
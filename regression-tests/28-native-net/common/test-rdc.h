@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         A radio duty cycling driver for native tests. Frames are not
+ *         sent anywhere: every call to send_list() blocks for a wake-up
+ *         time plus the air time of the frames it sends back to back, as
+ *         ContikiMAC does for a burst of frames with the frame pending
+ *         bit set. Each frame is reported as acknowledged once its air
+ *         time has passed, unless a test hook says otherwise.
+ */
+
+#ifndef TEST_RDC_H_
+#define TEST_RDC_H_
+
+#include "contiki.h"
+#include "net/mac/rdc.h"
+
+struct test_rdc_stats {
+  uint32_t calls;   /* send_list() calls that were served */
+  uint32_t frames;  /* frames put on the air */
+  uint32_t bytes;   /* bytes put on the air */
+};
+
+/**
+ * A hook that is called for every frame before it is reported, with
+ * the frame in the packetbuf. It returns the MAC_TX_ status to report.
+ */
+typedef int (* test_rdc_hook_t)(void);
+
+extern const struct rdc_driver test_rdc_driver;
+
+/** Time the receiver needs to be woken up, per send_list() call */
+void test_rdc_set_wakeup_time(clock_time_t t);
+
+/** Maximum number of frames sent per send_list() call, 0 for no limit */
+void test_rdc_set_max_burst(int frames);
+
+void test_rdc_set_hook(test_rdc_hook_t hook);
+
+const struct test_rdc_stats *test_rdc_get_stats(void);
+
+#endif /* TEST_RDC_H_ */
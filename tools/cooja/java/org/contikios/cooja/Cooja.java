@@ -265,6 +265,7 @@ public class Cooja extends Observable {
 
     "DEFAULT_PROJECTDIRS",
     "CORECOMM_TEMPLATE_FILENAME",
+    "DELTA_MEMORY_COPY",
 
     "PARSE_WITH_COMMAND",
 
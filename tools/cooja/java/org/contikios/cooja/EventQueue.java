@@ -30,14 +30,25 @@
 
 package org.contikios.cooja;
 
+import java.util.Arrays;
+
 /**
+ * Simulation event queue.
+ * <p>
+ * Events are kept in a binary heap ordered by execution time. Events with
+ * equal execution times are executed in the order they were added, so
+ * simulations replay deterministically.
+ *
  * @author Joakim Eriksson (ported to COOJA by Fredrik Osterlind)
  */
 public class EventQueue {
 
-  private TimeEvent first;
+  private TimeEvent[] heap = new TimeEvent[64];
   private int eventCount = 0;
 
+  /* Insertion counter, breaks ties between events with equal times */
+  private long nextOrder = 0;
+
   /**
    * Should only be called from simulation thread!
    *
@@ -45,41 +56,85 @@ public class EventQueue {
    * @param time Time
    */
   public void addEvent(TimeEvent event, long time) {
+    /* Check before the time changes: the heap is ordered by it */
+    if (event.queue != null && event.isScheduled) {
+      throw new IllegalStateException("Event is already scheduled: " + event);
+    }
     event.time = time;
     addEvent(event);
   }
 
   private void addEvent(TimeEvent event) {
     if (event.queue != null) {
-      if (event.isScheduled) {
-        throw new IllegalStateException("Event is already scheduled: " + event);
-      }
       removeFromQueue(event);
     }
 
-    if (first == null) {
-      first = event;
-    } else {
-      TimeEvent pos = first;
-      TimeEvent lastPos = first;
-      while (pos != null && pos.time <= event.time) {
-        lastPos = pos;
-        pos = pos.nextEvent;
-      }
-      // Here pos will be the first TE after event
-      // and lastPos the first before
-      if (pos == first) {
-        // Before all other
-        event.nextEvent = pos;
-        first = event;
-      } else {
-        event.nextEvent = pos;
-        lastPos.nextEvent = event;
-      }
+    if (eventCount == heap.length) {
+      heap = Arrays.copyOf(heap, 2 * heap.length);
     }
+    event.order = nextOrder++;
+    event.heapIndex = eventCount;
+    heap[eventCount++] = event;
+    siftUp(event.heapIndex);
+
     event.queue = this;
     event.isScheduled = true;
-    eventCount++;
+  }
+
+  private static boolean before(TimeEvent a, TimeEvent b) {
+    return a.time < b.time || (a.time == b.time && a.order < b.order);
+  }
+
+  private void place(TimeEvent event, int index) {
+    heap[index] = event;
+    event.heapIndex = index;
+  }
+
+  private void siftUp(int index) {
+    TimeEvent event = heap[index];
+    while (index > 0) {
+      int parent = (index - 1) >>> 1;
+      if (!before(event, heap[parent])) {
+        break;
+      }
+      place(heap[parent], index);
+      index = parent;
+    }
+    place(event, index);
+  }
+
+  private void siftDown(int index) {
+    TimeEvent event = heap[index];
+    int half = eventCount >>> 1;
+    while (index < half) {
+      int child = 2 * index + 1;
+      if (child + 1 < eventCount && before(heap[child + 1], heap[child])) {
+        child++;
+      }
+      if (!before(heap[child], event)) {
+        break;
+      }
+      place(heap[child], index);
+      index = child;
+    }
+    place(event, index);
+  }
+
+  /* Unlinks the event at the given heap position */
+  private void removeAt(int index) {
+    TimeEvent event = heap[index];
+    TimeEvent last = heap[--eventCount];
+    heap[eventCount] = null;
+    if (index < eventCount) {
+      place(last, index);
+      siftDown(index);
+      if (heap[index] == last) {
+        siftUp(index);
+      }
+    }
+
+    event.heapIndex = -1;
+    event.queue = null;
   }
 
   /**
@@ -89,30 +144,11 @@ public class EventQueue {
    * @return True if event was removed
    */
   private boolean removeFromQueue(TimeEvent event) {
-    TimeEvent pos = first;
-    TimeEvent lastPos = first;
-
-    while (pos != null && pos != event) {
-      lastPos = pos;
-      pos = pos.nextEvent;
-    }
-    if (pos == null) {
+    if (event.queue != this || event.heapIndex < 0) {
       return false;
     }
-    // pos == event!
-    if (pos == first) {
-      // remove it from first pos.
-      first = pos.nextEvent;
-    } else {
-      // else link prev to next...
-      lastPos.nextEvent = pos.nextEvent;
-    }
-    // unlink
-    pos.nextEvent = null;
-
-    event.queue = null;
+    removeAt(event.heapIndex);
     event.isScheduled = false;
-    eventCount--;
     return true;
   }
 
@@ -129,29 +165,31 @@ public class EventQueue {
    * @return Event
    */
   public TimeEvent popFirst() {
-    TimeEvent tmp = first;
-    if (tmp == null) {
-      return null;
-    }
-
-    first = tmp.nextEvent;
-    // Unlink.
-    tmp.nextEvent = null;
-
-    // No longer scheduled!
-    tmp.queue = null;
-    eventCount--;
-
-    if (!tmp.isScheduled) {
-      /* pop and return another event instead */
-      return popFirst();
+    while (eventCount > 0) {
+      TimeEvent tmp = heap[0];
+      removeAt(0);
+
+      /* Skip events removed while queued */
+      if (tmp.isScheduled) {
+        tmp.isScheduled = false;
+        return tmp;
+      }
     }
-    tmp.isScheduled = false;
-    return tmp;
+    return null;
   }
 
   public TimeEvent peekFirst() {
-    return first;
+    return eventCount > 0 ? heap[0] : null;
+  }
+
+  /**
+   * Returns all queued events, in no particular order. Events removed via
+   * TimeEvent.remove() may still be included until they are popped.
+   *
+   * @return Copy of the queued events
+   */
+  public TimeEvent[] getEvents() {
+    return Arrays.copyOf(heap, eventCount);
   }
 
   public String toString() {
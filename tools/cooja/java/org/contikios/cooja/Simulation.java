@@ -73,6 +73,7 @@ public class Simulation extends Observable implements Runnable {
 
   private long lastStartTime;
   private long currentSimulationTime = 0;
+  private long executedEvents = 0;
 
   private String title = null;
 
@@ -279,6 +280,7 @@ public class Simulation extends Observable implements Runnable {
         currentSimulationTime = nextEvent.time;
         /*logger.info("Executing event #" + EVENT_COUNTER++ + " @ " + currentSimulationTime + ": " + nextEvent);*/
         nextEvent.execute(currentSimulationTime);
+        executedEvents++;
 
         if (stopSimulation) {
           isRunning = false;
@@ -785,14 +787,12 @@ public class Simulation extends Observable implements Runnable {
 
         /* Loop through all scheduled events.
          * Delete all events associated with deleted mote. */
-        TimeEvent ev = eventQueue.peekFirst();
-        while (ev != null) {
+        for (TimeEvent ev: eventQueue.getEvents()) {
           if (ev instanceof MoteTimeEvent) {
             if (((MoteTimeEvent)ev).getMote() == mote) {
               ev.remove();
             }
           }
-          ev = ev.nextEvent;
         }
       }
     };
@@ -1088,6 +1088,15 @@ public class Simulation extends Observable implements Runnable {
     return currentSimulationTime / MILLISECOND;
   }
 
+  /**
+   * Returns the number of events executed by the simulation loop.
+   *
+   * @return Executed events
+   */
+  public long getExecutedEvents() {
+    return executedEvents;
+  }
+
   /**
    * Return the actual time value corresponding to an argument which
    * is a simulation time value in microseconds.
@@ -34,8 +34,9 @@ package org.contikios.cooja;
  * @author Joakim Eriksson (ported to COOJA by Fredrik Osterlind)
  */
 public abstract class TimeEvent {
-  TimeEvent nextEvent;
-  TimeEvent prevEvent;
+  /* Position in and insertion order of the event queue */
+  int heapIndex = -1;
+  long order;
 
   EventQueue queue = null;
   String name;
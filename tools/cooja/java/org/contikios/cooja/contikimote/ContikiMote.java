@@ -106,6 +106,12 @@ public class ContikiMote extends AbstractWakeupMote implements Mote {
     myMemory = memory;
   }
 
+  @Override
+  public void removed() {
+    super.removed();
+    myType.releaseCoreMemory(myMemory);
+  }
+
   @Override
   public MoteType getType() {
     return myType;
@@ -211,6 +211,12 @@ public class ContikiMoteType implements MoteType {
   // Initial memory for all motes of this type
   private SectionMoteMemory initialMemory = null;
 
+  // Mote memory last copied out of the Contiki system, if still in sync
+  private SectionMoteMemory coreMemoryOwner = null;
+
+  // Copy only Java-side writes into the Contiki system when it is in sync
+  private boolean deltaMemoryCopy = true;
+
   /** Offset between native (cooja) and contiki address space */
   long offset;
 
@@ -408,6 +414,7 @@ public class ContikiMoteType implements MoteType {
      * or output of command specified in external tools settings (e.g. nm -a )
      */
     boolean useCommand = Boolean.parseBoolean(Cooja.getExternalToolsSetting("PARSE_WITH_COMMAND", "false"));
+    deltaMemoryCopy = Boolean.parseBoolean(Cooja.getExternalToolsSetting("DELTA_MEMORY_COPY", "true"));
 
     SectionParser dataSecParser;
     SectionParser bssSecParser;
@@ -816,6 +823,23 @@ public class ContikiMoteType implements MoteType {
               (int) (section.getStartAddr() - offset),
               section.getTotalSize(),
               section.getMemory());
+      if (section instanceof ArrayMemory) {
+        ((ArrayMemory) section).clearDirty();
+      }
+    }
+    coreMemoryOwner = mem;
+  }
+
+  /**
+   * Forgets that the Contiki system holds the given memory, so that a removed
+   * mote's memory is not kept alive by this mote type.
+   *
+   * @param mem
+   *          Memory of the removed mote
+   */
+  public void releaseCoreMemory(SectionMoteMemory mem) {
+    if (coreMemoryOwner == mem) {
+      coreMemoryOwner = null;
     }
   }
 
@@ -826,16 +850,41 @@ public class ContikiMoteType implements MoteType {
   /**
    * Copy given memory to the Contiki system. This should not be used directly,
    * but instead via ContikiMote.setMemory().
+   * <p>
+   * If the Contiki system still holds the memory last fetched into mem by
+   * getCoreMemory(), i.e. no other mote of this type has executed since, only
+   * the byte ranges written on the Java side in the meantime are copied.
+   * Setting DELTA_MEMORY_COPY to false in the external tools settings always
+   * copies all memory, e.g. to compare simulation traces.
    *
    * @param mem
    * New memory
    */
   public void setCoreMemory(SectionMoteMemory mem) {
+    boolean inSync = deltaMemoryCopy && (mem == coreMemoryOwner);
+    /* The Contiki system is about to diverge; see getCoreMemory() */
+    coreMemoryOwner = null;
     for (MemoryInterface section : mem.getSections().values()) {
+      if (inSync && section instanceof ArrayMemory) {
+        ArrayMemory arrayMem = (ArrayMemory) section;
+        if (arrayMem.isDirty()) {
+          int start = arrayMem.getDirtyStart();
+          int end = arrayMem.getDirtyEnd();
+          setCoreMemory(
+                  (int) (section.getStartAddr() - offset) + start,
+                  end - start,
+                  Arrays.copyOfRange(section.getMemory(), start, end));
+          arrayMem.clearDirty();
+        }
+        continue;
+      }
       setCoreMemory(
               (int) (section.getStartAddr() - offset),
               section.getTotalSize(),
               section.getMemory());
+      if (section instanceof ArrayMemory) {
+        ((ArrayMemory) section).clearDirty();
+      }
     }
   }
 
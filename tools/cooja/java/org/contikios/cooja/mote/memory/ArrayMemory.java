@@ -45,6 +45,10 @@ public class ArrayMemory implements MemoryInterface {
   private final boolean readonly;
   private final Map<String, Symbol> symbols;// XXX Allow to set symbols
 
+  /* Byte range [dirtyStart, dirtyEnd) written since the last clearDirty() */
+  private int dirtyStart = Integer.MAX_VALUE;
+  private int dirtyEnd = 0;
+
   public ArrayMemory(long address, int size, MemoryLayout layout, Map<String, Symbol> symbols) {
     this(address, layout, new byte[size], symbols);
   }
@@ -85,12 +89,57 @@ public class ArrayMemory implements MemoryInterface {
     if (readonly) {
       throw new MoteMemoryException("Invalid write access for readonly memory");
     }
-    System.arraycopy(data, 0, memory, (int) (addr - startAddress), data.length);
+    int offset = (int) (addr - startAddress);
+    System.arraycopy(data, 0, memory, offset, data.length);
+    markDirty(offset, data.length);
   }
 
   @Override
   public void clearMemory() {
     Arrays.fill(memory, (byte) 0x00);
+    markDirty(0, memory.length);
+  }
+
+  private void markDirty(int offset, int size) {
+    if (offset < dirtyStart) {
+      dirtyStart = offset;
+    }
+    if (offset + size > dirtyEnd) {
+      dirtyEnd = offset + size;
+    }
+  }
+
+  /**
+   * Returns whether this memory was written through setMemorySegment() or
+   * clearMemory() since the last call to clearDirty().
+   * Writes made directly to the array returned by getMemory() are not tracked.
+   *
+   * @return True if memory was written
+   */
+  public boolean isDirty() {
+    return dirtyEnd > dirtyStart;
+  }
+
+  /**
+   * @return Offset of the first written byte, relative to the start address
+   */
+  public int getDirtyStart() {
+    return dirtyStart;
+  }
+
+  /**
+   * @return Offset just past the last written byte, relative to the start address
+   */
+  public int getDirtyEnd() {
+    return dirtyEnd;
+  }
+
+  /**
+   * Forgets all tracked writes, e.g. after the memory has been synchronized.
+   */
+  public void clearDirty() {
+    dirtyStart = Integer.MAX_VALUE;
+    dirtyEnd = 0;
   }
 
   @Override
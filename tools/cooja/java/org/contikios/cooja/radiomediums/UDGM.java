@@ -32,9 +32,14 @@ package org.contikios.cooja.radiomediums;
 
 import java.util.ArrayList;
 import java.util.Collection;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.HashMap;
+import java.util.LinkedHashSet;
 import java.util.Observable;
 import java.util.Observer;
 import java.util.Random;
+import java.util.Set;
 
 import org.apache.log4j.Logger;
 import org.jdom.Element;
@@ -87,61 +92,51 @@ public class UDGM extends AbstractRadioMedium {
   public double TRANSMITTING_RANGE = 50; /* Transmission range. */
   public double INTERFERENCE_RANGE = 100; /* Interference range. Ignored if below transmission range. */
 
-  private DirectedGraphMedium dgrm; /* Used only for efficient destination lookup */
+  /*
+   * Potential destinations are looked up in a uniform grid over the radio
+   * positions. Cells are a little wider than the largest range, so every radio within
+   * reach of a source is in the source's cell or one of the eight cells
+   * around it. The grid is updated lazily from the simulation thread.
+   */
+  private HashMap<Long, ArrayList<Radio>> grid = new HashMap<Long, ArrayList<Radio>>();
+  private HashMap<Radio, Long> gridCells = new HashMap<Radio, Long>();
+  private HashMap<Radio, Integer> radioOrder = new HashMap<Radio, Integer>();
+  private HashMap<Radio, Radio[]> destinations = new HashMap<Radio, Radio[]>();
+  private double gridRange = -1;
+  private double gridCellSize = 1;
+  private volatile boolean gridDirty = true;
+  private final Set<Radio> movedRadios =
+    Collections.synchronizedSet(new LinkedHashSet<Radio>());
 
   private Random random = null;
 
   public UDGM(Simulation simulation) {
     super(simulation);
     random = simulation.getRandomGenerator();
-    dgrm = new DirectedGraphMedium() {
-      protected void analyzeEdges() {
-        /* Create edges according to distances.
-         * XXX May be slow for mobile networks */
-        clearEdges();
-        for (Radio source: UDGM.this.getRegisteredRadios()) {
-          Position sourcePos = source.getPosition();
-          for (Radio dest: UDGM.this.getRegisteredRadios()) {
-            Position destPos = dest.getPosition();
-            /* Ignore ourselves */
-            if (source == dest) {
-              continue;
-            }
-            double distance = sourcePos.getDistanceTo(destPos);
-            if (distance < Math.max(TRANSMITTING_RANGE, INTERFERENCE_RANGE)) {
-              /* Add potential destination */
-              addEdge(
-                  new DirectedGraphMedium.Edge(source, 
-                      new DGRMDestinationRadio(dest)));
-            }
-          }
-        }
-        super.analyzeEdges();
-      }
-    };
 
     /* Register as position observer.
-     * If any positions change, re-analyze potential receivers. */
+     * If a position changes, update that radio in the grid. */
     final Observer positionObserver = new Observer() {
       public void update(Observable o, Object arg) {
-        dgrm.requestEdgeAnalysis();
+        if (arg instanceof Mote && ((Mote) arg).getInterfaces().getRadio() != null) {
+          movedRadios.add(((Mote) arg).getInterfaces().getRadio());
+        } else {
+          gridDirty = true;
+        }
       }
     };
-    /* Re-analyze potential receivers if radios are added/removed. */
+    /* Observe positions of added motes */
     simulation.getEventCentral().addMoteCountListener(new MoteCountListener() {
       public void moteWasAdded(Mote mote) {
         mote.getInterfaces().getPosition().addObserver(positionObserver);
-        dgrm.requestEdgeAnalysis();
       }
       public void moteWasRemoved(Mote mote) {
         mote.getInterfaces().getPosition().deleteObserver(positionObserver);
-        dgrm.requestEdgeAnalysis();
       }
     });
     for (Mote mote: simulation.getMotes()) {
       mote.getInterfaces().getPosition().addObserver(positionObserver);
     }
-    dgrm.requestEdgeAnalysis();
 
     /* Register visualizer skin */
     Visualizer.registerVisualizerSkin(UDGMVisualizerSkin.class);
@@ -155,12 +150,165 @@ public class UDGM extends AbstractRadioMedium {
   
   public void setTxRange(double r) {
     TRANSMITTING_RANGE = r;
-    dgrm.requestEdgeAnalysis();
+    gridDirty = true;
   }
 
   public void setInterferenceRange(double r) {
     INTERFERENCE_RANGE = r;
-    dgrm.requestEdgeAnalysis();
+    gridDirty = true;
+  }
+
+  public void registerRadioInterface(Radio radio, Simulation sim) {
+    super.registerRadioInterface(radio, sim);
+    gridDirty = true;
+  }
+
+  public void unregisterRadioInterface(Radio radio, Simulation sim) {
+    super.unregisterRadioInterface(radio, sim);
+    gridDirty = true;
+  }
+
+  private long getCell(Radio radio) {
+    Position pos = radio.getPosition();
+    return getCell(
+        (int) Math.floor(pos.getXCoordinate() / gridCellSize),
+        (int) Math.floor(pos.getYCoordinate() / gridCellSize));
+  }
+
+  private static long getCell(long x, long y) {
+    return (x << 32) | (y & 0xFFFFFFFFL);
+  }
+
+  private void addToGrid(Radio radio, long cell) {
+    ArrayList<Radio> radios = grid.get(cell);
+    if (radios == null) {
+      radios = new ArrayList<Radio>();
+      grid.put(cell, radios);
+    }
+    radios.add(radio);
+    gridCells.put(radio, cell);
+  }
+
+  /* Forgets cached destinations of all radios in and around the given cell */
+  private void invalidateAround(long cell) {
+    int cx = (int) (cell >> 32);
+    int cy = (int) cell;
+    for (long x = (long) cx - 1; x <= (long) cx + 1; x++) {
+      for (long y = (long) cy - 1; y <= (long) cy + 1; y++) {
+        ArrayList<Radio> radios = grid.get(getCell(x, y));
+        if (radios == null) {
+          continue;
+        }
+        for (Radio r: radios) {
+          destinations.remove(r);
+        }
+      }
+    }
+  }
+
+  private void updateGrid() {
+    double range = Math.max(TRANSMITTING_RANGE, INTERFERENCE_RANGE);
+    if (gridDirty || range != gridRange) {
+      gridDirty = false;
+      movedRadios.clear();
+      grid.clear();
+      gridCells.clear();
+      radioOrder.clear();
+      destinations.clear();
+      gridRange = range;
+      /* Slightly wider than the range, so that rounding in getCell() cannot
+       * put two radios within range of each other two cells apart */
+      gridCellSize = range > 0 ? range * 1.001 : 1;
+
+      Radio[] radios = getRegisteredRadios();
+      for (int i = 0; i < radios.length; i++) {
+        radioOrder.put(radios[i], i);
+        addToGrid(radios[i], getCell(radios[i]));
+      }
+      return;
+    }
+
+    if (movedRadios.isEmpty()) {
+      return;
+    }
+    Radio[] moved;
+    synchronized (movedRadios) {
+      moved = movedRadios.toArray(new Radio[0]);
+      movedRadios.clear();
+    }
+    for (Radio radio: moved) {
+      Long oldCell = gridCells.get(radio);
+      if (oldCell == null) {
+        /* Not registered with this radio medium */
+        continue;
+      }
+      long newCell = getCell(radio);
+      invalidateAround(oldCell);
+      if (newCell != oldCell) {
+        ArrayList<Radio> radios = grid.get(oldCell);
+        radios.remove(radio);
+        if (radios.isEmpty()) {
+          grid.remove(oldCell);
+        }
+        addToGrid(radio, newCell);
+        invalidateAround(newCell);
+      }
+    }
+  }
+
+  /**
+   * Returns all radios within transmission or interference range of the
+   * given radio, in registration order.
+   * Does not consider radio channels, transmission success ratios etc.
+   *
+   * @param source Source radio
+   * @return Potential destination radios
+   */
+  public Radio[] getPotentialDestinations(Radio source) {
+    updateGrid();
+
+    Radio[] dests = destinations.get(source);
+    if (dests != null) {
+      return dests;
+    }
+    Long cell = gridCells.get(source);
+    if (cell == null) {
+      return new Radio[0];
+    }
+
+    double range = Math.max(TRANSMITTING_RANGE, INTERFERENCE_RANGE);
+    Position sourcePos = source.getPosition();
+    ArrayList<Radio> found = new ArrayList<Radio>();
+    int cx = (int) (cell >> 32);
+    int cy = (int) cell.longValue();
+    for (long x = (long) cx - 1; x <= (long) cx + 1; x++) {
+      for (long y = (long) cy - 1; y <= (long) cy + 1; y++) {
+        ArrayList<Radio> radios = grid.get(getCell(x, y));
+        if (radios == null) {
+          continue;
+        }
+        for (Radio dest: radios) {
+          /* Ignore ourselves */
+          if (dest == source) {
+            continue;
+          }
+          if (sourcePos.getDistanceTo(dest.getPosition()) < range) {
+            found.add(dest);
+          }
+        }
+      }
+    }
+
+    /* Keep registration order: connection setup draws random numbers per
+     * destination, so this order matters for reproducible simulations */
+    Collections.sort(found, new Comparator<Radio>() {
+      public int compare(Radio a, Radio b) {
+        return radioOrder.get(a) - radioOrder.get(b);
+      }
+    });
+    dests = found.toArray(new Radio[0]);
+    destinations.put(source, dests);
+    return dests;
   }
 
   public RadioConnection createConnections(Radio sender) {
@@ -178,15 +326,11 @@ public class UDGM extends AbstractRadioMedium {
     * ((double) sender.getCurrentOutputPowerIndicator() / (double) sender.getOutputPowerIndicatorMax());
 
     /* Get all potential destination radios */
-    DestinationRadio[] potentialDestinations = dgrm.getPotentialDestinations(sender);
-    if (potentialDestinations == null) {
-      return newConnection;
-    }
+    Radio[] potentialDestinations = getPotentialDestinations(sender);
 
     /* Loop through all potential destinations */
     Position senderPos = sender.getPosition();
-    for (DestinationRadio dest: potentialDestinations) {
-      Radio recv = dest.radio;
+    for (Radio recv: potentialDestinations) {
 
       /* Fail if radios are on different (but configured) channels */ 
       if (sender.getChannel() >= 0 &&